@@ -33,7 +33,7 @@ public:
   typedef std::tr1::unordered_map<
     Key, std::pair<Value, typename list::iterator> > map;
 
-  explicit cache(int _capacity) : capacity(_capacity) {}
+  explicit cache(size_t _capacity) : capacity(_capacity) {}
 
   void put(const Key& key, const Value& value)
   {
@@ -102,7 +102,7 @@ private:
   }
 
   // Size of the cache.
-  int capacity;
+  size_t capacity;
 
   // Cache of values and "pointers" into the least-recently used list.
   map values;
@@ -6,6 +6,7 @@
 
 #include <tr1/functional>
 
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 #include <stout/error.hpp>
 #include <stout/try.hpp>
@@ -50,6 +51,13 @@ inline Try<Duration> parse(const std::string& value)
   return Duration::parse(value);
 }
 
+
+template <>
+inline Try<Bytes> parse(const std::string& value)
+{
+  return Bytes::parse(value);
+}
+
 } // namespace flags {
 
 #endif // __STOUT_FLAGS_PARSE_HPP__
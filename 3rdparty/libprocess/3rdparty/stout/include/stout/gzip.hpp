@@ -11,7 +11,7 @@
 #include "try.hpp"
 
 // Compression utilities.
-// TODO(bmahler): Provide streaming compression / decompression as well.
+// TODO(bmahler): Provide streaming decompression as well.
 namespace gzip {
 
 // We use a 16KB buffer with zlib compression / decompression.
@@ -144,6 +144,117 @@ inline Try<std::string> decompress(const std::string& compressed)
 #endif // HAVE_LIBZ
 }
 
+
+// Provides streaming gzip compression. The output of each call to
+// 'compress' is flushed (i.e., the receiver can decompress it without
+// waiting for more input) and 'finish' returns any remaining output
+// (e.g., the gzip trailer). The concatenation of the outputs is a
+// single gzip stream that can be passed to 'decompress' above.
+class Compressor
+{
+public:
+  explicit Compressor(int level = -1)
+    : initialized(false), finished(false)
+  {
+#ifdef HAVE_LIBZ
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+
+    if (level == Z_DEFAULT_COMPRESSION ||
+        (level >= Z_NO_COMPRESSION && level <= Z_BEST_COMPRESSION)) {
+      initialized = deflateInit2(
+          &stream,
+          level,          // Compression level.
+          Z_DEFLATED,     // Compression method.
+          MAX_WBITS + 16, // Zlib magic for gzip compression / decompression.
+          8,              // Default memLevel value.
+          Z_DEFAULT_STRATEGY) == Z_OK;
+    }
+#endif // HAVE_LIBZ
+  }
+
+  ~Compressor()
+  {
+#ifdef HAVE_LIBZ
+    if (initialized) {
+      deflateEnd(&stream);
+    }
+#endif // HAVE_LIBZ
+  }
+
+  // Returns the compressed (and flushed) output for the input.
+  Try<std::string> compress(const std::string& decompressed)
+  {
+#ifndef HAVE_LIBZ
+    return Error("libz is not available");
+#else
+    return _compress(decompressed, Z_SYNC_FLUSH);
+#endif // HAVE_LIBZ
+  }
+
+  // Returns the remaining output, after which this compressor can no
+  // longer be used.
+  Try<std::string> finish()
+  {
+#ifndef HAVE_LIBZ
+    return Error("libz is not available");
+#else
+    Try<std::string> result = _compress("", Z_FINISH);
+    finished = true;
+    return result;
+#endif // HAVE_LIBZ
+  }
+
+private:
+  // Not copyable, not assignable.
+  Compressor(const Compressor&);
+  Compressor& operator = (const Compressor&);
+
+#ifdef HAVE_LIBZ
+  Try<std::string> _compress(const std::string& decompressed, int flush)
+  {
+    if (!initialized) {
+      return Error("Failed to initialize zlib");
+    } else if (finished) {
+      return Error("Compression has already finished");
+    }
+
+    stream.next_in =
+      const_cast<Bytef*>(reinterpret_cast<const Bytef*>(decompressed.data()));
+    stream.avail_in = decompressed.length();
+
+    // Keep deflating until zlib no longer fills the entire buffer,
+    // at which point all of the (flushed) output has been consumed.
+    Bytef buffer[GZIP_BUFFER_SIZE];
+    std::string result = "";
+    do {
+      stream.next_out = buffer;
+      stream.avail_out = GZIP_BUFFER_SIZE;
+      int code = ::deflate(&stream, flush);
+
+      // NOTE: Z_BUF_ERROR just means no progress was possible (e.g.,
+      // flushing without any new input) and is not fatal.
+      if (code != Z_OK && code != Z_STREAM_END && code != Z_BUF_ERROR) {
+        finished = true;
+        return Error(stream.msg != NULL ? stream.msg : "Failed to deflate");
+      }
+
+      result.append(
+          reinterpret_cast<char*>(buffer),
+          GZIP_BUFFER_SIZE - stream.avail_out);
+    } while (stream.avail_out == 0);
+
+    return result;
+  }
+
+  z_stream_s stream;
+#endif // HAVE_LIBZ
+
+  bool initialized;
+  bool finished;
+};
+
 } // namespace gzip {
 
 #endif // __STOUT_GZIP_HPP__
@@ -1,6 +1,8 @@
 #ifndef __STOUT_JSON__
 #define __STOUT_JSON__
 
+#include <stdlib.h>
+
 #include <iomanip>
 #include <iostream>
 #include <list>
@@ -9,9 +11,10 @@
 
 #include <boost/variant.hpp>
 
+#include <stout/error.hpp>
 #include <stout/foreach.hpp>
-
-// TODO(jsirois): Implement parsing that constructs JSON objects.
+#include <stout/stringify.hpp>
+#include <stout/try.hpp>
 
 
 namespace JSON {
@@ -197,6 +200,260 @@ inline std::ostream& operator<<(std::ostream& out, const JSON::Value& value)
   return out;
 }
 
+
+// Implementation of parsing JSON text into the objects defined above
+// (see RFC4627). This is a straightforward recursive descent parser,
+// it is meant for consuming the output of the renderer above (e.g.,
+// in tests) rather than for speed.
+
+namespace internal {
+
+class Parser
+{
+public:
+  Parser(const std::string& _s) : s(_s), index(0) {}
+
+  Try<Value> parse()
+  {
+    Try<Value> value = parseValue();
+    if (value.isError()) {
+      return value;
+    }
+
+    skip();
+
+    if (index != s.size()) {
+      return error("Unexpected trailing characters");
+    }
+
+    return value;
+  }
+
+private:
+  Error error(const std::string& message) const
+  {
+    return Error(message + " at offset " + stringify(index));
+  }
+
+  void skip()
+  {
+    while (index < s.size() &&
+           (s[index] == ' ' || s[index] == '\t' ||
+            s[index] == '\n' || s[index] == '\r')) {
+      index++;
+    }
+  }
+
+  bool consume(const std::string& token)
+  {
+    if (s.compare(index, token.size(), token) == 0) {
+      index += token.size();
+      return true;
+    }
+    return false;
+  }
+
+  Try<Value> parseValue()
+  {
+    skip();
+
+    if (index == s.size()) {
+      return error("Unexpected end of input");
+    }
+
+    switch (s[index]) {
+      case '{': return parseObject();
+      case '[': return parseArray();
+      case '"': {
+        Try<std::string> string = parseString();
+        if (string.isError()) {
+          return Error(string.error());
+        }
+        return Value(String(string.get()));
+      }
+      default:
+        break;
+    }
+
+    if (consume("true")) {
+      return Value(True());
+    } else if (consume("false")) {
+      return Value(False());
+    } else if (consume("null")) {
+      return Value(Null());
+    }
+
+    return parseNumber();
+  }
+
+  Try<Value> parseObject()
+  {
+    Object object;
+
+    index++; // Skip '{'.
+    skip();
+
+    if (consume("}")) {
+      return Value(object);
+    }
+
+    while (true) {
+      skip();
+
+      if (index == s.size() || s[index] != '"') {
+        return error("Expecting a string for an object key");
+      }
+
+      Try<std::string> key = parseString();
+      if (key.isError()) {
+        return Error(key.error());
+      }
+
+      skip();
+
+      if (!consume(":")) {
+        return error("Expecting ':'");
+      }
+
+      Try<Value> value = parseValue();
+      if (value.isError()) {
+        return value;
+      }
+
+      object.values[key.get()] = value.get();
+
+      skip();
+
+      if (consume("}")) {
+        return Value(object);
+      } else if (!consume(",")) {
+        return error("Expecting ',' or '}'");
+      }
+    }
+  }
+
+  Try<Value> parseArray()
+  {
+    Array array;
+
+    index++; // Skip '['.
+    skip();
+
+    if (consume("]")) {
+      return Value(array);
+    }
+
+    while (true) {
+      Try<Value> value = parseValue();
+      if (value.isError()) {
+        return value;
+      }
+
+      array.values.push_back(value.get());
+
+      skip();
+
+      if (consume("]")) {
+        return Value(array);
+      } else if (!consume(",")) {
+        return error("Expecting ',' or ']'");
+      }
+    }
+  }
+
+  Try<std::string> parseString()
+  {
+    std::string string;
+
+    index++; // Skip the opening '"'.
+
+    while (index < s.size()) {
+      char c = s[index++];
+
+      if (c == '"') {
+        return string;
+      } else if (c != '\\') {
+        string += c;
+        continue;
+      }
+
+      if (index == s.size()) {
+        break;
+      }
+
+      switch (s[index++]) {
+        case '"':  string += '"';  break;
+        case '\\': string += '\\'; break;
+        case '/':  string += '/';  break;
+        case 'b':  string += '\b'; break;
+        case 'f':  string += '\f'; break;
+        case 'n':  string += '\n'; break;
+        case 'r':  string += '\r'; break;
+        case 't':  string += '\t'; break;
+        case 'u': {
+          if (index + 4 > s.size()) {
+            return error("Truncated unicode escape");
+          }
+
+          const std::string hex = s.substr(index, 4);
+          char* end = NULL;
+          unsigned long code = ::strtoul(hex.c_str(), &end, 16);
+          if (end != hex.c_str() + 4) {
+            return error("Invalid unicode escape");
+          }
+          index += 4;
+
+          // NOTE: The renderer above encodes every byte > 0x7F as
+          // \u00XX, so we decode those back into a single byte
+          // (rather than UTF-8) in order to round trip its output.
+          if (code < 0x100) {
+            string += (char) code;
+          } else if (code < 0x800) {
+            string += (char) (0xC0 | (code >> 6));
+            string += (char) (0x80 | (code & 0x3F));
+          } else {
+            string += (char) (0xE0 | (code >> 12));
+            string += (char) (0x80 | ((code >> 6) & 0x3F));
+            string += (char) (0x80 | (code & 0x3F));
+          }
+          break;
+        }
+        default:
+          return error("Invalid escape");
+      }
+    }
+
+    return error("Unterminated string");
+  }
+
+  Try<Value> parseNumber()
+  {
+    const char* start = s.c_str() + index;
+    char* end = NULL;
+
+    double number = ::strtod(start, &end);
+
+    if (end == start) {
+      return error("Unexpected character '" + s.substr(index, 1) + "'");
+    }
+
+    index += end - start;
+
+    return Value(Number(number));
+  }
+
+  const std::string& s;
+  size_t index;
+};
+
+} // namespace internal {
+
+
+inline Try<Value> parse(const std::string& s)
+{
+  return internal::Parser(s).parse();
+}
+
 } // namespace JSON {
 
 #endif // __STOUT_JSON__
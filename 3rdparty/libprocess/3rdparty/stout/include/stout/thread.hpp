@@ -8,9 +8,11 @@
 template <typename T>
 struct ThreadLocal
 {
-  ThreadLocal()
+  // The optional destructor gets invoked with each thread's (non
+  // NULL) value when the thread exits.
+  explicit ThreadLocal(void (*destructor)(void*) = NULL)
   {
-    if (pthread_key_create(&key, NULL) != 0) {
+    if (pthread_key_create(&key, destructor) != 0) {
       perror("Failed to create thread local, pthread_key_create");
       abort();
     }
@@ -2,6 +2,7 @@
 #define __STOUT_UUID_HPP__
 
 #include <assert.h>
+#include <pthread.h>
 
 #include <sstream>
 #include <string>
@@ -10,12 +11,35 @@
 #include <boost/uuid/uuid_io.hpp>
 #include <boost/uuid/uuid_generators.hpp>
 
+#include "thread.hpp"
+
 struct UUID : boost::uuids::uuid
 {
 public:
   static UUID random()
   {
-    return UUID(boost::uuids::random_generator()());
+    // Constructing a generator seeds it from the system's entropy
+    // sources which is expensive, so we keep a generator per thread
+    // (they're not thread safe) and reuse it. A thread's generator
+    // gets deleted when the thread exits.
+    static ThreadLocal<Generator>* generators =
+      new ThreadLocal<Generator>(&Generator::destroy);
+
+    // A forked child starts out with a copy of the generator of the
+    // thread that forked, so it would generate the same UUIDs as its
+    // parent unless it reseeds (see Generator::forked).
+    static const int atfork = pthread_atfork(NULL, NULL, &Generator::forked);
+    (void) atfork;
+
+    Generator* generator = *generators;
+
+    if (generator == NULL || generator->seeded != Generator::forks()) {
+      delete generator;
+      generator = new Generator();
+      *generators = generator;
+    }
+
+    return UUID(generator->generator());
   }
 
   static UUID fromBytes(const std::string& s)
@@ -49,6 +73,34 @@ public:
 private:
   explicit UUID(const boost::uuids::uuid& uuid)
     : boost::uuids::uuid(uuid) {}
+
+  // A random generator along with the number of forks this process
+  // was a result of when the generator got seeded.
+  struct Generator
+  {
+    Generator() : seeded(forks()) {}
+
+    // Number of forks this process is a result of.
+    static unsigned int& forks()
+    {
+      static unsigned int forks = 0;
+      return forks;
+    }
+
+    // Invoked in the child after a fork (see pthread_atfork).
+    static void forked()
+    {
+      forks()++;
+    }
+
+    static void destroy(void* generator)
+    {
+      delete reinterpret_cast<Generator*>(generator);
+    }
+
+    const unsigned int seeded;
+    boost::uuids::random_generator generator;
+  };
 };
 
 #endif // __STOUT_UUID_HPP__
@@ -50,4 +50,39 @@ TEST(GzipTest, CompressDecompressString)
   ASSERT_SOME(decompressed);
   ASSERT_EQ(s, decompressed.get());
 }
+
+
+TEST(GzipTest, StreamingCompression)
+{
+  string s =
+    "Lorem ipsum dolor sit amet, consectetur adipisicing elit, sed do "
+    "eiusmod tempor incididunt ut labore et dolore magna aliqua. Ut enim ad "
+    "minim veniam, quis nostrud exercitation ullamco laboris nisi ut "
+    "aliquip ex ea commodo consequat. Duis aute irure dolor in reprehenderit "
+    "in voluptate velit esse cillum dolore eu fugiat nulla pariatur. "
+    "Excepteur sint occaecat cupidatat non proident, sunt in culpa qui "
+    "officia deserunt mollit anim id est laborum.";
+
+  gzip::Compressor compressor;
+
+  // Compress the string in pieces, including an empty one.
+  string compressed = "";
+  for (size_t i = 0; i <= s.length(); i += 100) {
+    Try<string> output = compressor.compress(s.substr(i, 100));
+    ASSERT_SOME(output);
+    compressed += output.get();
+  }
+
+  Try<string> output = compressor.finish();
+  ASSERT_SOME(output);
+  compressed += output.get();
+
+  Try<string> decompressed = gzip::decompress(compressed);
+  ASSERT_SOME(decompressed);
+  ASSERT_EQ(s, decompressed.get());
+
+  // The compressor can not be used once finished.
+  ASSERT_ERROR(compressor.compress(s));
+  ASSERT_ERROR(compressor.finish());
+}
 #endif // HAVE_LIBZ
@@ -4,8 +4,10 @@
 
 #include <string>
 
+#include <stout/gtest.hpp>
 #include <stout/json.hpp>
 #include <stout/stringify.hpp>
+#include <stout/try.hpp>
 
 using std::string;
 
@@ -17,3 +19,38 @@ TEST(JsonTest, BinaryData)
   EXPECT_EQ("\"\\\"\\\\\\/\\b\\f\\n\\r\\t\\u0000\\u0019 !#[]\\u007F\\u00FF\"",
             stringify(s));
 }
+
+
+TEST(JsonTest, Parse)
+{
+  JSON::Object object;
+  object.values["string"] = "\"\\/\b\f\n\r\t\xFF";
+  object.values["number"] = 3.5;
+  object.values["true"] = JSON::True();
+  object.values["null"] = JSON::Null();
+
+  JSON::Array array;
+  array.values.push_back(1);
+  array.values.push_back(JSON::False());
+  array.values.push_back(JSON::Object());
+  object.values["array"] = array;
+
+  const string rendered = stringify(JSON::Value(object));
+
+  Try<JSON::Value> value = JSON::parse(" \n" + rendered + "\t");
+  ASSERT_SOME(value);
+  EXPECT_EQ(rendered, stringify(value.get()));
+
+  const JSON::Object parsed = boost::get<JSON::Object>(value.get());
+  EXPECT_EQ(5u, parsed.values.size());
+
+  const JSON::Value& number = parsed.values.find("number")->second;
+  EXPECT_EQ(3.5, boost::get<JSON::Number>(number).value);
+
+  EXPECT_ERROR(JSON::parse(""));
+  EXPECT_ERROR(JSON::parse("{\"a\":1"));
+  EXPECT_ERROR(JSON::parse("{\"a\" 1}"));
+  EXPECT_ERROR(JSON::parse("[1,]"));
+  EXPECT_ERROR(JSON::parse("\"unterminated"));
+  EXPECT_ERROR(JSON::parse("{} {}"));
+}
@@ -2,8 +2,12 @@
 
 #include <gmock/gmock.h>
 
+#include <sys/wait.h>
+#include <unistd.h>
+
 #include <string>
 
+#include <stout/stopwatch.hpp>
 #include <stout/uuid.hpp>
 
 using std::string;
@@ -35,3 +39,63 @@ TEST(UUIDTest, test)
   EXPECT_EQ(string2, string3);
   EXPECT_EQ(string1, string3);
 }
+
+
+TEST(UUIDTest, random)
+{
+  const int iterations = 100000;
+
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  UUID previous = UUID::random();
+  for (int i = 0; i < iterations; i++) {
+    UUID uuid = UUID::random();
+    ASSERT_NE(previous, uuid);
+    previous = uuid;
+  }
+
+  stopwatch.stop();
+
+  std::cout << "Generated " << iterations << " UUIDs in "
+            << stopwatch.elapsed() << std::endl;
+
+  // Make sure we generate version 4 (random) UUIDs.
+  EXPECT_EQ(boost::uuids::uuid::version_random_number_based,
+            previous.version());
+}
+
+
+TEST(UUIDTest, fork)
+{
+  // Make sure this thread has a seeded generator before forking.
+  UUID::random();
+
+  int pipes[2];
+  ASSERT_NE(-1, ::pipe(pipes));
+
+  pid_t pid = ::fork();
+  ASSERT_NE(-1, pid);
+
+  if (pid == 0) {
+    // In child process, send the parent the next UUID.
+    const string bytes = UUID::random().toBytes();
+    ::write(pipes[1], bytes.data(), bytes.size());
+    ::_exit(0);
+  }
+
+  // In parent process.
+  ::close(pipes[1]);
+
+  const string bytes = UUID::random().toBytes();
+
+  char buffer[16];
+  ASSERT_EQ((ssize_t) sizeof(buffer), ::read(pipes[0], buffer, sizeof(buffer)));
+  ::close(pipes[0]);
+
+  int status;
+  ASSERT_EQ(pid, ::waitpid(pid, &status, 0));
+
+  // The child must have reseeded its copy of our generator.
+  EXPECT_NE(bytes, string(buffer, sizeof(buffer)));
+}
@@ -1,121 +1,57 @@
 #ifndef __ASYNC_HPP__
 #define __ASYNC_HPP__
 
-#include <process/dispatch.hpp>
 #include <process/future.hpp>
-#include <process/id.hpp>
-#include <process/process.hpp>
 
 #include <tr1/functional>
+#include <tr1/memory>
 
 namespace process {
 
-// TODO(vinod): Merge this into ExecutorProcess.
-// TODO(vinod): Add support for void functions. Currently this is tricky,
-// because Future<void> is not supported.
-class AsyncExecutorProcess : public Process<AsyncExecutorProcess>
+// Priorities for functions executed via 'async' (see below), higher
+// priority functions get executed before any lower priority ones
+// that are still queued.
+enum AsyncPriority
 {
-private:
-  friend class AsyncExecutor;
-
-  AsyncExecutorProcess() : ProcessBase(ID::generate("__async_executor__")) {}
-  virtual ~AsyncExecutorProcess() {}
-
-  // Not copyable, not assignable.
-  AsyncExecutorProcess(const AsyncExecutorProcess&);
-  AsyncExecutorProcess& operator = (const AsyncExecutorProcess&);
-
-  template<typename F>
-  typename std::tr1::result_of<F(void)>::type execute(
-      const F& f)
-  {
-    terminate(self()); // Terminate this process after the function returns.
-    return f();
-  }
+  ASYNC_LOW,
+  ASYNC_NORMAL,
+  ASYNC_HIGH
+};
 
-  // TODO(vinod): Use boost macro enumerations.
-  template<typename F, typename A1>
-  typename std::tr1::result_of<F(A1)>::type execute(
-      const F& f, A1 a1)
-  {
-    terminate(self()); // Terminate this process after the function returns.
-    return f(a1);
-  }
 
-  template<typename F, typename A1, typename A2>
-  typename std::tr1::result_of<F(A1, A2)>::type execute(
-      const F& f, A1 a1, A2 a2)
-  {
-    terminate(self()); // Terminate this process after the function returns.
-    return f(a1, a2);
-  }
+namespace internal {
 
-  template<typename F, typename A1, typename A2, typename A3>
-  typename std::tr1::result_of<F(A1, A2, A3)>::type execute(
-      const F& f, A1 a1, A2 a2, A3 a3)
-  {
-    terminate(self()); // Terminate this process after the function returns.
-    return f(a1, a2, a3);
-  }
+// Queues the function to be executed on one of the threads dedicated
+// to blocking work (see LIBPROCESS_ASYNC_THREADS). The function
+// returns false if it was not actually executed (i.e., discarded).
+void async(
+    const std::tr1::function<bool(void)>& f,
+    AsyncPriority priority);
 
-  template<typename F, typename A1, typename A2, typename A3, typename A4>
-  typename std::tr1::result_of<F(A1, A2, A3, A4)>::type execute(
-      const F& f, A1 a1, A2 a2, A3 a3, A4 a4)
-  {
-    terminate(self()); // Terminate this process after the function returns.
-    return f(a1, a2, a3, a4);
-  }
-};
+} // namespace internal {
 
 
-// This is a wrapper around AsyncExecutorProcess.
+// Executes functions on a bounded pool of threads dedicated to
+// blocking work (e.g., filesystem operations), rather than on the
+// threads that run processes, so that blocking functions can't
+// starve processes. Functions are executed in priority order, and a
+// function that has not started executing yet can be cancelled by
+// discarding the returned future. The pool can be inspected at
+// '/__async__'.
+// TODO(vinod): Add support for void functions. Currently this is tricky,
+// because Future<void> is not supported.
 class AsyncExecutor
 {
-private:
-  // Declare async functions as friends.
-  template<typename F>
-  friend Future<typename std::tr1::result_of<F(void)>::type> async(
-      const F& f);
-
-  template<typename F, typename A1>
-  friend Future<typename std::tr1::result_of<F(A1)>::type> async(
-      const F& f, A1 a1);
-
-  template<typename F, typename A1, typename A2>
-  friend Future<typename std::tr1::result_of<F(A1, A2)>::type> async(
-      const F& f, A1 a1, A2 a2);
-
-  template<typename F, typename A1, typename A2, typename A3>
-  friend Future<typename std::tr1::result_of<F(A1, A2, A3)>::type> async(
-      const F& f, A1 a1, A2 a2, A3 a3);
-
-  template<typename F, typename A1, typename A2, typename A3, typename A4>
-  friend Future<typename std::tr1::result_of<F(A1, A2, A3, A4)>::type> async(
-      const F& f, A1 a1, A2 a2, A3 a3, A4 a4);
-
-  AsyncExecutor()
-  {
-    process = new AsyncExecutorProcess();
-    spawn(process, true); // Automatically GC.
-  }
-
-  virtual ~AsyncExecutor() {}
-
-  // Not copyable, not assignable.
-  AsyncExecutor(const AsyncExecutor&);
-  AsyncExecutor& operator = (const AsyncExecutor&);
+public:
+  explicit AsyncExecutor(AsyncPriority _priority = ASYNC_NORMAL)
+    : priority(_priority) {}
 
   template<typename F>
   Future<typename std::tr1::result_of<F(void)>::type> execute(
       const F& f)
   {
-    // Necessary to disambiguate.
-    typedef typename std::tr1::result_of<F(void)>::type
-        (AsyncExecutorProcess::*R)(const F&);
-
-    return dispatch(process,
-                    static_cast<R>(&AsyncExecutorProcess::execute),
-                    f);
+    typedef typename std::tr1::result_of<F(void)>::type R;
+    return _execute<R>(f);
   }
 
   // TODO(vinod): Use boost macro enumerations.
@@ -123,69 +59,69 @@ private:
   Future<typename std::tr1::result_of<F(A1)>::type> execute(
       const F& f, A1 a1)
   {
-    // Necessary to disambiguate.
-    typedef typename std::tr1::result_of<F(A1)>::type
-        (AsyncExecutorProcess::*R)(const F&, A1);
-
-    return dispatch(process,
-                    static_cast<R>(&AsyncExecutorProcess::execute),
-                    f,
-                    a1);
+    typedef typename std::tr1::result_of<F(A1)>::type R;
+    return _execute<R>(std::tr1::bind(f, a1));
   }
 
   template<typename F, typename A1, typename A2>
   Future<typename std::tr1::result_of<F(A1, A2)>::type> execute(
       const F& f, A1 a1, A2 a2)
   {
-    // Necessary to disambiguate.
-    typedef typename std::tr1::result_of<F(A1, A2)>::type
-        (AsyncExecutorProcess::*R)(const F&, A1, A2);
-
-    return dispatch(process,
-                    static_cast<R>(&AsyncExecutorProcess::execute),
-                    f,
-                    a1,
-                    a2);
+    typedef typename std::tr1::result_of<F(A1, A2)>::type R;
+    return _execute<R>(std::tr1::bind(f, a1, a2));
   }
 
   template<typename F, typename A1, typename A2, typename A3>
   Future<typename std::tr1::result_of<F(A1, A2, A3)>::type> execute(
       const F& f, A1 a1, A2 a2, A3 a3)
   {
-    // Necessary to disambiguate.
-    typedef typename std::tr1::result_of<F(A1, A2, A3)>::type
-        (AsyncExecutorProcess::*R)(const F&, A1, A2, A3);
-
-    return dispatch(process,
-                    static_cast<R>(&AsyncExecutorProcess::execute),
-                    f,
-                    a1,
-                    a2,
-                    a3);
+    typedef typename std::tr1::result_of<F(A1, A2, A3)>::type R;
+    return _execute<R>(std::tr1::bind(f, a1, a2, a3));
   }
 
   template<typename F, typename A1, typename A2, typename A3, typename A4>
   Future<typename std::tr1::result_of<F(A1, A2, A3, A4)>::type> execute(
       const F& f, A1 a1, A2 a2, A3 a3, A4 a4)
   {
-    // Necessary to disambiguate.
-    typedef typename std::tr1::result_of<F(A1, A2, A3, A4)>::type
-        (AsyncExecutorProcess::*R)(const F&, A1, A2, A3, A4);
-
-    return dispatch(process,
-                    static_cast<R>(&AsyncExecutorProcess::execute),
-                    f,
-                    a1,
-                    a2,
-                    a3,
-                    a4);
+    typedef typename std::tr1::result_of<F(A1, A2, A3, A4)>::type R;
+    return _execute<R>(std::tr1::bind(f, a1, a2, a3, a4));
+  }
+
+private:
+  template<typename R>
+  Future<R> _execute(const std::tr1::function<R(void)>& f)
+  {
+    std::tr1::shared_ptr<Promise<R> > promise(new Promise<R>());
+    Future<R> future = promise->future();
+
+    internal::async(
+        std::tr1::bind(&AsyncExecutor::__execute<R>, f, promise),
+        priority);
+
+    return future;
+  }
+
+  template<typename R>
+  static bool __execute(
+      const std::tr1::function<R(void)>& f,
+      const std::tr1::shared_ptr<Promise<R> >& promise)
+  {
+    // Don't bother executing the function if the future has already
+    // been discarded (i.e., the execution was cancelled).
+    if (promise->future().isDiscarded()) {
+      return false;
+    }
+
+    promise->set(f());
+    return true;
   }
 
-  AsyncExecutorProcess* process;
+  const AsyncPriority priority;
 };
 
 
-// Provides an abstraction for asynchronously executing a function.
+// Provides an abstraction for asynchronously executing a function
+// (with normal priority, see AsyncExecutor for other priorities).
 // TODO(vinod): Use boost macro to enumerate arguments/params.
 template<typename F>
 Future<typename std::tr1::result_of<F(void)>::type>
@@ -9,6 +9,8 @@
 #include <process/message.hpp>
 #include <process/socket.hpp>
 
+#include <stout/stopwatch.hpp>
+
 namespace process {
 
 // Forward declarations.
@@ -33,6 +35,8 @@ struct EventVisitor
 
 struct Event
 {
+  Event() : span(0) {}
+
   virtual ~Event() {}
 
   virtual void visit(EventVisitor* visitor) const = 0;
@@ -68,13 +72,23 @@ struct Event
     }
     return *result;
   }
+
+  // Started when the event gets enqueued (see ProcessBase::enqueue),
+  // used to determine how long the event waited in the mailbox.
+  Stopwatch stopwatch;
+
+  // Span used for tracing, or 0 if none (see src/tracer.hpp).
+  uint64_t span;
 };
 
 
 struct MessageEvent : Event
 {
   MessageEvent(Message* _message)
-    : message(_message) {}
+    : message(_message)
+  {
+    span = message->span;
+  }
 
   virtual ~MessageEvent()
   {
@@ -400,18 +400,37 @@ inline Try<std::string> decode(const std::string& s)
 }
 
 
-// Sends a blocking HTTP GET request to the process with the given upid.
-// Returns the HTTP response from the process, read asynchronously.
-//
-// TODO(bmahler): Have the request sent asynchronously as well.
-// TODO(bmahler): For efficiency, this should properly use the ResponseDecoder
-// on the read stream, rather than parsing the full string response at the end.
+// Asynchronously sends an HTTP GET request to the process with the
+// given upid and returns the response. Requests are sent over a pool
+// of persistent (keep-alive) connections to each node and GET
+// requests may be pipelined. The number of open connections is
+// bounded; requests beyond that are queued until a connection is
+// available.
 Future<Response> get(
     const UPID& upid,
     const std::string& path = "",
     const std::string& query = "");
 
 
+// Asynchronously sends an HTTP POST request with the optional body to
+// the process with the given upid and returns the response (see
+// 'get' above). Unlike GET requests, POST requests are never
+// pipelined behind other requests.
+Future<Response> post(
+    const UPID& upid,
+    const std::string& path = "",
+    const Option<std::string>& body = None(),
+    const Option<std::string>& contentType = None());
+
+
+// Asynchronously sends an HTTP PUT request (see 'post' above).
+Future<Response> put(
+    const UPID& upid,
+    const std::string& path = "",
+    const Option<std::string>& body = None(),
+    const Option<std::string>& contentType = None());
+
+
 // Status code reason strings, from the HTTP1.1 RFC:
 // http://www.w3.org/Protocols/rfc2616/rfc2616-sec6.html
 extern hashmap<uint16_t, std::string> statuses;
@@ -1,6 +1,8 @@
 #ifndef __PROCESS_MESSAGE_HPP__
 #define __PROCESS_MESSAGE_HPP__
 
+#include <stdint.h>
+
 #include <string>
 
 #include <process/pid.hpp>
@@ -9,10 +11,15 @@ namespace process {
 
 struct Message
 {
+  Message() : span(0) {}
+
   std::string name;
   UPID from;
   UPID to;
   std::string body;
+
+  // Span used for tracing, or 0 if none (see src/tracer.hpp).
+  uint64_t span;
 };
 
 } // namespace process {
@@ -175,6 +175,7 @@ private:
   friend class SocketManager;
   friend class ProcessManager;
   friend class ProcessReference;
+  friend class ProcessShard;
   friend void* schedule(void*);
 
   // Process states.
@@ -74,6 +74,8 @@ public:
   }
 
 private:
+  friend class Clock; // For Clock::now.
+
   Duration sinceEpoch;
 
   // Made it private to avoid the confusion between Time and Duration.
@@ -0,0 +1,424 @@
+#include <execinfo.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cxxabi.h>
+
+#include <sys/time.h>
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include <process/event.hpp>
+#include <process/message.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/json.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+#include <stout/thread.hpp>
+
+#include "accounting.hpp"
+#include "synchronized.hpp"
+
+using std::list;
+using std::string;
+using std::vector;
+
+namespace process {
+namespace accounting {
+
+bool enabled = false;
+
+// Every SAMPLE_INTERVAL events (per thread) get sampled, and the
+// most recent MAX_SAMPLES samples are kept.
+static const uint64_t SAMPLE_INTERVAL = 64;
+static const size_t MAX_SAMPLES = 4096;
+
+// Prefix of the key used for dispatches, followed by the canonical
+// "byte" representation of the method (see DispatchEvent).
+static const string DISPATCH = "dispatch ";
+
+
+struct Usage
+{
+  Usage() : count(0), waited(0), elapsed(0), cpu(0), max(0) {}
+
+  void record(
+      const Duration& _waited,
+      const Duration& _elapsed,
+      const Duration& _cpu)
+  {
+    count++;
+    waited += _waited.ns();
+    elapsed += _elapsed.ns();
+    cpu += _cpu.ns();
+    if (_elapsed.ns() > max) {
+      max = _elapsed.ns();
+    }
+  }
+
+  void merge(const Usage& that)
+  {
+    count += that.count;
+    waited += that.waited;
+    elapsed += that.elapsed;
+    cpu += that.cpu;
+    if (that.max > max) {
+      max = that.max;
+    }
+  }
+
+  JSON::Object json() const
+  {
+    JSON::Object object;
+    object.values["events"] = JSON::Number(count);
+    object.values["wait_time_us"] = JSON::Number(waited / 1000.0);
+    object.values["wall_time_us"] = JSON::Number(elapsed / 1000.0);
+    object.values["cpu_time_us"] = JSON::Number(cpu / 1000.0);
+    object.values["max_wall_time_us"] = JSON::Number(max / 1000.0);
+    return object;
+  }
+
+  // NOTE: Durations are kept in nanoseconds.
+  uint64_t count;
+  int64_t waited;
+  int64_t elapsed;
+  int64_t cpu;
+  int64_t max;
+};
+
+
+// Usage keyed by event (see 'key' below).
+typedef hashmap<string, Usage> Events;
+
+
+// A sampled event.
+struct Sample
+{
+  string id;
+  string key;
+  uint64_t thread;
+  int64_t start; // Microseconds since the epoch.
+  Duration waited;
+  Duration elapsed;
+  Duration cpu;
+};
+
+
+// Most recent samples, as a ring buffer.
+static vector<Sample>* samples = new vector<Sample>();
+static size_t next = 0;
+static synchronizable(samples) = SYNCHRONIZED_INITIALIZER;
+
+
+// The accounting done by a single thread, keyed by process and then
+// by event. Only the owning thread updates these, the lock is (only)
+// contended when merging.
+class Counters
+{
+public:
+  explicit Counters(uint64_t _thread) : thread(_thread), events(0)
+  {
+    synchronizer(this) = SYNCHRONIZED_INITIALIZER;
+  }
+
+  void record(
+      const string& id,
+      const string& key,
+      const Duration& waited,
+      const Duration& elapsed,
+      const Duration& cpu)
+  {
+    synchronized (this) {
+      processes[id][key].record(waited, elapsed, cpu);
+    }
+  }
+
+  // Merges these counters into the specified processes.
+  void merge(hashmap<string, Events>* merged)
+  {
+    synchronized (this) {
+      foreachpair (const string& id, const Events& events, processes) {
+        foreachpair (const string& key, const Usage& usage, events) {
+          (*merged)[id][key].merge(usage);
+        }
+      }
+    }
+  }
+
+  // Returns true if the next event should be sampled.
+  bool sample()
+  {
+    return (events++ % SAMPLE_INTERVAL) == 0;
+  }
+
+  const uint64_t thread;
+
+private:
+  hashmap<string, Events> processes;
+
+  uint64_t events; // Only used for sampling, thus not protected.
+
+  synchronizable(this);
+};
+
+
+// Counters of every thread that has recorded any accounting (these
+// are never deleted since libprocess threads live forever).
+static list<Counters*>* counters = new list<Counters*>();
+static synchronizable(counters) = SYNCHRONIZED_INITIALIZER;
+
+// Counters of the current thread.
+static ThreadLocal<Counters>* _counters_ = new ThreadLocal<Counters>();
+
+
+static Counters* local()
+{
+  Counters* local = *_counters_;
+  if (local == NULL) {
+    synchronized (counters) {
+      local = new Counters(counters->size());
+      counters->push_back(local);
+    }
+    *_counters_ = local;
+  }
+  return local;
+}
+
+
+string key(const Event& event)
+{
+  struct KeyVisitor : EventVisitor
+  {
+    KeyVisitor(string* _key) : key(_key) {}
+
+    virtual void visit(const MessageEvent& event)
+    {
+      *key = "message " + event.message->name;
+    }
+
+    virtual void visit(const DispatchEvent& event)
+    {
+      *key = DISPATCH + event.method;
+    }
+
+    virtual void visit(const HttpEvent& event)
+    {
+      // Only use the process and route (i.e., '/id/name') since the
+      // rest of the path is unbounded.
+      vector<string> tokens = strings::tokenize(event.request->path, "/");
+      *key = "http";
+      for (size_t i = 0; i < tokens.size() && i < 2; i++) {
+        *key += (i == 0 ? " /" : "/") + tokens[i];
+      }
+    }
+
+    virtual void visit(const ExitedEvent& event)
+    {
+      *key = "exited";
+    }
+
+    virtual void visit(const TerminateEvent& event)
+    {
+      *key = "terminate";
+    }
+
+    string* key;
+  };
+
+  string result;
+  KeyVisitor visitor(&result);
+  event.visit(&visitor);
+  return result;
+}
+
+
+string describe(const string& key)
+{
+  if (key.find(DISPATCH) != 0) {
+    return key;
+  }
+
+  const string method = key.substr(DISPATCH.size());
+
+  // NOTE: We assume the Itanium C++ ABI, i.e., a pointer to a member
+  // function is the address of the function (or 1 + the vtable
+  // offset if the function is virtual) followed by an adjustment.
+  if (method.size() < sizeof(void*)) {
+    return "dispatch";
+  }
+
+  uintptr_t pointer;
+  memcpy(&pointer, method.data(), sizeof(pointer));
+
+  if (pointer & 1) {
+    return "dispatch virtual method at vtable offset " +
+      stringify(pointer - 1);
+  }
+
+  void* address = reinterpret_cast<void*>(pointer);
+
+  string name = "dispatch " + stringify(address);
+
+  // Use 'backtrace_symbols' to resolve the address since it doesn't
+  // require linking with libdl. The result looks something like
+  // "binary(mangled+0x0) [0x...]". Note that only dynamically exported
+  // symbols (e.g., from a shared library, or an executable linked
+  // with -rdynamic) can be resolved, otherwise we use the address.
+  char** symbols = backtrace_symbols(&address, 1);
+  if (symbols != NULL) {
+    const string symbol = symbols[0];
+    size_t start = symbol.find('(');
+    size_t end = symbol.find_first_of("+)", start);
+    if (start != string::npos && end != string::npos && end > start + 1) {
+      const string mangled = symbol.substr(start + 1, end - start - 1);
+      int status;
+      char* demangled =
+        abi::__cxa_demangle(mangled.c_str(), NULL, NULL, &status);
+      name = "dispatch " + (status == 0 ? string(demangled) : mangled);
+      free(demangled);
+    }
+    free(symbols);
+  }
+
+  return name;
+}
+
+
+Duration cpu()
+{
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return Seconds(ts.tv_sec) + Nanoseconds(ts.tv_nsec);
+}
+
+
+void record(
+    const string& id,
+    const Event& event,
+    const Duration& waited,
+    const Duration& elapsed,
+    const Duration& cpu)
+{
+  Counters* counters = local();
+
+  // Strip any "(N)" suffix from the id.
+  const string process = id.substr(0, id.find('('));
+
+  const string key = accounting::key(event);
+
+  counters->record(process, key, waited, elapsed, cpu);
+
+  if (counters->sample()) {
+    timeval tv;
+    gettimeofday(&tv, NULL);
+
+    Sample sample;
+    sample.id = id;
+    sample.key = key;
+    sample.thread = counters->thread;
+    sample.start =
+      (tv.tv_sec * 1000000LL) + tv.tv_usec - (int64_t) elapsed.us();
+    sample.waited = waited;
+    sample.elapsed = elapsed;
+    sample.cpu = cpu;
+
+    synchronized (samples) {
+      if (samples->size() < MAX_SAMPLES) {
+        samples->push_back(sample);
+      } else {
+        (*samples)[next] = sample;
+      }
+      next = (next + 1) % MAX_SAMPLES;
+    }
+  }
+}
+
+
+JSON::Object snapshot()
+{
+  hashmap<string, Events> processes;
+
+  synchronized (counters) {
+    foreach (Counters* local, *counters) {
+      local->merge(&processes);
+    }
+  }
+
+  // Cache the described keys since describing them can be expensive.
+  hashmap<string, string> keys;
+
+  JSON::Object object;
+  foreachpair (const string& id, const Events& events, processes) {
+    Usage total;
+
+    // NOTE: Different keys might have the same description.
+    Events merged;
+    foreachpair (const string& key, const Usage& usage, events) {
+      if (!keys.contains(key)) {
+        keys[key] = describe(key);
+      }
+      merged[keys[key]].merge(usage);
+      total.merge(usage);
+    }
+
+    JSON::Object handlers;
+    foreachpair (const string& key, const Usage& usage, merged) {
+      handlers.values[key] = usage.json();
+    }
+
+    JSON::Object value = total.json();
+    value.values["handlers"] = handlers;
+    object.values[id] = value;
+  }
+
+  return object;
+}
+
+
+JSON::Object trace()
+{
+  vector<Sample> copy;
+  synchronized (samples) {
+    copy = *samples;
+  }
+
+  hashmap<string, string> keys;
+
+  JSON::Array events;
+  foreach (const Sample& sample, copy) {
+    if (!keys.contains(sample.key)) {
+      keys[sample.key] = describe(sample.key);
+    }
+
+    JSON::Object args;
+    args.values["process"] = sample.id;
+    args.values["wait_time_us"] = JSON::Number(sample.waited.us());
+    args.values["cpu_time_us"] = JSON::Number(sample.cpu.us());
+
+    JSON::Object event;
+    event.values["name"] = keys[sample.key];
+    event.values["cat"] = sample.id.substr(0, sample.id.find('('));
+    event.values["ph"] = "X"; // A "complete" event.
+    event.values["ts"] = JSON::Number(sample.start);
+    event.values["dur"] = JSON::Number(sample.elapsed.us());
+    event.values["pid"] = JSON::Number(getpid());
+    event.values["tid"] = JSON::Number(sample.thread);
+    event.values["args"] = args;
+    events.values.push_back(event);
+  }
+
+  JSON::Object object;
+  object.values["traceEvents"] = events;
+  return object;
+}
+
+} // namespace accounting {
+} // namespace process {
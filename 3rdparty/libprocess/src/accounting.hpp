@@ -0,0 +1,108 @@
+#ifndef __ACCOUNTING_HPP__
+#define __ACCOUNTING_HPP__
+
+#include <string>
+
+#include <process/event.hpp>
+#include <process/future.hpp>
+#include <process/http.hpp>
+#include <process/process.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/json.hpp>
+
+namespace process {
+namespace accounting {
+
+// Provides optional (see LIBPROCESS_ENABLE_ACCOUNTING) per process
+// accounting of the events that get processed: counts by event type
+// (and message name, dispatched method, or HTTP route), CPU time
+// (from the thread CPU clock), wall time, and time spent waiting in
+// the process' mailbox. Processes are accounted for by their id
+// without any "(N)" suffix so that short lived processes (e.g.,
+// '__waiter__(42)') get aggregated. Accounting gets recorded
+// into per-thread counters, which are merged when they're read. A
+// sample of the events also gets kept for exporting as a trace.
+
+// Whether or not accounting is enabled, set by process::initialize.
+extern bool enabled;
+
+// Returns a key describing the event (e.g., "message <name>" or
+// "dispatch <method>"), which is used to account for the event.
+std::string key(const Event& event);
+
+// Returns the key in a human readable form, which for dispatches
+// means resolving the method to a (demangled) function name. This
+// can be expensive, so it should not be done on any hot path.
+std::string describe(const std::string& key);
+
+// Returns the CPU time consumed by the calling thread.
+Duration cpu();
+
+// Records that the process with the specified id handled the event
+// after it waited in the mailbox for 'waited', taking 'elapsed' (wall)
+// and 'cpu' time.
+void record(
+    const std::string& id,
+    const Event& event,
+    const Duration& waited,
+    const Duration& elapsed,
+    const Duration& cpu);
+
+// Returns the merged accounting for all processes.
+JSON::Object snapshot();
+
+// Returns the most recent sampled events in the Chrome trace event
+// format (see chrome://tracing).
+JSON::Object trace();
+
+} // namespace accounting {
+
+
+// Exposes the accounting at '/__processes__' and the sampled events
+// at '/__processes__/trace'.
+class ProcessesProcess : public Process<ProcessesProcess>
+{
+public:
+  ProcessesProcess() : ProcessBase("__processes__") {}
+
+  virtual ~ProcessesProcess() {}
+
+protected:
+  virtual void initialize()
+  {
+    route("/", &ProcessesProcess::processes);
+    route("/trace", &ProcessesProcess::trace);
+  }
+
+private:
+  // Returns a JSON object keyed by process. Supports an optional
+  // 'jsonp' query parameter.
+  Future<http::Response> processes(const http::Request& request)
+  {
+    if (!accounting::enabled) {
+      return http::BadRequest(
+          "Accounting is not enabled. To enable accounting, libprocess "
+          "must be started with LIBPROCESS_ENABLE_ACCOUNTING=1 in the "
+          "environment.\n");
+    }
+    return http::OK(accounting::snapshot(), request.query.get("jsonp"));
+  }
+
+  // Returns the sampled events as a Chrome trace. Supports an
+  // optional 'jsonp' query parameter.
+  Future<http::Response> trace(const http::Request& request)
+  {
+    if (!accounting::enabled) {
+      return http::BadRequest(
+          "Accounting is not enabled. To enable accounting, libprocess "
+          "must be started with LIBPROCESS_ENABLE_ACCOUNTING=1 in the "
+          "environment.\n");
+    }
+    return http::OK(accounting::trace(), request.query.get("jsonp"));
+  }
+};
+
+} // namespace process {
+
+#endif // __ACCOUNTING_HPP__
@@ -0,0 +1,139 @@
+#include <pthread.h>
+#include <stdint.h>
+
+#include <glog/logging.h>
+
+#include <deque>
+
+#include <process/async.hpp>
+#include <process/process.hpp>
+
+#include <stout/json.hpp>
+
+#include "blocking.hpp"
+
+using std::deque;
+
+namespace process {
+namespace blocking {
+
+// Queued functions, one queue per priority (see AsyncPriority).
+static deque<std::tr1::function<bool(void)> > queues[ASYNC_HIGH + 1];
+
+// Protects the queues and the counters below. We use a condition
+// variable (rather than 'synchronized') so that idle threads can
+// wait for functions to get queued.
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+
+static size_t threads = 0;
+static size_t running = 0;
+static uint64_t executed = 0;
+static uint64_t discarded = 0;
+
+
+// Dequeues the highest priority function, waiting if necessary.
+static std::tr1::function<bool(void)> dequeue()
+{
+  pthread_mutex_lock(&mutex);
+
+  while (true) {
+    for (int priority = ASYNC_HIGH; priority >= ASYNC_LOW; priority--) {
+      if (!queues[priority].empty()) {
+        std::tr1::function<bool(void)> f = queues[priority].front();
+        queues[priority].pop_front();
+        running++;
+        pthread_mutex_unlock(&mutex);
+        return f;
+      }
+    }
+
+    pthread_cond_wait(&cond, &mutex);
+  }
+}
+
+
+static void* execute(void*)
+{
+  while (true) {
+    std::tr1::function<bool(void)> f = dequeue();
+
+    const bool result = f();
+
+    pthread_mutex_lock(&mutex);
+    {
+      running--;
+      if (result) {
+        executed++;
+      } else {
+        discarded++;
+      }
+    }
+    pthread_mutex_unlock(&mutex);
+  }
+
+  return NULL;
+}
+
+
+void initialize(size_t _threads)
+{
+  CHECK(threads == 0) << "Blocking thread pool already initialized";
+  CHECK(_threads > 0);
+
+  threads = _threads;
+
+  for (size_t i = 0; i < threads; i++) {
+    pthread_t thread; // For now, not saving handles on our threads.
+    if (pthread_create(&thread, NULL, execute, NULL) != 0) {
+      LOG(FATAL) << "Failed to initialize, pthread_create";
+    }
+  }
+}
+
+
+JSON::Object snapshot()
+{
+  JSON::Object object;
+
+  pthread_mutex_lock(&mutex);
+  {
+    JSON::Object queued;
+    queued.values["low"] = JSON::Number(queues[ASYNC_LOW].size());
+    queued.values["normal"] = JSON::Number(queues[ASYNC_NORMAL].size());
+    queued.values["high"] = JSON::Number(queues[ASYNC_HIGH].size());
+
+    object.values["threads"] = JSON::Number(threads);
+    object.values["running"] = JSON::Number(running);
+    object.values["queued"] = queued;
+    object.values["executed"] = JSON::Number(executed);
+    object.values["discarded"] = JSON::Number(discarded);
+  }
+  pthread_mutex_unlock(&mutex);
+
+  return object;
+}
+
+} // namespace blocking {
+
+
+namespace internal {
+
+void async(
+    const std::tr1::function<bool(void)>& f,
+    AsyncPriority priority)
+{
+  // Make sure the blocking threads have been started.
+  process::initialize();
+
+  pthread_mutex_lock(&blocking::mutex);
+  {
+    blocking::queues[priority].push_back(f);
+  }
+  pthread_mutex_unlock(&blocking::mutex);
+
+  pthread_cond_signal(&blocking::cond);
+}
+
+} // namespace internal {
+} // namespace process {
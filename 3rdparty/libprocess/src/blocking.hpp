@@ -0,0 +1,56 @@
+#ifndef __BLOCKING_HPP__
+#define __BLOCKING_HPP__
+
+#include <stddef.h>
+
+#include <process/future.hpp>
+#include <process/http.hpp>
+#include <process/process.hpp>
+
+#include <stout/json.hpp>
+
+namespace process {
+namespace blocking {
+
+// Provides the bounded pool of threads used for executing blocking
+// functions via 'async' (see process/async.hpp). Functions are queued
+// by priority and executed first in first out within a priority.
+
+// Starts the specified number of threads, called by
+// process::initialize (see LIBPROCESS_ASYNC_THREADS).
+void initialize(size_t threads);
+
+// Returns the number of threads, running and queued functions (by
+// priority), as well as how many functions have been executed or
+// discarded (cancelled before they were executed).
+JSON::Object snapshot();
+
+} // namespace blocking {
+
+
+// Exposes the blocking thread pool at '/__async__'.
+class AsyncProcess : public Process<AsyncProcess>
+{
+public:
+  AsyncProcess() : ProcessBase("__async__") {}
+
+  virtual ~AsyncProcess() {}
+
+protected:
+  virtual void initialize()
+  {
+    route("/", &AsyncProcess::async);
+  }
+
+private:
+  // Returns the blocking thread pool snapshot. Supports an optional
+  // 'jsonp' query parameter.
+  Future<http::Response> async(const http::Request& request)
+  {
+    return http::OK(blocking::snapshot(), request.query.get("jsonp"));
+  }
+};
+
+} // namespace process {
+
+#endif // __BLOCKING_HPP__
@@ -2,7 +2,9 @@
 #define __DECODER_HPP__
 
 #include <http_parser.h>
+#include <string.h>
 
+#include <algorithm>
 #include <deque>
 #include <string>
 #include <vector>
@@ -12,6 +14,8 @@
 
 #include <stout/foreach.hpp>
 #include <stout/gzip.hpp>
+#include <stout/nothing.hpp>
+#include <stout/stringify.hpp>
 #include <stout/try.hpp>
 
 
@@ -22,8 +26,18 @@ namespace process {
 class DataDecoder
 {
 public:
-  DataDecoder(const Socket& _s)
-    : s(_s), failure(false), request(NULL)
+  // If 'defer' is true then decoding the query and (compressed) body
+  // of each request is deferred until 'complete' gets invoked (e.g.,
+  // once the request actually gets handled, rather than on the I/O
+  // thread that does the decoding).
+  DataDecoder(const Socket& _s, bool _defer = false)
+    : s(_s),
+      defer(_defer),
+      failure(false),
+      request(NULL),
+      reserved(false),
+      received(0),
+      expected(0)
   {
     settings.on_message_begin = &DataDecoder::on_message_begin;
     settings.on_header_field = &DataDecoder::on_header_field;
@@ -49,6 +63,11 @@ public:
       failure = true;
     }
 
+    // Copy any partially parsed header since 'data' is about to go
+    // away (see 'View').
+    field.spill();
+    value.spill();
+
     if (!requests.empty()) {
       std::deque<http::Request*> result = requests;
       requests.clear();
@@ -63,12 +82,138 @@ public:
     return failure;
   }
 
+  // Returns where the rest of the body of the request currently
+  // being decoded can be received into directly, and sets
+  // 'remaining' to how many bytes of it are still expected, or
+  // returns NULL if no body is expected right now (e.g., still
+  // decoding the headers, or the body is chunked). The data received
+  // there still has to be passed to 'decode', but it won't be copied
+  // again.
+  char* body(size_t* remaining)
+  {
+    if (!reserved || failure) {
+      return NULL;
+    }
+
+    assert(request != NULL);
+    assert(received < expected);
+
+    if (received == request->body.size()) {
+      reserve(received + 1);
+    }
+
+    *remaining = request->body.size() - received;
+    return &request->body[received];
+  }
+
   Socket socket() const
   {
     return s;
   }
 
+  // Decodes the query and (if compressed) body of the request, this
+  // is done when decoding unless decoding has been deferred (see
+  // constructor). Completing a request more than once is a no-op.
+  static Try<Nothing> complete(http::Request* request)
+  {
+    if (request->query.empty()) {
+      // Extract the query from the URL (i.e., "path?query#fragment").
+      size_t start = request->url.find('?');
+      if (start != std::string::npos) {
+        size_t end = request->url.find('#', start);
+        Try<std::string> decoded = http::decode(
+            request->url.substr(
+                start + 1,
+                end == std::string::npos ? end : end - start - 1));
+
+        if (decoded.isError()) {
+          return Error("Failed to decode query: " + decoded.error());
+        }
+
+        request->query = http::query::parse(decoded.get());
+      }
+    }
+
+    Option<std::string> encoding = request->headers.get("Content-Encoding");
+    if (encoding.isSome() && encoding.get() == "gzip") {
+      Try<std::string> decompressed = gzip::decompress(request->body);
+      if (decompressed.isError()) {
+        return Error("Failed to decompress body: " + decompressed.error());
+      }
+      request->body = decompressed.get();
+      request->headers.erase("Content-Encoding");
+      request->headers["Content-Length"] = stringify(request->body.length());
+    }
+
+    return Nothing();
+  }
+
 private:
+  // Describes a (non-owning) view of some data being decoded, which
+  // lets us avoid copying a header field or value until it has been
+  // completely parsed. The data gets copied into 'buffer' if it's
+  // about to go away before the view is complete (e.g., because a
+  // header has been split across multiple reads).
+  struct View
+  {
+    View() : data(NULL), length(0) {}
+
+    void append(const char* _data, size_t _length)
+    {
+      if (data == NULL && buffer.empty()) {
+        data = _data;
+        length = _length;
+      } else if (data != NULL && data + length == _data) {
+        length += _length; // Contiguous, just extend the view.
+      } else {
+        spill();
+        buffer.append(_data, _length);
+      }
+    }
+
+    void spill()
+    {
+      if (data != NULL) {
+        buffer.append(data, length);
+        data = NULL;
+        length = 0;
+      }
+    }
+
+    void clear()
+    {
+      data = NULL;
+      length = 0;
+      buffer.clear();
+    }
+
+    std::string str() const
+    {
+      return data != NULL ? std::string(data, length) : buffer;
+    }
+
+    void copy(std::string* s) const
+    {
+      if (data != NULL) {
+        s->assign(data, length);
+      } else {
+        s->assign(buffer);
+      }
+    }
+
+    const char* data;
+    size_t length;
+    std::string buffer;
+  };
+
+  // Adds the header that has been parsed to the current request.
+  void addHeader()
+  {
+    value.copy(&request->headers[field.str()]);
+    field.clear();
+    value.clear();
+  }
+
   static int on_message_begin(http_parser* p)
   {
     DataDecoder* decoder = (DataDecoder*) p->data;
@@ -78,17 +223,9 @@ private:
     decoder->header = HEADER_FIELD;
     decoder->field.clear();
     decoder->value.clear();
-    decoder->query.clear();
 
     assert(decoder->request == NULL);
     decoder->request = new http::Request();
-    decoder->request->headers.clear();
-    decoder->request->method.clear();
-    decoder->request->path.clear();
-    decoder->request->url.clear();
-    decoder->request->fragment.clear();
-    decoder->request->query.clear();
-    decoder->request->body.clear();
 
     return 0;
   }
@@ -98,39 +235,44 @@ private:
     DataDecoder* decoder = (DataDecoder*) p->data;
 
     // Add final header.
-    decoder->request->headers[decoder->field] = decoder->value;
-    decoder->field.clear();
-    decoder->value.clear();
+    decoder->addHeader();
 
     decoder->request->method = http_method_str((http_method) decoder->parser.method);
     decoder->request->keepAlive = http_should_keep_alive(&decoder->parser);
+
+    // When the length of the body is known, allocate it as it gets
+    // received (but in bigger steps than appending would) so that
+    // it can be received into directly (see 'body'). Only what has
+    // actually been received counts, not what the header claims.
+    // The parser ignores the Content-Length of chunked bodies, so
+    // those are appended to as they come in.
+    int64_t length = decoder->parser.content_length;
+    if (length > 0 && (decoder->parser.flags & CHUNKED) == 0) {
+      decoder->reserved = true;
+      decoder->received = 0;
+      decoder->expected = length;
+      decoder->reserve(0);
+    }
+
     return 0;
   }
 
   static int on_message_complete(http_parser* p)
   {
     DataDecoder* decoder = (DataDecoder*) p->data;
+
+    if (decoder->reserved) {
+      decoder->request->body.resize(decoder->received);
+      decoder->reserved = false;
+    }
+
 //     std::cout << "http::Request:" << std::endl;
 //     std::cout << "  method: " << decoder->request->method << std::endl;
 //     std::cout << "  path: " << decoder->request->path << std::endl;
-    // Parse the query key/values.
-    Try<std::string> decoded = http::decode(decoder->query);
-    if (decoded.isError()) {
+    // Parse the query key/values and decompress the body.
+    if (!decoder->defer && complete(decoder->request).isError()) {
       return 1;
     }
-    decoder->request->query = http::query::parse(decoded.get());
-
-    Option<std::string> encoding =
-      decoder->request->headers.get("Content-Encoding");
-    if (encoding.isSome() && encoding.get() == "gzip") {
-      Try<std::string> decompressed = gzip::decompress(decoder->request->body);
-      if (decompressed.isError()) {
-        return 1;
-      }
-      decoder->request->body = decompressed.get();
-      decoder->request->headers["Content-Length"] =
-        decoder->request->body.length();
-    }
 
     decoder->requests.push_back(decoder->request);
     decoder->request = NULL;
@@ -143,9 +285,7 @@ private:
     assert(decoder->request != NULL);
 
     if (decoder->header != HEADER_FIELD) {
-      decoder->request->headers[decoder->field] = decoder->value;
-      decoder->field.clear();
-      decoder->value.clear();
+      decoder->addHeader();
     }
 
     decoder->field.append(data, length);
@@ -181,9 +321,7 @@ private:
 
   static int on_query_string(http_parser* p, const char* data, size_t length)
   {
-    DataDecoder* decoder = (DataDecoder*) p->data;
-    assert(decoder->request != NULL);
-    decoder->query.append(data, length);
+    // NOTE: The query is extracted from the URL (see 'complete').
     return 0;
   }
 
@@ -199,12 +337,54 @@ private:
   {
     DataDecoder* decoder = (DataDecoder*) p->data;
     assert(decoder->request != NULL);
-    decoder->request->body.append(data, length);
+
+    if (decoder->reserved &&
+        decoder->received + length > decoder->request->body.size()) {
+      // Data that was received in place always fits, so 'data' can't
+      // point into the body which is about to be reallocated.
+      if (decoder->received + length <= decoder->expected) {
+        decoder->reserve(decoder->received + length);
+      } else {
+        // More than expected, give up on the reservation.
+        decoder->request->body.resize(decoder->received);
+        decoder->reserved = false;
+      }
+    }
+
+    if (decoder->reserved) {
+      // Nothing to copy if the data was received in place.
+      char* end = &decoder->request->body[decoder->received];
+      if (data != end) {
+        memmove(end, data, length);
+      }
+      decoder->received += length;
+    } else {
+      decoder->request->body.append(data, length);
+    }
+
     return 0;
   }
 
+  // Grows the reserved body to hold at least 'size' bytes, at least
+  // doubling it (starting at MIN_RESERVED_BODY_SIZE) but never past
+  // what is expected.
+  void reserve(size_t size)
+  {
+    size = std::max(size, request->body.size() * 2);
+    size = std::max(size, (size_t) MIN_RESERVED_BODY_SIZE);
+    request->body.resize(std::min(size, expected));
+  }
+
+  static const size_t MIN_RESERVED_BODY_SIZE = 64 * 1024;
+
+  // Mirrors F_CHUNKED in http_parser.c, the flags aren't exported by
+  // http_parser.h.
+  static const unsigned char CHUNKED = 1 << 0;
+
   const Socket s; // The socket this decoder is associated with.
 
+  const bool defer;
+
   bool failure;
 
   http_parser parser;
@@ -215,12 +395,18 @@ private:
     HEADER_VALUE
   } header;
 
-  std::string field;
-  std::string value;
-  std::string query;
+  View field;
+  View value;
 
   http::Request* request;
 
+  // Whether the body of 'request' is being allocated ahead of what
+  // is received, how much of it has been received so far and how
+  // long it is expected to be (i.e., its Content-Length).
+  bool reserved;
+  size_t received;
+  size_t expected;
+
   std::deque<http::Request*> requests;
 };
 
@@ -8,7 +8,6 @@
 #include <process/process.hpp>
 
 #include <stout/foreach.hpp>
-#include <stout/gzip.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/numify.hpp>
 #include <stout/os.hpp>
@@ -21,8 +20,6 @@ struct ev_io;
 
 namespace process {
 
-const uint32_t GZIP_MINIMUM_BODY_LENGTH = 1024;
-
 typedef void (*Sender)(struct ev_loop*, ev_io*, int);
 
 extern void send_data(struct ev_loop*, ev_io*, int);
@@ -109,13 +106,17 @@ public:
           << "User-Agent: libprocess/" << message->from << "\r\n"
           << "Connection: Keep-Alive\r\n";
 
+      // Propagate the span for tracing (see tracer.hpp).
+      if (message->span != 0) {
+        out << "Libprocess-Span: " << std::hex << message->span << "\r\n";
+      }
+
+      // Sending the length of the body up front lets the receiver
+      // allocate it once (see DataDecoder::body).
       if (message->body.size() > 0) {
-        out << "Transfer-Encoding: chunked\r\n\r\n"
-            << std::hex << message->body.size() << "\r\n";
+        out << "Content-Length: " << std::dec << message->body.size()
+            << "\r\n\r\n";
         out.write(message->body.data(), message->body.size());
-        out << "\r\n"
-            << "0\r\n"
-            << "\r\n";
       } else {
         out << "\r\n";
       }
@@ -163,22 +164,9 @@ public:
 
     headers["Date"] = date;
 
-    // Should we compress this response?
-    std::string body = response.body;
-
-    if (response.type == http::Response::BODY &&
-        response.body.length() >= GZIP_MINIMUM_BODY_LENGTH &&
-        !headers.contains("Content-Encoding") &&
-        request.accepts("gzip")) {
-      Try<std::string> compressed = gzip::compress(body);
-      if (compressed.isError()) {
-        LOG(WARNING) << "Failed to gzip response body: " << compressed.error();
-      } else {
-        body = compressed.get();
-        headers["Content-Length"] = stringify(body.length());
-        headers["Content-Encoding"] = "gzip";
-      }
-    }
+    // NOTE: Compression of large bodies is done by the HttpProxy
+    // (off of the I/O path) before the response gets encoded.
+    const std::string& body = response.body;
 
     foreachpair (const std::string& key, const std::string& value, headers) {
       out << key << ": " << value << "\r\n";
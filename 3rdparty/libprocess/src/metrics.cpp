@@ -0,0 +1,281 @@
+#include <stdint.h>
+#include <string.h>
+
+#include <list>
+#include <string>
+
+#include <stout/duration.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/json.hpp>
+#include <stout/thread.hpp>
+
+#include "metrics.hpp"
+#include "synchronized.hpp"
+
+using std::list;
+using std::string;
+
+namespace process {
+namespace metrics {
+
+// A log-linear histogram (similar to an HDR histogram with two
+// significant bits) of values in microseconds. Values less than 4 get
+// their own bucket, every other power of two is split into 4 buckets.
+// This bounds the relative error of any percentile to 25%.
+class Histogram
+{
+public:
+  Histogram() : count(0), sum(0), max(0)
+  {
+    memset(buckets, 0, sizeof(buckets));
+  }
+
+  void record(const Duration& duration)
+  {
+    const uint64_t value =
+      duration < Duration::zero() ? 0 : (uint64_t) duration.us();
+
+    buckets[bucket(value)]++;
+    count++;
+    sum += value;
+    if (value > max) {
+      max = value;
+    }
+  }
+
+  void merge(const Histogram& that)
+  {
+    for (size_t i = 0; i < BUCKETS; i++) {
+      buckets[i] += that.buckets[i];
+    }
+    count += that.count;
+    sum += that.sum;
+    if (that.max > max) {
+      max = that.max;
+    }
+  }
+
+  // Returns the (upper bound of the) value at the percentile, where
+  // 'percentile' is in the range [0, 1].
+  uint64_t percentile(double percentile) const
+  {
+    if (count == 0) {
+      return 0;
+    }
+
+    uint64_t rank = (uint64_t) (percentile * count);
+    if (rank == 0) {
+      rank = 1;
+    }
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+      total += buckets[i];
+      if (total >= rank) {
+        uint64_t upper = i + 1 < BUCKETS ? lower(i + 1) - 1 : max;
+        return upper < max ? upper : max;
+      }
+    }
+
+    return max;
+  }
+
+  JSON::Object json() const
+  {
+    JSON::Object object;
+    object.values["count"] = JSON::Number(count);
+    object.values["mean"] = JSON::Number(count > 0 ? (double) sum / count : 0);
+    object.values["p50"] = JSON::Number(percentile(0.5));
+    object.values["p90"] = JSON::Number(percentile(0.9));
+    object.values["p99"] = JSON::Number(percentile(0.99));
+    object.values["p999"] = JSON::Number(percentile(0.999));
+    object.values["max"] = JSON::Number(max);
+    return object;
+  }
+
+private:
+  // Largest power of two we keep buckets for, larger values (over 12
+  // days in microseconds) end up in the last bucket.
+  static const size_t MAX_EXPONENT = 40;
+  static const size_t BUCKETS = 4 * MAX_EXPONENT;
+
+  static size_t bucket(uint64_t value)
+  {
+    if (value < 4) {
+      return value;
+    }
+
+    size_t exponent = 63 - __builtin_clzll(value);
+    if (exponent >= MAX_EXPONENT) {
+      return BUCKETS - 1;
+    }
+
+    return 4 * (exponent - 1) + ((value >> (exponent - 2)) & 3);
+  }
+
+  // Returns the smallest value that ends up in the bucket.
+  static uint64_t lower(size_t bucket)
+  {
+    if (bucket < 4) {
+      return bucket;
+    }
+
+    return (uint64_t) (4 + bucket % 4) << (bucket / 4 - 1);
+  }
+
+  uint64_t buckets[BUCKETS];
+  uint64_t count;
+  uint64_t sum;
+  uint64_t max;
+};
+
+
+struct Route
+{
+  Route() : requests(0), inflight(0) {}
+
+  void merge(const Route& that)
+  {
+    requests += that.requests;
+    inflight += that.inflight;
+    foreachpair (const string& code, uint64_t count, that.codes) {
+      codes[code] += count;
+    }
+    queueing.merge(that.queueing);
+    handling.merge(that.handling);
+  }
+
+  uint64_t requests;
+
+  // NOTE: Requests can start and complete on different threads, so
+  // the per-thread count might be negative, only the merged count is
+  // meaningful.
+  int64_t inflight;
+
+  hashmap<string, uint64_t> codes;
+
+  Histogram queueing;
+  Histogram handling;
+};
+
+
+// The metrics recorded by a single thread. Only the owning thread
+// updates these, the lock is (only) contended when merging.
+class Counters
+{
+public:
+  Counters()
+  {
+    synchronizer(this) = SYNCHRONIZED_INITIALIZER;
+  }
+
+  void started(const string& route, const Duration& queued)
+  {
+    synchronized (this) {
+      Route& metrics = routes[route];
+      metrics.requests++;
+      metrics.inflight++;
+      metrics.queueing.record(queued);
+    }
+  }
+
+  void completed(
+      const string& route,
+      const string& code,
+      const Duration& elapsed)
+  {
+    synchronized (this) {
+      Route& metrics = routes[route];
+      metrics.inflight--;
+      metrics.codes[code]++;
+      metrics.handling.record(elapsed);
+    }
+  }
+
+  // Merges these counters into the specified routes.
+  void merge(hashmap<string, Route>* merged)
+  {
+    synchronized (this) {
+      foreachpair (const string& route, const Route& metrics, routes) {
+        (*merged)[route].merge(metrics);
+      }
+    }
+  }
+
+private:
+  hashmap<string, Route> routes;
+
+  synchronizable(this);
+};
+
+
+// Counters of every thread that has recorded any metrics (these are
+// never deleted since libprocess threads live forever).
+static list<Counters*>* counters = new list<Counters*>();
+static synchronizable(counters) = SYNCHRONIZED_INITIALIZER;
+
+// Counters of the current thread.
+static ThreadLocal<Counters>* _counters_ = new ThreadLocal<Counters>();
+
+
+static Counters* local()
+{
+  Counters* local = *_counters_;
+  if (local == NULL) {
+    local = new Counters();
+    *_counters_ = local;
+    synchronized (counters) {
+      counters->push_back(local);
+    }
+  }
+  return local;
+}
+
+
+void started(const string& route, const Duration& queued)
+{
+  local()->started(route, queued);
+}
+
+
+void completed(
+    const string& route,
+    const string& code,
+    const Duration& elapsed)
+{
+  local()->completed(route, code, elapsed);
+}
+
+
+JSON::Object snapshot()
+{
+  hashmap<string, Route> routes;
+
+  synchronized (counters) {
+    foreach (Counters* local, *counters) {
+      local->merge(&routes);
+    }
+  }
+
+  JSON::Object object;
+  foreachpair (const string& route, const Route& metrics, routes) {
+    JSON::Object codes;
+    foreachpair (const string& code, uint64_t count, metrics.codes) {
+      codes.values[code] = JSON::Number(count);
+    }
+
+    JSON::Object value;
+    value.values["requests"] = JSON::Number(metrics.requests);
+    value.values["in_flight"] = JSON::Number(metrics.inflight);
+    value.values["codes"] = codes;
+    value.values["queueing_time_us"] = metrics.queueing.json();
+    value.values["handler_time_us"] = metrics.handling.json();
+    object.values[route] = value;
+  }
+
+  return object;
+}
+
+} // namespace metrics {
+} // namespace process {
@@ -0,0 +1,99 @@
+#ifndef __METRICS_HPP__
+#define __METRICS_HPP__
+
+#include <string>
+
+#include <process/future.hpp>
+#include <process/http.hpp>
+#include <process/process.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/json.hpp>
+
+namespace process {
+namespace metrics {
+
+// Provides per route HTTP metrics (request counts, in-flight
+// requests, status codes, and histograms of the time spent queued
+// versus the time spent in the handler). Metrics get recorded into
+// per-thread counters so that recording does not contend across
+// threads, and get merged when they're read. The routes of processes
+// with generated ids (e.g., 'scheduler(1)', see ID::generate) are
+// recorded under their prefix (e.g., '/scheduler/...') so that the
+// number of routes doesn't grow with the number of processes.
+
+// Records that a request for the route has been dispatched to its
+// handler after having been queued (i.e., waiting to be handled by
+// the process) for the specified duration.
+void started(const std::string& route, const Duration& queued);
+
+// Records that a request for the route has completed with the
+// specified status code (e.g., "200") the specified duration after
+// its handler was invoked.
+void completed(
+    const std::string& route,
+    const std::string& code,
+    const Duration& elapsed);
+
+// Returns the merged metrics for all routes.
+JSON::Object snapshot();
+
+// Returns how many temporary sockets (i.e., used to send messages to
+// nodes that aren't linked to) have been opened, reused for later
+// messages, and closed because they were idle for too long, because
+// there were too many idle sockets, or by the remote end, along with
+// how many idle sockets can be kept open.
+JSON::Object sockets();
+
+// Returns how many compressed response bodies have been served from
+// the cache of compressed bodies (hits), and how many had to be
+// compressed instead (misses).
+JSON::Object gzip();
+
+} // namespace metrics {
+
+
+// Exposes the metrics at '/__metrics__', the socket counters at
+// '/__metrics__/sockets' and the compression cache counters at
+// '/__metrics__/gzip'.
+class MetricsProcess : public Process<MetricsProcess>
+{
+public:
+  MetricsProcess() : ProcessBase("__metrics__") {}
+
+  virtual ~MetricsProcess() {}
+
+protected:
+  virtual void initialize()
+  {
+    route("/", &MetricsProcess::metrics);
+    route("/sockets", &MetricsProcess::sockets);
+    route("/gzip", &MetricsProcess::gzip);
+  }
+
+private:
+  // Returns a JSON object keyed by route. Supports an optional
+  // 'jsonp' query parameter.
+  Future<http::Response> metrics(const http::Request& request)
+  {
+    return http::OK(metrics::snapshot(), request.query.get("jsonp"));
+  }
+
+  // Returns the socket counters. Supports an optional 'jsonp' query
+  // parameter.
+  Future<http::Response> sockets(const http::Request& request)
+  {
+    return http::OK(metrics::sockets(), request.query.get("jsonp"));
+  }
+
+  // Returns the compression cache counters. Supports an optional
+  // 'jsonp' query parameter.
+  Future<http::Response> gzip(const http::Request& request)
+  {
+    return http::OK(metrics::gzip(), request.query.get("jsonp"));
+  }
+};
+
+} // namespace process {
+
+#endif // __METRICS_HPP__
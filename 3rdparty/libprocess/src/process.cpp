@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <arpa/inet.h>
@@ -20,6 +21,7 @@
 
 #include <sys/ioctl.h>
 #include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/select.h>
 #include <sys/socket.h>
 #include <sys/time.h>
@@ -45,6 +47,7 @@
 
 #include <boost/shared_array.hpp>
 
+#include <process/async.hpp>
 #include <process/clock.hpp>
 #include <process/defer.hpp>
 #include <process/delay.hpp>
@@ -64,19 +67,29 @@
 #include <process/time.hpp>
 #include <process/timer.hpp>
 
+#include <stout/cache.hpp>
 #include <stout/duration.hpp>
 #include <stout/foreach.hpp>
+#include <stout/gzip.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/lambda.hpp>
 #include <stout/net.hpp>
+#include <stout/numify.hpp>
 #include <stout/os.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 #include <stout/thread.hpp>
 
+#include "accounting.hpp"
+#include "blocking.hpp"
 #include "config.hpp"
 #include "decoder.hpp"
 #include "encoder.hpp"
 #include "gate.hpp"
+#include "metrics.hpp"
 #include "synchronized.hpp"
+#include "tracer.hpp"
 
 using process::wait; // Necessary on some OS's to disambiguate.
 
@@ -198,7 +211,7 @@ public:
   }
 
 private:
-  friend class ProcessManager; // For ProcessManager::use.
+  friend class ProcessShard; // For ProcessShard::use.
 
   ProcessReference(ProcessBase* _process)
     : process(_process)
@@ -253,7 +266,9 @@ public:
 
   // Enqueues a future to a response that will get waited on (up to
   // some timeout) and then sent once all previously enqueued
-  // responses have been processed (e.g., waited for and sent).
+  // responses have been processed (e.g., waited for and sent). The
+  // response gets prepared (e.g., compressed) as soon as it's ready
+  // so that pipelined requests get processed concurrently.
   void handle(Future<Response>* future, const Request& request);
 
 private:
@@ -292,6 +307,119 @@ private:
   queue<Item*> items;
 
   Option<int> pipe; // Current pipe, if streaming.
+
+  gzip::Compressor* compressor; // Compresses current pipe, if any.
+};
+
+
+// Provides a process that sends HTTP requests (see http::get,
+// http::post and http::put) over a pool of persistent connections
+// per node. Idempotent requests are pipelined on a connection (up to
+// some limit) when no idle connection is available and no new
+// connection can be created. The total number of connections, as
+// well as the number of connections per node, is bounded; requests
+// that cannot be sent immediately are queued until a connection
+// becomes available. Responses are decoded incrementally as they
+// are read (including chunked responses).
+class HttpConnectionPool : public Process<HttpConnectionPool>
+{
+public:
+  HttpConnectionPool();
+  virtual ~HttpConnectionPool();
+
+  // Sends the (already encoded) request to the specified node and
+  // returns a future to the decoded response. Only requests which
+  // are safe to retry should be marked as 'pipeline'.
+  Future<Response> request(
+      const Node& node,
+      const string& data,
+      bool pipeline);
+
+private:
+  // A request waiting to be sent or waiting for its response.
+  struct Item
+  {
+    Item(const string& _data, bool _pipeline)
+      : data(_data), pipeline(_pipeline) {}
+
+    const string data;
+    const bool pipeline;
+    Promise<Response> promise;
+  };
+
+  struct Connection
+  {
+    Connection(uint64_t _id, const Node& _node, int _s)
+      : id(_id),
+        node(_node),
+        s(_s),
+        connected(false),
+        writing(false),
+        closing(false),
+        closed(false),
+        idle(0),
+        buffer(new char[io::BUFFERED_READ_SIZE]) {}
+
+    const uint64_t id;
+    const Node node;
+    const int s;
+
+    bool connected; // True once the (non-blocking) connect completed.
+    bool writing; // True while waiting for the socket to be writable.
+    bool closing; // True if the server asked to close the connection.
+    bool closed; // True once shutdown, waiting for the read to finish.
+
+    // Incremented on each use so stale idle timeouts can be ignored.
+    uint64_t idle;
+
+    ResponseDecoder decoder;
+
+    // Requests sent (or to be sent) on this connection, in order.
+    deque<Item*> pending;
+
+    // Encoded requests not yet written to the socket.
+    string outgoing;
+
+    boost::shared_array<char> buffer;
+  };
+
+  // Requests and (usable) connections for a node.
+  struct Host
+  {
+    deque<Item*> waiting;
+    set<uint64_t> connections;
+  };
+
+  // Sends as many of the waiting requests for the node as possible.
+  void schedule(const Node& node);
+
+  // Returns a connection which can send the request right away, if
+  // any, creating a new connection if the limits allow it.
+  Try<Connection*> select(const Node& node, Item* item);
+
+  Try<Connection*> connect(const Node& node);
+  void connected(uint64_t id, const Future<short>& poll);
+
+  void write(Connection* connection);
+  void _write(uint64_t id, const Future<short>& poll);
+
+  void read(Connection* connection);
+  void _read(uint64_t id, const Future<size_t>& length);
+
+  // Closes an idle connection (if it is still idle).
+  void expire(uint64_t id, uint64_t idle);
+
+  // Shuts down a connection; it gets destroyed once the outstanding
+  // read (or connect) completes.
+  void close(Connection* connection);
+
+  // Fails (or requeues) any outstanding requests and releases the
+  // connection.
+  void destroy(Connection* connection, const string& failure);
+
+  hashmap<uint64_t, Connection*> connections;
+  map<Node, Host> hosts;
+  uint64_t ids;
 };
 
 
@@ -320,7 +448,22 @@ public:
   void exited(const Node& node);
   void exited(ProcessBase* process);
 
+  // Closes an idle temporary socket (if it is still idle).
+  void expire(int s, uint64_t generation);
+
+  // Returns the counters of temporary sockets that have been opened,
+  // reused, and closed (see metrics::sockets).
+  JSON::Object snapshot();
+
 private:
+  // Keeps a temporary socket with nothing left to send open so that
+  // it can be reused by the next message to the node, evicting the
+  // least recently used idle socket if there are too many.
+  void idle(int s);
+
+  // Forgets about an idle temporary socket and shuts it down.
+  void release(int s);
+
   // Map from UPID (local/remote) to process.
   map<UPID, set<ProcessBase*> > links;
 
@@ -336,9 +479,29 @@ private:
   map<int, Node> nodes;
 
   // Maps from node (ip, port) to temporary sockets (i.e., they will
-  // get closed once there is no more data to send on them).
+  // get closed once they have not been used for a while).
   map<Node, int> temps;
 
+  // Temporary sockets with no more data to send, least recently used
+  // first, along with the generation of each. A new generation gets
+  // used whenever a socket goes idle so that stale timeouts can be
+  // ignored.
+  list<int> lru;
+  map<int, pair<list<int>::iterator, uint64_t> > idles;
+  uint64_t generations;
+
+  // Maximum number of idle sockets, see SocketManager::SocketManager.
+  const size_t maxIdles;
+
+  // Counters of temporary socket churn.
+  struct {
+    uint64_t opened;
+    uint64_t reused;
+    uint64_t expired;
+    uint64_t evicted;
+    uint64_t closed; // By the remote end or because of an error.
+  } counters;
+
   // Maps from node (ip, port) to persistent sockets (i.e., they will
   // remain open even if there is no more data to send on them).  We
   // distinguish these from the 'temps' collection so we can tell when
@@ -357,6 +520,46 @@ private:
 };
 
 
+// A shard of the local processes. Processes get assigned to a shard
+// by the hash of their id so that looking up, spawning and cleaning
+// up processes only contends with processes in the same shard rather
+// than with every delivery in the system.
+class ProcessShard
+{
+public:
+  ProcessShard();
+
+  // Returns a reference to the process with the specified id, if it
+  // exists in this shard.
+  ProcessReference use(const string& id);
+
+  // Adds the process, returning false if a process with the same id
+  // already exists.
+  bool add(ProcessBase* process);
+
+  // Removes the (terminating) process once all references have been
+  // cleaned up, generating exited events and opening the gate for
+  // any waiting threads (see ProcessManager::cleanup).
+  void remove(ProcessBase* process);
+
+  // Approaches the gate for the process with the specified id (if it
+  // exists), returning a reference to the process.
+  ProcessReference approach(
+      const string& id,
+      Gate** gate,
+      Gate::state_t* old);
+
+private:
+  // Processes in this shard.
+  hashmap<string, ProcessBase*> processes;
+
+  // Gates for waiting threads.
+  map<ProcessBase*, Gate*> gates;
+
+  synchronizable(this);
+};
+
+
 class ProcessManager
 {
 public:
@@ -395,12 +598,13 @@ private:
   // Delegate process name to receive root HTTP requests.
   const string delegate;
 
-  // Map of all local spawned and running processes.
-  map<string, ProcessBase*> processes;
-  synchronizable(processes);
+  // Returns the shard for the process with the specified id.
+  ProcessShard& shard(const string& id);
 
-  // Gates for waiting threads (protected by synchronizable(processes)).
-  map<ProcessBase*, Gate*> gates;
+  // All local spawned and running processes, sharded (see
+  // ProcessShard) to reduce contention.
+  static const size_t SHARDS = 64;
+  ProcessShard shards[SHARDS];
 
   // Queue of runnable processes (implemented using list).
   list<ProcessBase*> runq;
@@ -469,9 +673,16 @@ static Gate* gate = new Gate();
 static Filter* filterer = NULL;
 static synchronizable(filterer) = SYNCHRONIZED_INITIALIZER_RECURSIVE;
 
+// Compression level used for HTTP responses, zero disables
+// compression (see LIBPROCESS_GZIP_LEVEL).
+static int gzip_level = -1; // Default compression.
+
 // Global garbage collector.
 PID<GarbageCollector> gc;
 
+// Global HTTP connection pool.
+PID<HttpConnectionPool> http_connection_pool;
+
 // Per thread process pointer.
 ThreadLocal<ProcessBase>* _process_ = new ThreadLocal<ProcessBase>();
 
@@ -490,7 +701,9 @@ map<ProcessBase*, Time>* currents = new map<ProcessBase*, Time>();
 Time initial = Time::EPOCH;
 Time current = Time::EPOCH;
 
-bool paused = false;
+// Written while synchronized on 'timeouts', but read without any
+// synchronization by Clock::now (see below).
+volatile bool paused = false;
 
 } // namespace clock {
 
@@ -509,31 +722,39 @@ Time Clock::now()
 
 Time Clock::now(ProcessBase* process)
 {
-  synchronized (timeouts) {
-    if (Clock::paused()) {
-      if (process != NULL) {
-        if (clock::currents->count(process) != 0) {
-          return (*clock::currents)[process];
+  // Only synchronize if the clock is paused (i.e., when testing) so
+  // that the common case doesn't contend on 'timeouts'. Note that we
+  // check again once synchronized in case the clock got resumed.
+  if (Clock::paused()) {
+    synchronized (timeouts) {
+      if (Clock::paused()) {
+        if (process != NULL) {
+          if (clock::currents->count(process) != 0) {
+            return (*clock::currents)[process];
+          } else {
+            return (*clock::currents)[process] = clock::initial;
+          }
         } else {
-          return (*clock::currents)[process] = clock::initial;
+          return clock::current;
         }
-      } else {
-        return clock::current;
       }
     }
   }
 
   // TODO(benh): Versus ev_now()?
-  double d = ev_time();
-  Try<Time> time = Time::create(d);
-
-  // TODO(xujyan): Move CHECK_SOME to libprocess and add CHECK_SOME
-  // here.
-  if (time.isError()) {
-    LOG(FATAL) << "Failed to create a Time from " << d << ": "
-               << time.error();
-  }
-  return time.get();
+  // NOTE: We read the clock directly (rather than using ev_time and
+  // Time::create) to avoid converting through a double and the
+  // allocations of Try.
+#ifdef __MACH__
+  // OS X does not have clock_gettime.
+  timeval tv;
+  gettimeofday(&tv, NULL);
+  return Time(Seconds(tv.tv_sec) + Microseconds(tv.tv_usec));
+#else
+  timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return Time(Seconds(ts.tv_sec) + Nanoseconds(ts.tv_nsec));
+#endif // __MACH__
 }
 
 
@@ -659,12 +880,21 @@ static Message* encode(const UPID& from,
   message->to = to;
   message->name = name;
   message->body = data;
+  message->span = tracer::span();
   return message;
 }
 
 
 static void transport(Message* message, ProcessBase* sender = NULL)
 {
+  if (tracer::enabled) {
+    tracer::record(
+        tracer::SEND,
+        message->span,
+        message->to.id,
+        "message " + message->name);
+  }
+
   if (message->to.ip == __ip__ && message->to.port == __port__) {
     // Local message.
     process_manager->deliver(message->to, new MessageEvent(message), sender);
@@ -710,7 +940,16 @@ static Message* parse(Request* request)
     message->name = name;
     message->from = from;
     message->to = to;
-    message->body = request->body;
+
+    // The request gets deleted once it's been parsed, no need to copy
+    // what can be a rather large body.
+    message->body.swap(request->body);
+
+    // Determine the span, if any (see MessageEncoder).
+    if (request->headers.contains("Libprocess-Span")) {
+      message->span = strtoull(
+          request->headers["Libprocess-Span"].c_str(), NULL, 16);
+    }
 
     return message;
   }
@@ -855,13 +1094,32 @@ void recv_data(struct ev_loop* loop, ev_io* watcher, int revents)
 
   int s = watcher->fd;
 
+  // Only the event loop receives, so all of the sockets can share
+  // this buffer (the decoder copies out whatever it still needs
+  // before 'decode' returns).
+  static char data[80 * 1024];
+
   while (true) {
-    const ssize_t size = 80 * 1024;
-    ssize_t length = 0;
+    // When the decoder is expecting the rest of a body, receive that
+    // directly into the request so that it doesn't get copied, and
+    // whatever comes after it (e.g., the next request) into 'data'.
+    struct iovec iov[2];
+    int count = 0;
+
+    size_t remaining = 0;
+    char* body = decoder->body(&remaining);
+
+    if (body != NULL) {
+      iov[count].iov_base = body;
+      iov[count].iov_len = remaining;
+      count++;
+    }
 
-    char data[size];
+    iov[count].iov_base = data;
+    iov[count].iov_len = sizeof(data);
+    count++;
 
-    length = recv(s, data, size, 0);
+    ssize_t length = readv(s, iov, count);
 
     if (length < 0 && (errno == EINTR)) {
       // Interrupted, try again now.
@@ -886,7 +1144,18 @@ void recv_data(struct ev_loop* loop, ev_io* watcher, int revents)
       CHECK(length > 0);
 
       // Decode as much of the data as possible into HTTP requests.
-      const deque<Request*>& requests = decoder->decode(data, length);
+      deque<Request*> requests;
+
+      if (body != NULL) {
+        size_t size = std::min((size_t) length, remaining);
+        requests = decoder->decode(body, size);
+        length -= size;
+      }
+
+      if (length > 0 && !decoder->failed()) {
+        const deque<Request*>& more = decoder->decode(data, length);
+        requests.insert(requests.end(), more.begin(), more.end());
+      }
 
       if (!requests.empty()) {
         foreach (Request* request, requests) {
@@ -1127,8 +1396,11 @@ void accept(struct ev_loop* loop, ev_io* watcher, int revents)
     // Inform the socket manager for proper bookkeeping.
     const Socket& socket = socket_manager->accepted(s);
 
-    // Allocate and initialize the decoder and watcher.
-    DataDecoder* decoder = new DataDecoder(socket);
+    // Allocate and initialize the decoder and watcher. Decoding the
+    // query and body of each request is deferred until the request
+    // gets handled so that we don't do it on the I/O thread (see
+    // ProcessBase::visit).
+    DataDecoder* decoder = new DataDecoder(socket, true);
 
     ev_io* watcher = new ev_io();
     watcher->data = decoder;
@@ -1285,6 +1557,37 @@ void initialize(const string& delegate)
     __port__ = result;
   }
 
+  // Check environment for whether or not to account for events.
+  accounting::enabled =
+    os::getenv("LIBPROCESS_ENABLE_ACCOUNTING", false) == "1";
+
+  // Check environment for the number of threads to use for blocking
+  // functions executed via 'async'.
+  size_t threads = 8;
+
+  value = getenv("LIBPROCESS_ASYNC_THREADS");
+  if (value != NULL) {
+    Try<int> result = numify<int>(value);
+    if (result.isError() || result.get() <= 0) {
+      LOG(FATAL) << "LIBPROCESS_ASYNC_THREADS=" << value
+                 << " is not a valid number of threads";
+    }
+    threads = result.get();
+  }
+
+  blocking::initialize(threads);
+
+  // Check environment for the HTTP response compression level.
+  value = getenv("LIBPROCESS_GZIP_LEVEL");
+  if (value != NULL) {
+    Try<int> level = numify<int>(value);
+    if (level.isError() || level.get() < -1 || level.get() > 9) {
+      LOG(FATAL) << "LIBPROCESS_GZIP_LEVEL=" << value
+                 << " is not a valid compression level";
+    }
+    gzip_level = level.get();
+  }
+
   // Create a "server" socket for communicating with other nodes.
   if ((__s__ = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
     PLOG(FATAL) << "Failed to initialize, socket";
@@ -1406,6 +1709,21 @@ void initialize(const string& delegate)
   // Create the global profiler process.
   spawn(new Profiler(), true);
 
+  // Create the global HTTP connection pool.
+  http_connection_pool = spawn(new HttpConnectionPool(), true);
+
+  // Create the global metrics process.
+  spawn(new MetricsProcess(), true);
+
+  // Create the global process accounting process.
+  spawn(new ProcessesProcess(), true);
+
+  // Create the global tracer process.
+  spawn(new TraceProcess(), true);
+
+  // Create the global blocking thread pool process.
+  spawn(new AsyncProcess(), true);
+
   // Create the global statistics.
   // TODO(bmahler): Investigate memory implications of this window
   // size. We may also want to provide a maximum memory size rather than
@@ -1442,9 +1760,155 @@ uint16_t port()
 }
 
 
+// Minimum length of a response body before we bother compressing it.
+static const size_t GZIP_MINIMUM_BODY_LENGTH = 1024;
+
+
+// Returns a 64-bit FNV-1a hash of the data, which is independent of
+// 'std::tr1::hash' (used for the keys of the cache below).
+static uint64_t fnv1a(const string& data)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < data.length(); i++) {
+    hash ^= (unsigned char) data[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+
+// A compressed response body along with a digest of the body it was
+// compressed from (used to validate cache hits without keeping a copy
+// of the original body around).
+struct CompressedBody
+{
+  CompressedBody(uint64_t _digest, const string& _compressed)
+    : digest(_digest), compressed(_compressed) {}
+
+  const uint64_t digest;
+  const string compressed;
+};
+
+
+// Cache of recently compressed response bodies so that identical
+// responses (e.g., many clients polling the same endpoint) only get
+// compressed once. Entries are keyed by the response's 'ETag' header
+// if present or a hash of the body otherwise, along with the length
+// of the body.
+static cache<string, std::tr1::shared_ptr<CompressedBody> >* compressed_bodies =
+  new cache<string, std::tr1::shared_ptr<CompressedBody> >(16);
+static synchronizable(compressed_bodies) = SYNCHRONIZED_INITIALIZER;
+
+// Number of compressed bodies served from the cache (hits) and that
+// had to be compressed (misses).
+static uint64_t compressed_bodies_hits = 0;
+static uint64_t compressed_bodies_misses = 0;
+
+
+// Returns a copy of the response using the (already) compressed body.
+static Response gzipped(Response response, const string& compressed)
+{
+  response.body = compressed;
+  response.headers["Content-Length"] = stringify(compressed.length());
+  response.headers["Content-Encoding"] = "gzip";
+  return response;
+}
+
+
+// Compresses the body of the response, or reuses the cached result
+// of compressing an identical body. This gets invoked asynchronously
+// (i.e., via 'async') since hashing, let alone compressing, a large
+// body would otherwise block whichever thread satisfied the response
+// (see HttpProxy::handle). Returns the original response if the body
+// could not be compressed.
+static Response compress(const Response& response)
+{
+  Option<string> etag = response.headers.get("ETag");
+
+  const string key = (etag.isSome()
+    ? "etag:" + etag.get()
+    : stringify(std::tr1::hash<string>()(response.body))) + ":" +
+    stringify(response.body.length());
+
+  const uint64_t digest = fnv1a(response.body);
+
+  Option<std::tr1::shared_ptr<CompressedBody> > cached;
+  bool hit = false;
+  synchronized (compressed_bodies) {
+    cached = compressed_bodies->get(key);
+    hit = cached.isSome() && cached.get()->digest == digest;
+    if (hit) {
+      compressed_bodies_hits++;
+    } else {
+      compressed_bodies_misses++;
+    }
+  }
+
+  if (hit) {
+    return gzipped(response, cached.get()->compressed);
+  }
+
+  Try<string> compressed = gzip::compress(response.body, gzip_level);
+  if (compressed.isError()) {
+    LOG(WARNING) << "Failed to gzip response body: " << compressed.error();
+    return response;
+  }
+
+  synchronized (compressed_bodies) {
+    compressed_bodies->put(
+        key,
+        std::tr1::shared_ptr<CompressedBody>(
+            new CompressedBody(digest, compressed.get())));
+  }
+
+  return gzipped(response, compressed.get());
+}
+
+
+// Completes the promise with the compressed response, or with a '500
+// Internal Server Error' if compressing failed (HttpProxy::process
+// would otherwise answer a failed future with a '503 Service
+// Unavailable', as if the handler itself had failed).
+static void compressed(
+    const Future<Response>& future,
+    std::tr1::shared_ptr<Promise<Response> > promise)
+{
+  if (future.isReady()) {
+    promise->set(future.get());
+  } else {
+    LOG(WARNING) << "Failed to gzip response body: "
+                 << (future.isFailed() ? future.failure() : "discarded");
+    promise->set(InternalServerError());
+  }
+}
+
+
+// Prepares a response to be sent, which currently means compressing
+// large bodies if the request accepts it (see HttpProxy::handle).
+static Future<Response> prepare(const Response& response, bool gzip)
+{
+  if (gzip &&
+      gzip_level != 0 &&
+      response.type == Response::BODY &&
+      response.body.length() >= GZIP_MINIMUM_BODY_LENGTH &&
+      !response.headers.contains("Content-Encoding")) {
+    std::tr1::shared_ptr<Promise<Response> > promise(
+        new Promise<Response>());
+
+    async(&compress, response)
+      .onAny(lambda::bind(&compressed, lambda::_1, promise));
+
+    return promise->future();
+  }
+
+  return response;
+}
+
+
 HttpProxy::HttpProxy(const Socket& _socket)
   : ProcessBase(ID::generate("__http__")),
-    socket(_socket) {}
+    socket(_socket),
+    compressor(NULL) {}
 
 
 HttpProxy::~HttpProxy()
@@ -1456,6 +1920,9 @@ HttpProxy::~HttpProxy()
   }
   pipe = None();
 
+  delete compressor;
+  compressor = NULL;
+
   while (!items.empty()) {
     Item* item = items.front();
 
@@ -1484,7 +1951,19 @@ void HttpProxy::enqueue(const Response& response, const Request& request)
 
 void HttpProxy::handle(Future<Response>* future, const Request& request)
 {
-  items.push(new Item(request, future));
+  // Prepare the response as soon as it's ready, in whatever thread
+  // satisfies the future, rather than once it gets to the front of
+  // the queue. Responses still get sent in order (see 'next').
+  std::tr1::function<Future<Response>(const Response&)> f =
+    lambda::bind(&prepare, lambda::_1, request.accepts("gzip"));
+
+  Future<Response>* prepared = new Future<Response>(future->then(f));
+
+  // NOTE: Discarding the prepared future (see destructor) also
+  // discards the original future.
+  delete future;
+
+  items.push(new Item(request, prepared));
 
   if (items.size() == 1) {
     next();
@@ -1603,6 +2082,15 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
     // header, we fill in (or overwrite) 'Transfer-Encoding' header.
     response.headers["Transfer-Encoding"] = "chunked";
 
+    // Compress the stream (chunk by chunk) if possible.
+    CHECK(compressor == NULL);
+    if (gzip_level != 0 &&
+        !response.headers.contains("Content-Encoding") &&
+        request.accepts("gzip")) {
+      response.headers["Content-Encoding"] = "gzip";
+      compressor = new gzip::Compressor(gzip_level);
+    }
+
     VLOG(1) << "Starting \"chunked\" streaming";
 
     socket_manager->send(
@@ -1647,7 +2135,7 @@ void HttpProxy::stream(const Future<short>& poll, const Request& request)
             defer(self(), &Self::stream, lambda::_1, request));
         break;
       } else {
-        std::ostringstream out;
+        string chunk;
         if (length <= 0) {
           // Error or closed, treat both as closed.
           if (length < 0) {
@@ -1655,15 +2143,42 @@ void HttpProxy::stream(const Future<short>& poll, const Request& request)
             const char* error = strerror(errno);
             VLOG(1) << "Read error while streaming: " << error;
           }
-          out << "0\r\n" << "\r\n";
           finished = true;
+
+          // Flush anything remaining in the compressor.
+          if (compressor != NULL) {
+            Try<string> compressed = compressor->finish();
+            if (compressed.isError()) {
+              VLOG(1) << "Failed to gzip stream: " << compressed.error();
+            } else {
+              chunk = compressed.get();
+            }
+          }
+        } else if (compressor != NULL) {
+          // Data (to compress)!
+          Try<string> compressed = compressor->compress(string(data, length));
+          if (compressed.isError()) {
+            VLOG(1) << "Failed to gzip stream: " << compressed.error();
+            finished = true;
+          } else {
+            chunk = compressed.get();
+          }
         } else {
           // Data!
-          out << std::hex << length << "\r\n";
-          out.write(data, length);
+          chunk = string(data, length);
+        }
+
+        std::ostringstream out;
+        if (!chunk.empty()) {
+          out << std::hex << chunk.size() << "\r\n";
+          out.write(chunk.data(), chunk.size());
           out << "\r\n";
         }
 
+        if (finished) {
+          out << "0\r\n" << "\r\n";
+        }
+
         // We always persist the connection when we're not finished
         // streaming.
         socket_manager->send(
@@ -1684,123 +2199,581 @@ void HttpProxy::stream(const Future<short>& poll, const Request& request)
   if (finished) {
     os::close(pipe.get());
     pipe = None();
+    delete compressor;
+    compressor = NULL;
     next();
   }
 }
 
 
-SocketManager::SocketManager()
-{
-  synchronizer(this) = SYNCHRONIZED_INITIALIZER_RECURSIVE;
-}
+// Limits on the connections kept by the HTTP connection pool.
+static const size_t MAX_HTTP_CONNECTIONS = 1024;
+static const size_t MAX_HTTP_CONNECTIONS_PER_NODE = 8;
+static const size_t MAX_HTTP_PIPELINED_REQUESTS = 16;
 
+// Duration an idle HTTP connection is kept open for reuse.
+static const Duration HTTP_IDLE_CONNECTION_TIMEOUT = Seconds(30);
 
-SocketManager::~SocketManager() {}
 
+HttpConnectionPool::HttpConnectionPool()
+  : ProcessBase("__http_connection_pool__"),
+    ids(0) {}
 
-Socket SocketManager::accepted(int s)
+
+HttpConnectionPool::~HttpConnectionPool()
 {
-  synchronized (this) {
-    return sockets[s] = Socket(s);
+  foreachvalue (Connection* connection, connections) {
+    foreach (Item* item, connection->pending) {
+      item->promise.fail("HTTP connection pool terminated");
+      delete item;
+    }
+    os::close(connection->s);
+    delete connection;
+  }
+
+  foreachvalue (Host& host, hosts) {
+    foreach (Item* item, host.waiting) {
+      item->promise.fail("HTTP connection pool terminated");
+      delete item;
+    }
   }
 }
 
 
-void SocketManager::link(ProcessBase* process, const UPID& to)
+Future<Response> HttpConnectionPool::request(
+    const Node& node,
+    const string& data,
+    bool pipeline)
 {
-  // TODO(benh): The semantics we want to support for link are such
-  // that if there is nobody to link to (local or remote) then an
-  // ExitedEvent gets generated. This functionality has only been
-  // implemented when the link is local, not remote. Of course, if
-  // there is nobody listening on the remote side, then this should
-  // work remotely ... but if there is someone listening remotely just
-  // not at that id, then it will silently continue executing.
-
-  CHECK(process != NULL);
-
-  Node node(to.ip, to.port);
-
-  synchronized (this) {
-    // Check if node is remote and there isn't a persistant link.
-    if ((node.ip != __ip__ || node.port != __port__)
-        && persists.count(node) == 0) {
-      // Okay, no link, lets create a socket.
-      int s;
+  Item* item = new Item(data, pipeline);
+  Future<Response> future = item->promise.future();
 
-      if ((s = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
-        PLOG(FATAL) << "Failed to link, socket";
-      }
+  hosts[node].waiting.push_back(item);
+  schedule(node);
 
-      Try<Nothing> nonblock = os::nonblock(s);
-      if (nonblock.isError()) {
-        LOG(FATAL) << "Failed to link, nonblock: " << nonblock.error();
-      }
+  return future;
+}
 
-      Try<Nothing> cloexec = os::cloexec(s);
-      if (cloexec.isError()) {
-        LOG(FATAL) << "Failed to link, cloexec: " << cloexec.error();
-      }
 
-      sockets[s] = Socket(s);
-      nodes[s] = node;
+void HttpConnectionPool::schedule(const Node& node)
+{
+  Host& host = hosts[node];
 
-      persists[node] = s;
+  while (!host.waiting.empty()) {
+    Item* item = host.waiting.front();
 
-      // Allocate and initialize the decoder and watcher (we really
-      // only "receive" on this socket so that we can react when it
-      // gets closed and generate appropriate lost events).
-      DataDecoder* decoder = new DataDecoder(sockets[s]);
+    Connection* connection = NULL;
 
-      ev_io* watcher = new ev_io();
-      watcher->data = decoder;
+    // Creating a connection might fail, in which case we fail the
+    // request rather than waiting for some other connection.
+    Try<Connection*> selected = select(node, item);
+    if (selected.isError()) {
+      host.waiting.pop_front();
+      item->promise.fail(selected.error());
+      delete item;
+      continue;
+    }
 
-      // Try and connect to the node using this socket.
-      sockaddr_in addr;
-      memset(&addr, 0, sizeof(addr));
-      addr.sin_family = PF_INET;
-      addr.sin_port = htons(to.port);
-      addr.sin_addr.s_addr = to.ip;
+    connection = selected.get();
 
-      if (connect(s, (sockaddr*) &addr, sizeof(addr)) < 0) {
-        if (errno != EINPROGRESS) {
-          PLOG(FATAL) << "Failed to link, connect";
-        }
+    if (connection == NULL) {
+      break; // Wait for a connection to become available.
+    }
 
-        // Wait for socket to be connected.
-        ev_io_init(watcher, receiving_connect, s, EV_WRITE);
-      } else {
-        ev_io_init(watcher, recv_data, s, EV_READ);
-      }
+    host.waiting.pop_front();
 
-      // Enqueue the watcher.
-      synchronized (watchers) {
-        watchers->push(watcher);
-      }
+    connection->pending.push_back(item);
+    connection->outgoing.append(item->data);
+    connection->idle++;
 
-      // Interrupt the loop.
-      ev_async_send(loop, &async_watcher);
+    if (connection->connected && !connection->writing) {
+      write(connection);
     }
+  }
 
-    links[to].insert(process);
+  if (host.waiting.empty() && host.connections.empty()) {
+    hosts.erase(node);
   }
 }
 
 
-PID<HttpProxy> SocketManager::proxy(const Socket& socket)
+Try<HttpConnectionPool::Connection*> HttpConnectionPool::select(
+    const Node& node,
+    Item* item)
 {
-  HttpProxy* proxy = NULL;
+  Host& host = hosts[node];
 
-  synchronized (this) {
-    // This socket might have been asked to get closed (e.g., remote
-    // side hang up) while a process is attempting to handle an HTTP
-    // request. Thus, if there is no more socket, return an empty PID.
-    if (sockets.count(socket) > 0) {
-      if (proxies.count(socket) > 0) {
-        return proxies[socket]->self();
-      } else {
-        proxy = new HttpProxy(sockets[socket]);
-        proxies[socket] = proxy;
-      }
+  // Prefer an idle connection.
+  foreach (uint64_t id, host.connections) {
+    Connection* connection = connections[id];
+    if (!connection->closing && connection->pending.empty()) {
+      return connection;
+    }
+  }
+
+  // Otherwise try and create a new connection. If we've reached the
+  // total limit, close an idle connection to some other node so that
+  // a connection will become available.
+  if (host.connections.size() < MAX_HTTP_CONNECTIONS_PER_NODE) {
+    if (connections.size() < MAX_HTTP_CONNECTIONS) {
+      return connect(node);
+    }
+
+    foreachvalue (Connection* connection, connections) {
+      if (!connection->closed && connection->pending.empty()) {
+        close(connection);
+        break;
+      }
+    }
+  }
+
+  // Otherwise pipeline the request behind other pipelined requests
+  // on the least loaded connection.
+  Connection* selected = NULL;
+
+  if (item->pipeline) {
+    foreach (uint64_t id, host.connections) {
+      Connection* connection = connections[id];
+      if (!connection->closing &&
+          connection->pending.back()->pipeline &&
+          connection->pending.size() < MAX_HTTP_PIPELINED_REQUESTS &&
+          (selected == NULL ||
+           connection->pending.size() < selected->pending.size())) {
+        selected = connection;
+      }
+    }
+  }
+
+  return selected;
+}
+
+
+Try<HttpConnectionPool::Connection*> HttpConnectionPool::connect(
+    const Node& node)
+{
+  int s = ::socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+
+  if (s < 0) {
+    return ErrnoError("Failed to create socket");
+  }
+
+  Try<Nothing> nonblock = os::nonblock(s);
+  if (nonblock.isError()) {
+    os::close(s);
+    return Error("Failed to set nonblock: " + nonblock.error());
+  }
+
+  Try<Nothing> cloexec = os::cloexec(s);
+  if (cloexec.isError()) {
+    os::close(s);
+    return Error("Failed to cloexec: " + cloexec.error());
+  }
+
+  // Requests are small and latency sensitive, so disable Nagle.
+  int on = 1;
+  if (setsockopt(s, SOL_TCP, TCP_NODELAY, &on, sizeof(on)) < 0) {
+    PLOG(WARNING) << "Failed to set TCP_NODELAY for HTTP connection";
+  }
+
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(node.port);
+  addr.sin_addr.s_addr = node.ip;
+
+  if (::connect(s, (sockaddr*) &addr, sizeof(addr)) < 0 &&
+      errno != EINPROGRESS) {
+    ErrnoError error("Failed to connect");
+    os::close(s);
+    return error;
+  }
+
+  Connection* connection = new Connection(++ids, node, s);
+
+  connections[connection->id] = connection;
+  hosts[node].connections.insert(connection->id);
+
+  io::poll(s, io::WRITE)
+    .onAny(defer(self(), &Self::connected, connection->id, lambda::_1));
+
+  return connection;
+}
+
+
+void HttpConnectionPool::connected(uint64_t id, const Future<short>& poll)
+{
+  CHECK(connections.contains(id));
+  Connection* connection = connections[id];
+
+  if (connection->closed) {
+    destroy(connection, "HTTP connection closed");
+    return;
+  }
+
+  if (!poll.isReady()) {
+    destroy(connection, "Failed to connect: " +
+            (poll.isFailed() ? poll.failure() : "discarded"));
+    return;
+  }
+
+  int error = 0;
+  socklen_t length = sizeof(error);
+  if (getsockopt(connection->s, SOL_SOCKET, SO_ERROR, &error, &length) < 0) {
+    error = errno;
+  }
+
+  if (error != 0) {
+    destroy(connection, string("Failed to connect: ") + strerror(error));
+    return;
+  }
+
+  connection->connected = true;
+
+  read(connection);
+
+  if (!connection->outgoing.empty()) {
+    write(connection);
+  }
+}
+
+
+void HttpConnectionPool::write(Connection* connection)
+{
+  while (!connection->outgoing.empty()) {
+    ssize_t length = ::send(
+        connection->s,
+        connection->outgoing.data(),
+        connection->outgoing.size(),
+        MSG_NOSIGNAL);
+
+    if (length < 0 && errno == EINTR) {
+      continue;
+    } else if (length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      connection->writing = true;
+      io::poll(connection->s, io::WRITE)
+        .onAny(defer(self(), &Self::_write, connection->id, lambda::_1));
+      return;
+    } else if (length <= 0) {
+      // The pending requests get failed once the read notices.
+      PLOG(WARNING) << "Failed to write HTTP request";
+      connection->writing = false;
+      close(connection);
+      return;
+    }
+
+    connection->outgoing.erase(0, length);
+  }
+
+  connection->writing = false;
+}
+
+
+void HttpConnectionPool::_write(uint64_t id, const Future<short>& poll)
+{
+  // The connection might have been destroyed while we were polling.
+  if (!connections.contains(id)) {
+    return;
+  }
+
+  Connection* connection = connections[id];
+
+  connection->writing = false;
+
+  if (connection->closed) {
+    return;
+  } else if (!poll.isReady()) {
+    close(connection);
+    return;
+  }
+
+  write(connection);
+}
+
+
+void HttpConnectionPool::read(Connection* connection)
+{
+  io::read(connection->s, connection->buffer.get(), io::BUFFERED_READ_SIZE)
+    .onAny(defer(self(), &Self::_read, connection->id, lambda::_1));
+}
+
+
+void HttpConnectionPool::_read(uint64_t id, const Future<size_t>& length)
+{
+  CHECK(connections.contains(id));
+  Connection* connection = connections[id];
+
+  if (!length.isReady()) {
+    destroy(connection, "Failed to read HTTP response: " +
+            (length.isFailed() ? length.failure() : "discarded"));
+    return;
+  }
+
+  // NOTE: Decoding zero bytes signals EOF to the decoder, which
+  // completes a response that is delimited by the connection close.
+  deque<Response*> responses =
+    connection->decoder.decode(connection->buffer.get(), length.get());
+
+  foreach (Response* response, responses) {
+    if (connection->pending.empty()) {
+      LOG(WARNING) << "Received unexpected HTTP response";
+      delete response;
+      continue;
+    }
+
+    Item* item = connection->pending.front();
+    connection->pending.pop_front();
+
+    Option<string> header = response->headers.get("Connection");
+    if (header.isSome() && strings::contains(header.get(), "close")) {
+      connection->closing = true;
+    }
+
+    item->promise.set(*response);
+    delete item;
+    delete response;
+  }
+
+  if (length.get() == 0) {
+    destroy(connection, "HTTP connection closed by peer");
+    return;
+  }
+
+  if (connection->decoder.failed()) {
+    LOG(WARNING) << "Failed to decode HTTP response";
+    close(connection);
+  } else if (connection->closing && connection->pending.empty()) {
+    close(connection);
+  } else if (connection->pending.empty()) {
+    delay(HTTP_IDLE_CONNECTION_TIMEOUT,
+          self(),
+          &Self::expire,
+          connection->id,
+          connection->idle);
+  }
+
+  // Keep reading until EOF; a closed connection gets destroyed once
+  // the read notices the shutdown.
+  read(connection);
+
+  // A response might have made room for waiting requests.
+  schedule(connection->node);
+}
+
+
+void HttpConnectionPool::expire(uint64_t id, uint64_t idle)
+{
+  if (connections.contains(id)) {
+    Connection* connection = connections[id];
+    if (connection->idle == idle && connection->pending.empty()) {
+      close(connection);
+    }
+  }
+}
+
+
+void HttpConnectionPool::close(Connection* connection)
+{
+  if (!connection->closed) {
+    connection->closed = true;
+    connection->closing = true;
+
+    hosts[connection->node].connections.erase(connection->id);
+
+    // Any outstanding poll or read will now complete.
+    ::shutdown(connection->s, SHUT_RDWR);
+  }
+}
+
+
+void HttpConnectionPool::destroy(
+    Connection* connection,
+    const string& failure)
+{
+  close(connection);
+
+  const Node node = connection->node;
+
+  // The first outstanding request may or may not have been processed
+  // so we fail it, but the remaining (pipelined) requests were never
+  // answered and are safe to send again on another connection.
+  if (!connection->pending.empty()) {
+    Item* item = connection->pending.front();
+    connection->pending.pop_front();
+    item->promise.fail(failure);
+    delete item;
+
+    Host& host = hosts[node];
+    while (!connection->pending.empty()) {
+      host.waiting.push_front(connection->pending.back());
+      connection->pending.pop_back();
+    }
+  }
+
+  os::close(connection->s);
+  connections.erase(connection->id);
+  delete connection;
+
+  // Requests waiting on the total limit (for any node) might be able
+  // to make progress now.
+  vector<Node> nodes;
+  nodes.push_back(node);
+  foreachpair (const Node& other, const Host& host, hosts) {
+    if (!host.waiting.empty()) {
+      nodes.push_back(other);
+    }
+  }
+
+  foreach (const Node& other, nodes) {
+    schedule(other);
+  }
+}
+
+// Limits on the idle temporary sockets kept open for reuse by the
+// socket manager (i.e., sockets to nodes that aren't linked to).
+static const size_t MAX_IDLE_SOCKETS = 1024;
+static const Duration IDLE_SOCKET_TIMEOUT = Seconds(30);
+
+
+// Returns how many idle temporary sockets can be kept open: a quarter
+// of the file descriptors the process may open (so that idle sockets
+// alone can't exhaust them), but no more than MAX_IDLE_SOCKETS.
+static size_t maxIdleSockets()
+{
+  struct rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+    PLOG(WARNING) << "Failed to get the file descriptor limit";
+    return MAX_IDLE_SOCKETS;
+  }
+
+  if (limit.rlim_cur == RLIM_INFINITY ||
+      limit.rlim_cur / 4 >= MAX_IDLE_SOCKETS) {
+    return MAX_IDLE_SOCKETS;
+  }
+
+  return std::max<size_t>(1, limit.rlim_cur / 4);
+}
+
+
+SocketManager::SocketManager()
+  : generations(0),
+    maxIdles(maxIdleSockets())
+{
+  synchronizer(this) = SYNCHRONIZED_INITIALIZER_RECURSIVE;
+
+  counters.opened = 0;
+  counters.reused = 0;
+  counters.expired = 0;
+  counters.evicted = 0;
+  counters.closed = 0;
+}
+
+
+SocketManager::~SocketManager() {}
+
+
+Socket SocketManager::accepted(int s)
+{
+  synchronized (this) {
+    return sockets[s] = Socket(s);
+  }
+}
+
+
+void SocketManager::link(ProcessBase* process, const UPID& to)
+{
+  // TODO(benh): The semantics we want to support for link are such
+  // that if there is nobody to link to (local or remote) then an
+  // ExitedEvent gets generated. This functionality has only been
+  // implemented when the link is local, not remote. Of course, if
+  // there is nobody listening on the remote side, then this should
+  // work remotely ... but if there is someone listening remotely just
+  // not at that id, then it will silently continue executing.
+
+  CHECK(process != NULL);
+
+  Node node(to.ip, to.port);
+
+  synchronized (this) {
+    // Check if node is remote and there isn't a persistant link.
+    if ((node.ip != __ip__ || node.port != __port__)
+        && persists.count(node) == 0) {
+      // Okay, no link, lets create a socket.
+      int s;
+
+      if ((s = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+        PLOG(FATAL) << "Failed to link, socket";
+      }
+
+      Try<Nothing> nonblock = os::nonblock(s);
+      if (nonblock.isError()) {
+        LOG(FATAL) << "Failed to link, nonblock: " << nonblock.error();
+      }
+
+      Try<Nothing> cloexec = os::cloexec(s);
+      if (cloexec.isError()) {
+        LOG(FATAL) << "Failed to link, cloexec: " << cloexec.error();
+      }
+
+      sockets[s] = Socket(s);
+      nodes[s] = node;
+
+      persists[node] = s;
+
+      // Allocate and initialize the decoder and watcher (we really
+      // only "receive" on this socket so that we can react when it
+      // gets closed and generate appropriate lost events).
+      DataDecoder* decoder = new DataDecoder(sockets[s]);
+
+      ev_io* watcher = new ev_io();
+      watcher->data = decoder;
+
+      // Try and connect to the node using this socket.
+      sockaddr_in addr;
+      memset(&addr, 0, sizeof(addr));
+      addr.sin_family = PF_INET;
+      addr.sin_port = htons(to.port);
+      addr.sin_addr.s_addr = to.ip;
+
+      if (connect(s, (sockaddr*) &addr, sizeof(addr)) < 0) {
+        if (errno != EINPROGRESS) {
+          PLOG(FATAL) << "Failed to link, connect";
+        }
+
+        // Wait for socket to be connected.
+        ev_io_init(watcher, receiving_connect, s, EV_WRITE);
+      } else {
+        ev_io_init(watcher, recv_data, s, EV_READ);
+      }
+
+      // Enqueue the watcher.
+      synchronized (watchers) {
+        watchers->push(watcher);
+      }
+
+      // Interrupt the loop.
+      ev_async_send(loop, &async_watcher);
+    }
+
+    links[to].insert(process);
+  }
+}
+
+
+PID<HttpProxy> SocketManager::proxy(const Socket& socket)
+{
+  HttpProxy* proxy = NULL;
+
+  synchronized (this) {
+    // This socket might have been asked to get closed (e.g., remote
+    // side hang up) while a process is attempting to handle an HTTP
+    // request. Thus, if there is no more socket, return an empty PID.
+    if (sockets.count(socket) > 0) {
+      if (proxies.count(socket) > 0) {
+        return proxies[socket]->self();
+      } else {
+        proxy = new HttpProxy(sockets[socket]);
+        proxies[socket] = proxy;
+      }
     }
   }
 
@@ -1888,7 +2861,17 @@ void SocketManager::send(Message* message)
     if (persist || temp) {
       int s = persist ? persists[node] : temps[node];
       CHECK(sockets.count(s) > 0);
-      send(new MessageEncoder(sockets[s], message), persist);
+
+      // Temporary sockets don't get disposed when there is no more
+      // data to send (see SocketManager::next), so reusing an idle
+      // one just means it's no longer idle.
+      if (idles.count(s) > 0) {
+        lru.erase(idles[s].first);
+        idles.erase(s);
+        counters.reused++;
+      }
+
+      send(new MessageEncoder(sockets[s], message), true);
     } else {
       // No peristant or temporary socket to the node currently
       // exists, so we create a temporary one.
@@ -1912,7 +2895,7 @@ void SocketManager::send(Message* message)
       nodes[s] = node;
       temps[node] = s;
 
-      dispose.insert(s);
+      counters.opened++;
 
       // Initialize the outgoing queue.
       outgoing[s];
@@ -1921,6 +2904,12 @@ void SocketManager::send(Message* message)
       ev_io* watcher = new ev_io();
       watcher->data = new MessageEncoder(sockets[s], message);
 
+      // Like for persistent sockets (see SocketManager::link), we
+      // also "receive" on temporary sockets so that we notice when
+      // the remote end closes them while they are idle.
+      ev_io* receiver = new ev_io();
+      receiver->data = new DataDecoder(sockets[s]);
+
       // Try and connect to the node using this socket.
       sockaddr_in addr;
       memset(&addr, 0, sizeof(addr));
@@ -1933,16 +2922,19 @@ void SocketManager::send(Message* message)
           PLOG(FATAL) << "Failed to send, connect";
         }
 
-        // Initialize watcher for connecting.
+        // Initialize watchers for connecting.
         ev_io_init(watcher, sending_connect, s, EV_WRITE);
+        ev_io_init(receiver, receiving_connect, s, EV_WRITE);
       } else {
-        // Initialize watcher for sending.
+        // Initialize watchers for sending and receiving.
         ev_io_init(watcher, send_data, s, EV_WRITE);
+        ev_io_init(receiver, recv_data, s, EV_READ);
       }
 
-      // Enqueue the watcher.
+      // Enqueue the watchers.
       synchronized (watchers) {
         watchers->push(watcher);
+        watchers->push(receiver);
       }
 
       ev_async_send(loop, &async_watcher);
@@ -1981,17 +2973,15 @@ Encoder* SocketManager::next(int s)
         // No more messages ... erase the outgoing queue.
         outgoing.erase(s);
 
-        if (dispose.count(s) > 0) {
-          // This is either a temporary socket we created or it's a
-          // socket that we were receiving data from and possibly
-          // sending HTTP responses back on. Clean up either way.
-          if (nodes.count(s) > 0) {
-            const Node& node = nodes[s];
-            CHECK(temps.count(node) > 0 && temps[node] == s);
-            temps.erase(node);
-            nodes.erase(s);
-          }
-
+        if (nodes.count(s) > 0 &&
+            temps.count(nodes[s]) > 0 &&
+            temps[nodes[s]] == s) {
+          // This is a temporary socket we created, keep it around in
+          // case there are more messages to send to the node.
+          idle(s);
+        } else if (dispose.count(s) > 0) {
+          // This is a socket that we were receiving data from and
+          // possibly sending HTTP responses back on, clean up.
           if (proxies.count(s) > 0) {
             proxy = proxies[s];
             proxies.erase(s);
@@ -2053,6 +3043,12 @@ void SocketManager::close(int s)
           exited(node); // Generate ExitedEvent(s)!
         } else if (temps.count(node) > 0 && temps[node] == s) {
           temps.erase(node);
+          counters.closed++;
+
+          if (idles.count(s) > 0) {
+            lru.erase(idles[s].first);
+            idles.erase(s);
+          }
         }
 
         nodes.erase(s);
@@ -2092,71 +3088,298 @@ void SocketManager::close(int s)
 }
 
 
+void SocketManager::expire(int s, uint64_t generation)
+{
+  synchronized (this) {
+    if (idles.count(s) > 0 && idles[s].second == generation) {
+      release(s);
+      counters.expired++;
+    }
+  }
+}
+
+
+JSON::Object SocketManager::snapshot()
+{
+  JSON::Object object;
+
+  synchronized (this) {
+    object.values["opened"] = counters.opened;
+    object.values["reused"] = counters.reused;
+    object.values["expired"] = counters.expired;
+    object.values["evicted"] = counters.evicted;
+    object.values["closed"] = counters.closed;
+    object.values["temporary"] = temps.size();
+    object.values["idle"] = idles.size();
+    object.values["max_idle"] = maxIdles;
+    object.values["persistent"] = persists.size();
+  }
+
+  return object;
+}
+
+
+void SocketManager::idle(int s)
+{
+  CHECK(idles.count(s) == 0);
+
+  const uint64_t generation = ++generations;
+
+  idles[s] = std::make_pair(lru.insert(lru.end(), s), generation);
+
+  // Close the socket if it's still idle after the timeout. Note
+  // that the timer doesn't get canceled when the socket gets reused,
+  // the generation tells whether or not the socket has been used
+  // since then.
+  Timer::create(
+      IDLE_SOCKET_TIMEOUT,
+      lambda::bind(&SocketManager::expire, this, s, generation));
+
+  if (idles.size() > maxIdles) {
+    release(lru.front());
+    counters.evicted++;
+  }
+}
+
+
+void SocketManager::release(int s)
+{
+  CHECK(idles.count(s) > 0);
+  CHECK(nodes.count(s) > 0);
+
+  lru.erase(idles[s].first);
+  idles.erase(s);
+
+  temps.erase(nodes[s]);
+  nodes.erase(s);
+
+  sockets.erase(s);
+
+  // We don't actually close the socket (we wait for the Socket
+  // abstraction to close it once there are no more references), but
+  // we do shutdown the receiving end so that the DataDecoder will
+  // get cleaned up (which has the last reference).
+  shutdown(s, SHUT_RD);
+}
+
+
+namespace metrics {
+
+JSON::Object sockets()
+{
+  return socket_manager->snapshot();
+}
+
+
+JSON::Object gzip()
+{
+  JSON::Object object;
+  synchronized (compressed_bodies) {
+    object.values["hits"] = compressed_bodies_hits;
+    object.values["misses"] = compressed_bodies_misses;
+  }
+  return object;
+}
+
+} // namespace metrics {
+
+
 void SocketManager::exited(const Node& node)
 {
-  // TODO(benh): It would be cleaner if this routine could call back
-  // into ProcessManager ... then we wouldn't have to convince
-  // ourselves that the accesses to each Process object will always be
-  // valid.
+  // TODO(benh): It would be cleaner if this routine could call back
+  // into ProcessManager ... then we wouldn't have to convince
+  // ourselves that the accesses to each Process object will always be
+  // valid.
+  synchronized (this) {
+    list<UPID> removed;
+    // Look up all linked processes.
+    foreachpair (const UPID& linkee, set<ProcessBase*>& processes, links) {
+      if (linkee.ip == node.ip && linkee.port == node.port) {
+        foreach (ProcessBase* linker, processes) {
+          linker->enqueue(new ExitedEvent(linkee));
+        }
+        removed.push_back(linkee);
+      }
+    }
+
+    foreach (const UPID& pid, removed) {
+      links.erase(pid);
+    }
+  }
+}
+
+
+void SocketManager::exited(ProcessBase* process)
+{
+  // An exited event is enough to cause the process to get deleted
+  // (e.g., by the garbage collector), which means we can't
+  // dereference process (or even use the address) after we enqueue at
+  // least one exited event. Thus, we save the process pid.
+  const UPID pid = process->pid;
+
+  // Likewise, we need to save the current time of the process so we
+  // can update the clocks of linked processes as appropriate.
+  const Time time = Clock::now(process);
+
+  synchronized (this) {
+    // Iterate through the links, removing any links the process might
+    // have had and creating exited events for any linked processes.
+    foreachpair (const UPID& linkee, set<ProcessBase*>& processes, links) {
+      processes.erase(process);
+
+      if (linkee == pid) {
+        foreach (ProcessBase* linker, processes) {
+          CHECK(linker != process) << "Process linked with itself";
+          synchronized (timeouts) {
+            if (Clock::paused()) {
+              Clock::update(linker, time);
+            }
+          }
+          linker->enqueue(new ExitedEvent(linkee));
+        }
+      }
+    }
+
+    links.erase(pid);
+  }
+}
+
+
+ProcessShard::ProcessShard()
+{
+  synchronizer(this) = SYNCHRONIZED_INITIALIZER_RECURSIVE;
+}
+
+
+ProcessReference ProcessShard::use(const string& id)
+{
+  synchronized (this) {
+    if (processes.contains(id)) {
+      // Note that the ProcessReference constructor _must_ get called
+      // while holding the lock on the shard so that waiting for
+      // references is atomic (i.e., race free).
+      return ProcessReference(processes[id]);
+    }
+  }
+
+  return ProcessReference(NULL);
+}
+
+
+bool ProcessShard::add(ProcessBase* process)
+{
+  synchronized (this) {
+    if (processes.contains(process->pid.id)) {
+      return false;
+    }
+    processes[process->pid.id] = process;
+  }
+
+  return true;
+}
+
+
+void ProcessShard::remove(ProcessBase* process)
+{
+  // Possible gate non-libprocess threads are waiting at.
+  Gate* gate = NULL;
+
+  // Remove process.
   synchronized (this) {
-    list<UPID> removed;
-    // Look up all linked processes.
-    foreachpair (const UPID& linkee, set<ProcessBase*>& processes, links) {
-      if (linkee.ip == node.ip && linkee.port == node.port) {
-        foreach (ProcessBase* linker, processes) {
-          linker->enqueue(new ExitedEvent(linkee));
-        }
-        removed.push_back(linkee);
+    // Wait for all process references to get cleaned up.
+    while (process->refs > 0) {
+      asm ("pause");
+      __sync_synchronize();
+    }
+
+    process->lock();
+    {
+      CHECK(process->events.empty());
+
+      processes.erase(process->pid.id);
+
+      // Lookup gate to wake up waiting threads.
+      map<ProcessBase*, Gate*>::iterator it = gates.find(process);
+      if (it != gates.end()) {
+        gate = it->second;
+        // N.B. The last thread that leaves the gate also free's it.
+        gates.erase(it);
       }
+
+      CHECK(process->refs == 0);
+      process->state = ProcessBase::TERMINATED;
     }
+    process->unlock();
 
-    foreach (const UPID& pid, removed) {
-      links.erase(pid);
+    // Note that we don't remove the process from the clock during
+    // cleanup, but rather the clock is reset for a process when it is
+    // created (see ProcessBase::ProcessBase). We do this so that
+    // SocketManager::exited can access the current time of the
+    // process to "order" exited events. TODO(benh): It might make
+    // sense to consider storing the time of the process as a field of
+    // the class instead.
+
+    // Now we tell the socket manager about this process exiting so
+    // that it can create exited events for linked processes. We
+    // _must_ do this while synchronized on the shard because
+    // otherwise another process could attempt to link this process
+    // and SocketManger::link would see that the processes doesn't
+    // exist when it attempts to get a ProcessReference (since we
+    // removed the process above) thus causing an exited event, which
+    // could cause the process to get deleted (e.g., the garbage
+    // collector might link _after_ the process has already been
+    // removed from processes thus getting an exited event but we
+    // don't want that exited event to fire and actually delete the
+    // process until after we have used the process in
+    // SocketManager::exited).
+    socket_manager->exited(process);
+
+    // ***************************************************************
+    // At this point we can no longer dereference the process since it
+    // might already be deallocated (e.g., by the garbage collector).
+    // ***************************************************************
+
+    // Note that we need to open the gate while synchronized on the
+    // shard because otherwise we might _open_ the gate before
+    // another thread _approaches_ the gate causing that thread to
+    // wait on _arrival_ to the gate forever (see
+    // ProcessManager::wait).
+    if (gate != NULL) {
+      gate->open();
     }
   }
 }
 
 
-void SocketManager::exited(ProcessBase* process)
+ProcessReference ProcessShard::approach(
+    const string& id,
+    Gate** gate,
+    Gate::state_t* old)
 {
-  // An exited event is enough to cause the process to get deleted
-  // (e.g., by the garbage collector), which means we can't
-  // dereference process (or even use the address) after we enqueue at
-  // least one exited event. Thus, we save the process pid.
-  const UPID pid = process->pid;
-
-  // Likewise, we need to save the current time of the process so we
-  // can update the clocks of linked processes as appropriate.
-  const Time time = Clock::now(process);
-
   synchronized (this) {
-    // Iterate through the links, removing any links the process might
-    // have had and creating exited events for any linked processes.
-    foreachpair (const UPID& linkee, set<ProcessBase*>& processes, links) {
-      processes.erase(process);
+    if (processes.contains(id)) {
+      ProcessBase* process = processes[id];
+      CHECK(process->state != ProcessBase::TERMINATED);
 
-      if (linkee == pid) {
-        foreach (ProcessBase* linker, processes) {
-          CHECK(linker != process) << "Process linked with itself";
-          synchronized (timeouts) {
-            if (Clock::paused()) {
-              Clock::update(linker, time);
-            }
-          }
-          linker->enqueue(new ExitedEvent(linkee));
-        }
+      // Check and see if a gate already exists.
+      if (gates.find(process) == gates.end()) {
+        gates[process] = new Gate();
       }
-    }
 
-    links.erase(pid);
+      *gate = gates[process];
+      *old = (*gate)->approach();
+
+      return ProcessReference(process);
+    }
   }
+
+  return ProcessReference(NULL);
 }
 
 
 ProcessManager::ProcessManager(const string& _delegate)
   : delegate(_delegate)
 {
-  synchronizer(processes) = SYNCHRONIZED_INITIALIZER_RECURSIVE;
   synchronizer(runq) = SYNCHRONIZED_INITIALIZER_RECURSIVE;
   running = 0;
   __sync_synchronize(); // Ensure write to 'running' visible in other threads.
@@ -2169,17 +3392,16 @@ ProcessManager::~ProcessManager() {}
 ProcessReference ProcessManager::use(const UPID& pid)
 {
   if (pid.ip == __ip__ && pid.port == __port__) {
-    synchronized (processes) {
-      if (processes.count(pid.id) > 0) {
-        // Note that the ProcessReference constructor _must_ get
-        // called while holding the lock on processes so that waiting
-        // for references is atomic (i.e., race free).
-        return ProcessReference(processes[pid.id]);
-      }
-    }
+    return shard(pid.id).use(pid.id);
   }
 
-  return ProcessReference(NULL);
+  return ProcessReference();
+}
+
+
+ProcessShard& ProcessManager::shard(const string& id)
+{
+  return shards[std::tr1::hash<string>()(id) % SHARDS];
 }
 
 
@@ -2195,6 +3417,13 @@ bool ProcessManager::handle(
     Message* message = parse(request);
     if (message != NULL) {
       delete request;
+      if (tracer::enabled) {
+        tracer::record(
+            tracer::RECEIVE,
+            message->span,
+            message->to.id,
+            "message " + message->name);
+      }
       // TODO(benh): Use the sender PID in order to capture
       // happens-before timing relationships for testing.
       return deliver(message->to, new MessageEvent(message));
@@ -2333,12 +3562,8 @@ UPID ProcessManager::spawn(ProcessBase* process, bool manage)
 {
   CHECK(process != NULL);
 
-  synchronized (processes) {
-    if (processes.count(process->pid.id) > 0) {
-      return UPID();
-    } else {
-      processes[process->pid.id] = process;
-    }
+  if (!shard(process->pid.id).add(process)) {
+    return UPID();
   }
 
   // Use the garbage collector if requested.
@@ -2441,6 +3666,33 @@ void ProcessManager::resume(ProcessBase* process)
       // Determine if we should terminate.
       terminate = event->is<TerminateEvent>();
 
+      // Account for the event if requested (see accounting.hpp).
+      Duration waited;
+      Duration cpu;
+      Stopwatch stopwatch;
+      if (accounting::enabled) {
+        Stopwatch mailbox = event->stopwatch;
+        waited = mailbox.elapsed();
+        cpu = accounting::cpu();
+        stopwatch.start();
+      }
+
+      // Serve the event as part of its span, starting a new span if
+      // the event doesn't have one and we're tracing.
+      const uint64_t span = event->span != 0 || !tracer::enabled
+        ? event->span
+        : tracer::generate();
+
+      tracer::span(span);
+
+      if (tracer::enabled) {
+        tracer::record(
+            tracer::DEQUEUE,
+            span,
+            process->pid.id,
+            accounting::key(*event));
+      }
+
       // Now service the event.
       try {
         process->serve(*event);
@@ -2455,6 +3707,25 @@ void ProcessManager::resume(ProcessBase* process)
         terminate = true;
       }
 
+      if (tracer::enabled) {
+        tracer::record(
+            tracer::SERVED,
+            span,
+            process->pid.id,
+            accounting::key(*event));
+      }
+
+      tracer::span(0);
+
+      if (accounting::enabled) {
+        accounting::record(
+            process->pid.id,
+            *event,
+            waited,
+            stopwatch.elapsed(),
+            accounting::cpu() - cpu);
+      }
+
       delete event;
 
       if (terminate) {
@@ -2501,73 +3772,8 @@ void ProcessManager::cleanup(ProcessBase* process)
     delete event;
   }
 
-  // Possible gate non-libprocess threads are waiting at.
-  Gate* gate = NULL;
-
   // Remove process.
-  synchronized (processes) {
-    // Wait for all process references to get cleaned up.
-    while (process->refs > 0) {
-      asm ("pause");
-      __sync_synchronize();
-    }
-
-    process->lock();
-    {
-      CHECK(process->events.empty());
-
-      processes.erase(process->pid.id);
- 
-      // Lookup gate to wake up waiting threads.
-      map<ProcessBase*, Gate*>::iterator it = gates.find(process);
-      if (it != gates.end()) {
-        gate = it->second;
-        // N.B. The last thread that leaves the gate also free's it.
-        gates.erase(it);
-      }
-
-      CHECK(process->refs == 0);
-      process->state = ProcessBase::TERMINATED;
-    }
-    process->unlock();
-
-    // Note that we don't remove the process from the clock during
-    // cleanup, but rather the clock is reset for a process when it is
-    // created (see ProcessBase::ProcessBase). We do this so that
-    // SocketManager::exited can access the current time of the
-    // process to "order" exited events. TODO(benh): It might make
-    // sense to consider storing the time of the process as a field of
-    // the class instead.
-
-    // Now we tell the socket manager about this process exiting so
-    // that it can create exited events for linked processes. We
-    // _must_ do this while synchronized on processes because
-    // otherwise another process could attempt to link this process
-    // and SocketManger::link would see that the processes doesn't
-    // exist when it attempts to get a ProcessReference (since we
-    // removed the process above) thus causing an exited event, which
-    // could cause the process to get deleted (e.g., the garbage
-    // collector might link _after_ the process has already been
-    // removed from processes thus getting an exited event but we
-    // don't want that exited event to fire and actually delete the
-    // process until after we have used the process in
-    // SocketManager::exited).
-    socket_manager->exited(process);
-
-    // ***************************************************************
-    // At this point we can no longer dereference the process since it
-    // might already be deallocated (e.g., by the garbage collector).
-    // ***************************************************************
-
-    // Note that we need to open the gate while synchronized on
-    // processes because otherwise we might _open_ the gate before
-    // another thread _approaches_ the gate causing that thread to
-    // wait on _arrival_ to the gate forever (see
-    // ProcessManager::wait).
-    if (gate != NULL) {
-      gate->open();
-    }
-  }
+  shard(process->pid.id).remove(process);
 }
 
 
@@ -2633,19 +3839,17 @@ bool ProcessManager::wait(const UPID& pid)
 
   ProcessBase* process = NULL; // Set to non-null if we donate thread.
 
-  // Try and approach the gate if necessary.
-  synchronized (processes) {
-    if (processes.count(pid.id) > 0) {
-      process = processes[pid.id];
-      CHECK(process->state != ProcessBase::TERMINATED);
-
-      // Check and see if a gate already exists.
-      if (gates.find(process) == gates.end()) {
-        gates[process] = new Gate();
-      }
+  // Try and approach the gate if necessary. Note that the reference
+  // keeps the process from getting cleaned up while we check if we
+  // can donate this thread, but it _must_ be released (i.e., go out
+  // of scope) before we run the process or arrive at the gate since
+  // cleanup waits for all references.
+  {
+    ProcessReference reference =
+      shard(pid.id).approach(pid.id, &gate, &old);
 
-      gate = gates[process];
-      old = gate->approach();
+    if (reference) {
+      process = reference;
 
       // Check if it is runnable in order to donate this thread.
       if (process->state == ProcessBase::BOTTOM ||
@@ -2868,6 +4072,22 @@ void ProcessBase::enqueue(Event* event, bool inject)
 {
   CHECK(event != NULL);
 
+  // Reading the clock on every enqueue isn't free, so only time the
+  // events that get accounted for (see 'accounting::enabled') and the
+  // HTTP requests whose queueing time always gets recorded (see
+  // ProcessBase::visit(const HttpEvent&)).
+  if (accounting::enabled || event->is<HttpEvent>()) {
+    event->stopwatch.start();
+  }
+
+  if (tracer::enabled) {
+    tracer::record(
+        tracer::ENQUEUE,
+        event->span,
+        pid.id,
+        accounting::key(*event));
+  }
+
   lock();
   {
     if (state != TERMINATING && state != TERMINATED) {
@@ -2937,6 +4157,23 @@ void ProcessBase::visit(const DispatchEvent& event)
 }
 
 
+// Records the metrics for a route once its response has completed
+// (see ProcessBase::visit below).
+static void completed(
+    const string& route,
+    Stopwatch stopwatch,
+    const Future<Response>& future)
+{
+  // Responses that are not ready get sent as a '503 Service
+  // Unavailable' (see HttpProxy::process).
+  const string& status = future.isReady()
+    ? future.get().status
+    : http::statuses[503];
+
+  metrics::completed(route, status.substr(0, 3), stopwatch.elapsed());
+}
+
+
 void ProcessBase::visit(const HttpEvent& event)
 {
   VLOG(1) << "Handling HTTP event for process '" << pid.id << "'"
@@ -2952,6 +4189,41 @@ void ProcessBase::visit(const HttpEvent& event)
   const string& name = tokens.size() > 1 ? tokens[1] : "";
 
   if (handlers.http.count(name) > 0) {
+    // Finish decoding the request now that we know it will get
+    // handled (see 'accept').
+    Try<Nothing> complete = DataDecoder::complete(event.request);
+    if (complete.isError()) {
+      VLOG(1) << "Returning '400 Bad Request' for '" << event.request->path
+              << "': " << complete.error();
+
+      // Get the HttpProxy pid for this socket.
+      PID<HttpProxy> proxy = socket_manager->proxy(event.socket);
+
+      // Enqueue the response with the HttpProxy so that it respects the
+      // order of requests to account for HTTP/1.1 pipelining.
+      dispatch(proxy, &HttpProxy::enqueue, BadRequest(), *event.request);
+      return;
+    }
+
+    // Record metrics for this route (see metrics.hpp), using the
+    // event's stopwatch to determine how long the request was queued.
+    // Processes with generated ids (see ID::generate) share the
+    // metrics of their prefix, otherwise there would be a new route
+    // for every instance.
+    string id = pid.id;
+    const size_t index = id.rfind('(');
+    if (index != string::npos &&
+        strings::endsWith(id, ")") &&
+        numify<int>(id.substr(index + 1, id.size() - index - 2)).isSome()) {
+      id = id.substr(0, index);
+    }
+
+    const string route = "/" + id + (name.empty() ? "" : "/" + name);
+
+    Stopwatch stopwatch = event.stopwatch;
+    metrics::started(route, stopwatch.elapsed());
+    stopwatch.start();
+
     // Create the promise to link with whatever gets returned, as well
     // as a future to wait for the response.
     std::tr1::shared_ptr<Promise<Response> > promise(
@@ -2959,6 +4231,11 @@ void ProcessBase::visit(const HttpEvent& event)
 
     Future<Response>* future = new Future<Response>(promise->future());
 
+    std::tr1::function<void(const Future<Response>&)> callback =
+      lambda::bind(&completed, route, stopwatch, lambda::_1);
+
+    future->onAny(callback);
+
     // Get the HttpProxy pid for this socket.
     PID<HttpProxy> proxy = socket_manager->proxy(event.socket);
 
@@ -3339,92 +4616,94 @@ namespace http {
 
 namespace internal {
 
-Future<Response> decode(const string& buffer)
+// Encodes an HTTP/1.1 request for the process with the given upid.
+string encode(
+    const string& method,
+    const UPID& upid,
+    const string& path,
+    const string& query,
+    const Option<string>& body,
+    const Option<string>& contentType)
 {
-  ResponseDecoder decoder;
-  deque<Response*> responses = decoder.decode(buffer.c_str(), buffer.length());
-
-  if (decoder.failed() || responses.empty()) {
-    for (size_t i = 0; i < responses.size(); ++i) {
-      delete responses[i];
-    }
-    return Future<Response>::failed(
-        "Failed to decode HTTP response:\n" + buffer + "\n");
-  } else if (responses.size() > 1) {
-    PLOG(ERROR) << "Received more than 1 HTTP Response";
-  }
-
-  Response response = *responses[0];
-  for (size_t i = 0; i < responses.size(); ++i) {
-    delete responses[i];
+  char ip[INET_ADDRSTRLEN];
+  if (inet_ntop(AF_INET, (in_addr*) &upid.ip, ip, INET_ADDRSTRLEN) == NULL) {
+    PLOG(FATAL) << "Failed to encode HTTP request, inet_ntop";
   }
 
-  return response;
-}
+  std::ostringstream out;
 
-} // namespace internal {
+  out << method << " /" << upid.id << "/" << path;
 
+  if (!query.empty()) {
+    out << "?" << query;
+  }
 
-Future<Response> get(const UPID& upid, const string& path, const string& query)
-{
-  int s = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+  out << " HTTP/1.1\r\n"
+      << "Host: " << ip << ":" << upid.port << "\r\n"
+      << "Connection: Keep-Alive\r\n";
 
-  if (s < 0) {
-    return Future<Response>::failed(
-        string("Failed to create socket: ") + strerror(errno));
+  if (contentType.isSome()) {
+    out << "Content-Type: " << contentType.get() << "\r\n";
   }
 
-  Try<Nothing> cloexec = os::cloexec(s);
-  if (!cloexec.isSome()) {
-    return Future<Response>::failed("Failed to cloexec: " + cloexec.error());
+  if (body.isSome()) {
+    out << "Content-Length: " << body.get().size() << "\r\n"
+        << "\r\n"
+        << body.get();
+  } else {
+    out << "\r\n";
   }
 
-  sockaddr_in addr;
-  memset(&addr, 0, sizeof(addr));
-  addr.sin_family = AF_INET;
-  addr.sin_port = htons(upid.port);
-  addr.sin_addr.s_addr = upid.ip;
+  return out.str();
+}
 
-  if (connect(s, (sockaddr*) &addr, sizeof(addr)) < 0) {
-    return Future<Response>::failed(
-        string("Failed to connect: ") + strerror(errno));
-  }
 
-  std::ostringstream out;
+Future<Response> request(
+    const string& method,
+    const UPID& upid,
+    const string& path,
+    const string& query,
+    const Option<string>& body,
+    const Option<string>& contentType)
+{
+  process::initialize();
 
-  // TODO(bmahler): Add the Host header for HTTP 1.1.
-  out << "GET /" << upid.id << "/" << path << "?" << query << " HTTP/1.1\r\n"
-      << "Connection: close\r\n"
-      << "\r\n";
+  // Only GET requests are pipelined since they are safe to resend
+  // if the connection gets closed before they are answered.
+  return dispatch(
+      http_connection_pool,
+      &HttpConnectionPool::request,
+      Node(upid.ip, upid.port),
+      encode(method, upid, path, query, body, contentType),
+      method == "GET");
+}
 
-  // TODO(bmahler): Use benh's async write when it gets committed.
-  const string& data = out.str();
-  int remaining = data.size();
+} // namespace internal {
 
-  while (remaining > 0) {
-    int n = write(s, data.data() + (data.size() - remaining), remaining);
 
-    if (n < 0) {
-      if (errno == EINTR) {
-        continue;
-      }
-      return Future<Response>::failed(
-          string("Failed to write: ") + strerror(errno));
-    }
+Future<Response> get(const UPID& upid, const string& path, const string& query)
+{
+  return internal::request("GET", upid, path, query, None(), None());
+}
 
-    remaining -= n;
-  }
 
-  Try<Nothing> nonblock = os::nonblock(s);
-  if (!nonblock.isSome()) {
-    return Future<Response>::failed(
-        "Failed to set nonblock: " + nonblock.error());
-  }
+Future<Response> post(
+    const UPID& upid,
+    const string& path,
+    const Option<string>& body,
+    const Option<string>& contentType)
+{
+  return internal::request("POST", upid, path, "", body, contentType);
+}
 
-  // Decode once the async read completes.
-  return io::read(s)
-    .then(lambda::bind(&internal::decode, lambda::_1))
-    .onAny(lambda::bind(&os::close, s));
+
+Future<Response> put(
+    const UPID& upid,
+    const string& path,
+    const Option<string>& body,
+    const Option<string>& contentType)
+{
+  return internal::request("PUT", upid, path, "", body, contentType);
 }
 
 }  // namespace http {
@@ -3439,6 +4718,18 @@ void dispatch(
   process::initialize();
 
   DispatchEvent* event = new DispatchEvent(pid, f, method);
+
+  // Dispatches are part of the span of the event being served, if any.
+  event->span = tracer::span();
+
+  if (tracer::enabled) {
+    tracer::record(
+        tracer::DISPATCH,
+        event->span,
+        pid.id,
+        "dispatch " + method);
+  }
+
   process_manager->deliver(pid, event, __process__);
 }
 
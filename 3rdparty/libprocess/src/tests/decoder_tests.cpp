@@ -6,6 +6,8 @@
 #include <process/socket.hpp>
 
 #include <stout/gtest.hpp>
+#include <stout/gzip.hpp>
+#include <stout/stringify.hpp>
 
 #include "decoder.hpp"
 
@@ -52,6 +54,149 @@ TEST(Decoder, Request)
 }
 
 
+TEST(Decoder, RequestDeferred)
+{
+  DataDecoder decoder = DataDecoder(Socket(), true);
+
+  const string& body = "Hello World";
+
+  Try<string> compressed = gzip::compress(body);
+  ASSERT_SOME(compressed);
+
+  // Split the request across multiple reads, including in the
+  // middle of a header.
+  const string& data =
+    "POST /path/file.json?key1=value1&key2=value2#fragment HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "Content-Encoding: gzip\r\n"
+    "Content-Length: " + stringify(compressed.get().length()) + "\r\n"
+    "\r\n" + compressed.get();
+
+  size_t split = data.find("Encoding") + 4;
+
+  deque<Request*> requests = decoder.decode(data.data(), split);
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_TRUE(requests.empty());
+
+  requests = decoder.decode(data.data() + split, data.length() - split);
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_EQ(1, requests.size());
+
+  Request* request = requests[0];
+  EXPECT_EQ("/path/file.json", request->path);
+  EXPECT_SOME_EQ("localhost", request->headers.get("Host"));
+  EXPECT_SOME_EQ("gzip", request->headers.get("Content-Encoding"));
+
+  // The query and body have not been decoded yet.
+  EXPECT_TRUE(request->query.empty());
+  EXPECT_EQ(compressed.get(), request->body);
+
+  ASSERT_SOME(DataDecoder::complete(request));
+
+  EXPECT_EQ(2, request->query.size());
+  EXPECT_SOME_EQ("value1", request->query.get("key1"));
+  EXPECT_SOME_EQ("value2", request->query.get("key2"));
+  EXPECT_EQ(body, request->body);
+  EXPECT_TRUE(request->headers.get("Content-Encoding").isNone());
+
+  // Completing again should be a no-op.
+  ASSERT_SOME(DataDecoder::complete(request));
+  EXPECT_EQ(body, request->body);
+
+  delete request;
+}
+
+
+TEST(Decoder, RequestBody)
+{
+  DataDecoder decoder = DataDecoder(Socket());
+
+  const string& headers =
+    "POST /path HTTP/1.1\r\n"
+    "Content-Length: 11\r\n"
+    "\r\n";
+
+  size_t remaining = 0;
+  EXPECT_TRUE(decoder.body(&remaining) == NULL);
+
+  deque<Request*> requests = decoder.decode(headers.data(), headers.length());
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_TRUE(requests.empty());
+
+  // Receive part of the body in place.
+  char* body = decoder.body(&remaining);
+  ASSERT_TRUE(body != NULL);
+  ASSERT_EQ(11u, remaining);
+
+  memcpy(body, "Hello", 5);
+
+  requests = decoder.decode(body, 5);
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_TRUE(requests.empty());
+
+  body = decoder.body(&remaining);
+  ASSERT_TRUE(body != NULL);
+  ASSERT_EQ(6u, remaining);
+
+  // Followed by the rest of the body and the next request.
+  const string& data =
+    " World"
+    "GET /next HTTP/1.1\r\n"
+    "\r\n";
+
+  requests = decoder.decode(data.data(), data.length());
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_EQ(2, requests.size());
+
+  EXPECT_EQ("/path", requests[0]->path);
+  EXPECT_EQ("Hello World", requests[0]->body);
+  EXPECT_EQ("/next", requests[1]->path);
+  EXPECT_TRUE(requests[1]->body.empty());
+
+  EXPECT_TRUE(decoder.body(&remaining) == NULL);
+
+  delete requests[0];
+  delete requests[1];
+}
+
+
+// The parser ignores the Content-Length of a chunked request (no
+// matter how the Transfer-Encoding header is capitalized), so the
+// decoder must not size the body after it.
+TEST(Decoder, RequestChunkedWithContentLength)
+{
+  DataDecoder decoder = DataDecoder(Socket());
+
+  const string body(256, 'x'); // 0x100 bytes.
+
+  const string& data =
+    "POST /path HTTP/1.1\r\n"
+    "transfer-encoding: chunked\r\n"
+    "Content-Length: 20\r\n"
+    "\r\n"
+    "100\r\n" + body + "\r\n"
+    "0\r\n"
+    "\r\n";
+
+  size_t split = data.find("100\r\n");
+
+  deque<Request*> requests = decoder.decode(data.data(), split);
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_TRUE(requests.empty());
+
+  size_t remaining = 0;
+  EXPECT_TRUE(decoder.body(&remaining) == NULL);
+
+  requests = decoder.decode(data.data() + split, data.length() - split);
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_EQ(1, requests.size());
+
+  EXPECT_EQ(body, requests[0]->body);
+
+  delete requests[0];
+}
+
+
 TEST(Decoder, RequestHeaderContinuation)
 {
   DataDecoder decoder = DataDecoder(Socket());
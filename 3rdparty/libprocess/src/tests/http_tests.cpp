@@ -4,19 +4,29 @@
 
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <stdlib.h> // For atoi().
 
+#include <deque>
 #include <string>
+#include <vector>
 
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
 #include <process/http.hpp>
+#include <process/id.hpp>
 #include <process/io.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
+#include <stout/json.hpp>
 #include <stout/nothing.hpp>
 #include <stout/os.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+#include <stout/try.hpp>
 
+#include "decoder.hpp"
 #include "encoder.hpp"
 
 using namespace process;
@@ -24,13 +34,14 @@ using namespace process;
 using testing::_;
 using testing::Assign;
 using testing::DoAll;
+using testing::Invoke;
 using testing::Return;
 
 
 class HttpProcess : public Process<HttpProcess>
 {
 public:
-  HttpProcess()
+  HttpProcess() : ProcessBase(ID::generate("http"))
   {
     route("/body", &HttpProcess::body);
     route("/pipe", &HttpProcess::pipe);
@@ -113,6 +124,354 @@ TEST(HTTP, Endpoints)
 }
 
 
+// Responds with the query of the request, used to check that
+// responses are matched up with their requests.
+Future<http::Response> echo(const http::Request& request)
+{
+  return http::OK(request.query.get("n").get());
+}
+
+
+TEST(HTTP, Pipelining)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  HttpProcess process;
+
+  spawn(process);
+
+  EXPECT_CALL(process, body(_))
+    .WillRepeatedly(Invoke(echo));
+
+  std::vector<Future<http::Response> > futures;
+  for (int i = 0; i < 32; i++) {
+    futures.push_back(http::get(process.self(), "body", "n=" + stringify(i)));
+  }
+
+  for (int i = 0; i < 32; i++) {
+    AWAIT_READY(futures[i]);
+    EXPECT_EQ(http::statuses[200], futures[i].get().status);
+    EXPECT_EQ(stringify(i), futures[i].get().body);
+  }
+
+  // Subsequent requests should reuse the pooled connections.
+  Future<http::Response> future = http::get(process.self(), "body", "n=32");
+  AWAIT_READY(future);
+  EXPECT_EQ("32", future.get().body);
+
+  terminate(process);
+  wait(process);
+}
+
+
+// Tests that pipelined requests get processed concurrently but their
+// responses still get sent in order.
+TEST(HTTP, PipelinedResponsesInOrder)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  HttpProcess process;
+
+  spawn(process);
+
+  int s = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+
+  ASSERT_LE(0, s);
+
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = PF_INET;
+  addr.sin_port = htons(process.self().port);
+  addr.sin_addr.s_addr = process.self().ip;
+
+  ASSERT_EQ(0, connect(s, (sockaddr*) &addr, sizeof(addr)));
+
+  // The first response doesn't get satisfied until after the second
+  // request has been handled.
+  Promise<http::Response> promise;
+
+  Future<Nothing> first;
+  Future<Nothing> second;
+  EXPECT_CALL(process, body(_))
+    .WillOnce(DoAll(FutureSatisfy(&first),
+                    Return(promise.future())))
+    .WillOnce(DoAll(FutureSatisfy(&second),
+                    Return(http::OK("second"))));
+
+  std::ostringstream out;
+  for (int i = 0; i < 2; i++) {
+    out << "GET /" << process.self().id << "/body HTTP/1.1\r\n"
+        << "Host: localhost\r\n"
+        << "\r\n";
+  }
+
+  ASSERT_SOME(os::write(s, out.str()));
+
+  AWAIT_READY(first);
+  AWAIT_READY(second);
+
+  promise.set(http::OK("first"));
+
+  ResponseDecoder decoder;
+  std::deque<http::Response*> responses;
+  char data[4096];
+  while (responses.size() < 2) {
+    ssize_t length = ::read(s, data, sizeof(data));
+    ASSERT_LT(0, length);
+    std::deque<http::Response*> decoded = decoder.decode(data, length);
+    responses.insert(responses.end(), decoded.begin(), decoded.end());
+  }
+
+  ASSERT_EQ(2u, responses.size());
+  EXPECT_EQ("first", responses[0]->body);
+  EXPECT_EQ("second", responses[1]->body);
+
+  foreach (http::Response* response, responses) {
+    delete response;
+  }
+
+  ASSERT_EQ(0, close(s));
+
+  terminate(process);
+  wait(process);
+}
+
+
+TEST(HTTP, Post)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  HttpProcess process;
+
+  spawn(process);
+
+  Future<http::Request> request;
+  EXPECT_CALL(process, body(_))
+    .WillOnce(DoAll(FutureArg<0>(&request),
+                    Return(http::OK())));
+
+  Future<http::Response> future = http::post(
+      process.self(),
+      "body",
+      std::string("Hello World"),
+      std::string("text/plain"));
+
+  AWAIT_READY(request);
+  EXPECT_EQ("POST", request.get().method);
+  EXPECT_EQ("Hello World", request.get().body);
+  EXPECT_SOME_EQ("text/plain", request.get().headers.get("Content-Type"));
+
+  AWAIT_READY(future);
+  EXPECT_EQ(http::statuses[200], future.get().status);
+
+  terminate(process);
+  wait(process);
+}
+
+
+// Sends a gzip accepting HTTP/1.0 request to the path of the process
+// using an explicit socket and returns the (decoded) response.
+static Try<http::Response> gzipped(const UPID& pid, const std::string& path)
+{
+  int s = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+
+  if (s < 0) {
+    return ErrnoError("Failed to create socket");
+  }
+
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = PF_INET;
+  addr.sin_port = htons(pid.port);
+  addr.sin_addr.s_addr = pid.ip;
+
+  if (connect(s, (sockaddr*) &addr, sizeof(addr)) < 0) {
+    os::close(s);
+    return ErrnoError("Failed to connect");
+  }
+
+  std::ostringstream out;
+  out << "GET /" << pid.id << "/" << path << " HTTP/1.0\r\n"
+      << "Accept-Encoding: gzip\r\n"
+      << "\r\n";
+
+  Try<Nothing> write = os::write(s, out.str());
+  if (write.isError()) {
+    os::close(s);
+    return Error(write.error());
+  }
+
+  // The connection gets closed after the response since we didn't
+  // ask for it to be kept alive.
+  ResponseDecoder decoder;
+  std::deque<http::Response*> responses;
+  char data[4096];
+  ssize_t length;
+  while ((length = ::read(s, data, sizeof(data))) > 0) {
+    responses = decoder.decode(data, length);
+    if (!responses.empty()) {
+      break;
+    }
+  }
+
+  os::close(s);
+
+  if (responses.size() != 1) {
+    return Error("Failed to decode a response");
+  }
+
+  http::Response response = *responses.front();
+  delete responses.front();
+  return response;
+}
+
+
+// Returns the 'hits' counter from the JSON served at
+// '/__metrics__/gzip', or -1 if it's missing.
+static int hits(const std::string& json)
+{
+  const std::string& key = "\"hits\":";
+  size_t index = json.find(key);
+  if (index == std::string::npos) {
+    return -1;
+  }
+  return atoi(json.c_str() + index + key.length());
+}
+
+
+TEST(HTTP, Gzip)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  HttpProcess process;
+
+  spawn(process);
+
+  const std::string body(8 * 1024, 'x');
+
+  EXPECT_CALL(process, body(_))
+    .WillRepeatedly(Return(http::OK(body)));
+
+  UPID metrics("__metrics__", process.self().ip, process.self().port);
+
+  Future<http::Response> before = http::get(metrics, "gzip");
+  AWAIT_READY(before);
+  ASSERT_LE(0, hits(before.get().body)) << before.get().body;
+
+  // The second request should be served from the cache of
+  // compressed bodies.
+  for (int i = 0; i < 2; i++) {
+    Try<http::Response> response = gzipped(process.self(), "body");
+    ASSERT_SOME(response);
+    EXPECT_EQ(http::statuses[200], response.get().status);
+    EXPECT_SOME_EQ("gzip", response.get().headers.get("Content-Encoding"));
+    EXPECT_EQ(body, response.get().body);
+  }
+
+  Future<http::Response> after = http::get(metrics, "gzip");
+  AWAIT_READY(after);
+  EXPECT_EQ(hits(before.get().body) + 1, hits(after.get().body))
+    << after.get().body;
+
+  // Pipes should get compressed as they're streamed.
+  int pipes[2];
+  ASSERT_NE(-1, ::pipe(pipes));
+
+  http::OK ok;
+  ok.type = http::Response::PIPE;
+  ok.pipe = pipes[0];
+
+  EXPECT_CALL(process, pipe(_))
+    .WillOnce(Return(ok));
+
+  ASSERT_SOME(os::write(pipes[1], body));
+  ASSERT_SOME(os::close(pipes[1]));
+
+  Try<http::Response> response = gzipped(process.self(), "pipe");
+  ASSERT_SOME(response);
+  EXPECT_SOME_EQ("gzip", response.get().headers.get("Content-Encoding"));
+  EXPECT_SOME_EQ("chunked", response.get().headers.get("Transfer-Encoding"));
+  EXPECT_EQ(body, response.get().body);
+
+  terminate(process);
+  wait(process);
+}
+
+
+// Returns how many responses with the specified status code were
+// sent for the route, according to the JSON served at '/__metrics__'.
+static uint64_t responses(
+    const std::string& json,
+    const std::string& route,
+    const std::string& code)
+{
+  Try<JSON::Value> value = JSON::parse(json);
+  if (value.isError()) {
+    return 0;
+  }
+
+  JSON::Object routes = boost::get<JSON::Object>(value.get());
+  if (routes.values.count(route) == 0) {
+    return 0;
+  }
+
+  JSON::Object metrics = boost::get<JSON::Object>(routes.values[route]);
+  JSON::Object codes = boost::get<JSON::Object>(metrics.values["codes"]);
+  if (codes.values.count(code) == 0) {
+    return 0;
+  }
+
+  return (uint64_t) boost::get<JSON::Number>(codes.values[code]).value;
+}
+
+
+TEST(HTTP, Metrics)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  HttpProcess process;
+
+  spawn(process);
+
+  UPID pid("__metrics__", process.self().ip, process.self().port);
+
+  Future<http::Response> before = http::get(pid);
+  AWAIT_READY(before);
+
+  EXPECT_CALL(process, body(_))
+    .WillOnce(Return(http::OK()))
+    .WillOnce(Return(http::NotFound()));
+
+  AWAIT_READY(http::get(process.self(), "body"));
+  AWAIT_READY(http::get(process.self(), "body"));
+
+  Future<http::Response> future = http::get(pid);
+
+  AWAIT_READY(future);
+  EXPECT_EQ(http::statuses[200], future.get().status);
+
+  const std::string& metrics = future.get().body;
+
+  ASSERT_SOME(JSON::parse(metrics)) << metrics;
+
+  // The metrics of all the 'http(N)' processes are merged.
+  EXPECT_FALSE(strings::contains(metrics, process.self().id)) << metrics;
+
+  EXPECT_EQ(responses(before.get().body, "/http/body", "200") + 1,
+            responses(metrics, "/http/body", "200"))
+    << metrics;
+  EXPECT_EQ(responses(before.get().body, "/http/body", "404") + 1,
+            responses(metrics, "/http/body", "404"))
+    << metrics;
+
+  EXPECT_TRUE(strings::contains(metrics, "\"handler_time_us\"")) << metrics;
+  EXPECT_TRUE(strings::contains(metrics, "\"queueing_time_us\"")) << metrics;
+
+  terminate(process);
+  wait(process);
+}
+
+
 TEST(HTTP, Encode)
 {
   std::string unencoded = "a$&+,/:;=?@ \"<>#%{}|\\^~[]`\x19\x80\xFF";
@@ -5,8 +5,11 @@
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 
+#include <pthread.h>
+
 #include <string>
 #include <sstream>
+#include <vector>
 
 #include <process/async.hpp>
 #include <process/collect.hpp>
@@ -20,16 +23,28 @@
 #include <process/gc.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
+#include <process/http.hpp>
+#include <process/id.hpp>
 #include <process/process.hpp>
 #include <process/run.hpp>
 #include <process/time.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
+#include <stout/foreach.hpp>
+#include <stout/gtest.hpp>
+#include <stout/json.hpp>
 #include <stout/nothing.hpp>
 #include <stout/os.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
+#include <stout/strings.hpp>
 
+#include "accounting.hpp"
+#include "blocking.hpp"
+#include "tracer.hpp"
 #include "encoder.hpp"
+#include "metrics.hpp"
 
 using namespace process;
 
@@ -1065,6 +1080,322 @@ TEST(Process, remote)
 }
 
 
+class ReceiveProcess : public Process<ReceiveProcess>
+{
+public:
+  ReceiveProcess(int _expected) : expected(_expected), received(0)
+  {
+    install("receive", &ReceiveProcess::receive);
+  }
+
+  Future<Nothing> done()
+  {
+    return promise.future();
+  }
+
+private:
+  void receive(const UPID& from, const std::string& body)
+  {
+    if (++received == expected) {
+      promise.set(Nothing());
+    }
+  }
+
+  const int expected;
+  int received;
+  Promise<Nothing> promise;
+};
+
+
+// Benchmarks receiving large messages through a socket.
+TEST(Process, largeMessages)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  const int messages = 100;
+  const size_t size = 4 * 1024 * 1024;
+
+  ReceiveProcess process(messages);
+  spawn(process);
+
+  int s = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+
+  ASSERT_LE(0, s);
+
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = PF_INET;
+  addr.sin_port = htons(process.self().port);
+  addr.sin_addr.s_addr = process.self().ip;
+
+  ASSERT_EQ(0, connect(s, (sockaddr*) &addr, sizeof(addr)));
+
+  Message message;
+  message.name = "receive";
+  message.from = UPID();
+  message.to = process.self();
+  message.body = std::string(size, 'x');
+
+  const std::string& data = MessageEncoder::encode(&message);
+
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  for (int i = 0; i < messages; i++) {
+    size_t written = 0;
+    while (written < data.size()) {
+      ssize_t length =
+        write(s, data.data() + written, data.size() - written);
+      ASSERT_LT(0, length);
+      written += length;
+    }
+  }
+
+  AWAIT_READY_FOR(process.done(), Seconds(60));
+
+  stopwatch.stop();
+
+  std::cout << "Received " << messages << " messages of " << Bytes(size)
+            << " in " << stopwatch.elapsed() << std::endl;
+
+  ASSERT_EQ(0, close(s));
+
+  terminate(process);
+  wait(process);
+}
+
+
+// Reads from the socket until the data read so far contains 'what'.
+static std::string readUntil(int s, const std::string& what)
+{
+  std::string data;
+  char buffer[1024];
+  while (!strings::contains(data, what)) {
+    ssize_t length = read(s, buffer, sizeof(buffer));
+    if (length <= 0) {
+      break;
+    }
+    data.append(buffer, length);
+  }
+  return data;
+}
+
+
+// Listens on an ephemeral port of 'ip' and returns the socket, so
+// that messages sent to 'receiver' go through a socket rather than
+// being delivered locally.
+static int listenOn(uint32_t ip, UPID* receiver)
+{
+  int s = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+  if (s < 0) {
+    return -1;
+  }
+
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = PF_INET;
+  addr.sin_port = 0;
+  addr.sin_addr.s_addr = ip;
+
+  socklen_t addrlen = sizeof(addr);
+
+  if (bind(s, (sockaddr*) &addr, sizeof(addr)) != 0 ||
+      listen(s, 16) != 0 ||
+      getsockname(s, (sockaddr*) &addr, &addrlen) != 0) {
+    close(s);
+    return -1;
+  }
+
+  *receiver = UPID("receiver", ip, ntohs(addr.sin_port));
+
+  return s;
+}
+
+
+// Returns the named counter of temporary sockets (see
+// metrics::sockets).
+static uint64_t sockets(const std::string& name)
+{
+  JSON::Object object = metrics::sockets();
+  return (uint64_t) boost::get<JSON::Number>(object.values[name]).value;
+}
+
+
+// Waits until the named counter of temporary sockets is at least
+// 'value', returns false if it isn't after 'timeout'.
+static bool awaitSockets(
+    const std::string& name,
+    uint64_t value,
+    const Duration& timeout = Seconds(10))
+{
+  Stopwatch stopwatch;
+  stopwatch.start();
+  while (sockets(name) < value) {
+    if (stopwatch.elapsed() > timeout) {
+      return false;
+    }
+    os::sleep(Milliseconds(10));
+  }
+  return true;
+}
+
+
+TEST(Process, reuse)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  // Some process, to learn the ip libprocess is bound to.
+  RemoteProcess process;
+  spawn(process);
+
+  UPID receiver;
+  int s = listenOn(process.self().ip, &receiver);
+  ASSERT_LE(0, s);
+
+  const uint64_t reused = sockets("reused");
+  const uint64_t idle = sockets("idle");
+
+  post(receiver, "first");
+
+  int c = accept(s, NULL, NULL);
+  ASSERT_LE(0, c);
+
+  EXPECT_TRUE(strings::contains(readUntil(c, "first"), "first"));
+
+  // Wait for the socket to go idle, so that the second message is
+  // sent by reusing it rather than being queued behind the first.
+  ASSERT_TRUE(awaitSockets("idle", idle + 1));
+
+  // The second message is sent on the same connection.
+  post(receiver, "second");
+
+  EXPECT_TRUE(strings::contains(readUntil(c, "second"), "second"));
+
+  EXPECT_EQ(reused + 1, sockets("reused"));
+
+  ASSERT_SOME(os::nonblock(s));
+  EXPECT_EQ(-1, accept(s, NULL, NULL));
+
+  UPID pid("__metrics__", process.self().ip, process.self().port);
+
+  Future<http::Response> response = http::get(pid, "sockets");
+  AWAIT_READY(response);
+  EXPECT_EQ(http::statuses[200], response.get().status);
+  EXPECT_TRUE(strings::contains(response.get().body, "\"opened\""))
+    << response.get().body;
+
+  close(c);
+  close(s);
+
+  terminate(process);
+  wait(process);
+}
+
+
+TEST(Process, reuseExpired)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  RemoteProcess process;
+  spawn(process);
+
+  UPID receiver;
+  int s = listenOn(process.self().ip, &receiver);
+  ASSERT_LE(0, s);
+
+  Clock::pause();
+
+  const uint64_t opened = sockets("opened");
+  const uint64_t expired = sockets("expired");
+  const uint64_t idle = sockets("idle");
+
+  post(receiver, "first");
+
+  ASSERT_TRUE(awaitSockets("idle", idle + 1));
+
+  // An idle socket gets closed once it hasn't been used for a while.
+  Clock::advance(Seconds(30));
+  Clock::settle();
+
+  ASSERT_TRUE(awaitSockets("expired", expired + 1));
+
+  // So the next message needs a new one.
+  post(receiver, "second");
+
+  ASSERT_TRUE(awaitSockets("opened", opened + 2));
+
+  Clock::resume();
+
+  close(s);
+
+  terminate(process);
+  wait(process);
+}
+
+
+TEST(Process, reuseEvicted)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  RemoteProcess process;
+  spawn(process);
+
+  const uint64_t max = sockets("max_idle");
+  ASSERT_LT(0u, max);
+
+  // Sockets left idle by other tests are less recently used than any
+  // of ours, so they get evicted first.
+  const uint64_t evicted = sockets("evicted") + sockets("idle");
+  const uint64_t opened = sockets("opened");
+  const uint64_t reused = sockets("reused");
+
+  // Send a message to one more node than there can be idle sockets
+  // for, waiting for each socket to go idle (or to evict another one)
+  // so that the least recently used of ours is the one to the first
+  // node. Note that the receivers never accept, the connections just
+  // sit in the listen backlog.
+  std::vector<int> listeners;
+  std::vector<UPID> receivers;
+  for (uint64_t i = 0; i <= max; i++) {
+    UPID receiver;
+    int s = listenOn(process.self().ip, &receiver);
+    ASSERT_LE(0, s);
+
+    listeners.push_back(s);
+    receivers.push_back(receiver);
+
+    const uint64_t idled = sockets("idle") + sockets("evicted");
+
+    post(receiver, "hello");
+
+    Stopwatch stopwatch;
+    stopwatch.start();
+    while (sockets("idle") + sockets("evicted") == idled) {
+      ASSERT_LT(stopwatch.elapsed(), Seconds(10));
+      os::sleep(Milliseconds(10));
+    }
+  }
+
+  ASSERT_TRUE(awaitSockets("evicted", evicted + 1));
+  EXPECT_EQ(max, sockets("idle"));
+
+  // The socket to the last node is still idle and gets reused, while
+  // the one to the first node got evicted and must be opened again.
+  post(receivers.back(), "again");
+  ASSERT_TRUE(awaitSockets("reused", reused + 1));
+
+  post(receivers.front(), "again");
+  ASSERT_TRUE(awaitSockets("opened", opened + max + 2));
+
+  foreach (int s, listeners) {
+    close(s);
+  }
+
+  terminate(process);
+  wait(process);
+}
+
+
 int foo()
 {
   return 1;
@@ -1118,3 +1449,203 @@ TEST(Process, async)
   // Non-void function that returns a future.
   EXPECT_EQ("42", async(&itoa1, &i).get().get());
 }
+
+
+static volatile bool blocked = false;
+
+
+static int block()
+{
+  while (blocked) {
+    os::sleep(Milliseconds(1));
+  }
+  return 0;
+}
+
+
+static double discarded()
+{
+  JSON::Object snapshot = blocking::snapshot();
+  return boost::get<JSON::Number>(snapshot.values["discarded"]).value;
+}
+
+
+TEST(Process, asyncDiscard)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  const double before = discarded();
+
+  // Block (more than) all of the blocking threads so that the low
+  // priority function stays queued until we discard it.
+  blocked = true;
+
+  std::vector<Future<int> > blockers;
+  for (int i = 0; i < 64; i++) {
+    blockers.push_back(AsyncExecutor(ASYNC_HIGH).execute(&block));
+  }
+
+  Future<int> future = AsyncExecutor(ASYNC_LOW).execute(&foo);
+
+  UPID pid("__async__", process::ip(), process::port());
+
+  Future<http::Response> response = http::get(pid);
+  AWAIT_READY(response);
+  EXPECT_EQ(http::statuses[200], response.get().status);
+  EXPECT_TRUE(strings::contains(response.get().body, "\"low\":1"))
+    << response.get().body;
+
+  EXPECT_TRUE(future.discard());
+
+  blocked = false;
+
+  foreach (const Future<int>& blocker, blockers) {
+    AWAIT_READY(blocker);
+  }
+
+  // Wait until the discarded function has been dequeued.
+  Stopwatch stopwatch;
+  stopwatch.start();
+  while (discarded() == before && stopwatch.elapsed() < Seconds(5)) {
+    os::sleep(Milliseconds(1));
+  }
+
+  EXPECT_EQ(before + 1, discarded());
+  EXPECT_TRUE(future.isDiscarded());
+}
+
+
+class AccountingProcess : public Process<AccountingProcess>
+{
+public:
+  AccountingProcess() : ProcessBase(ID::generate("accounting")) {}
+
+  Nothing work() { return Nothing(); }
+};
+
+
+TEST(Process, accounting)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  accounting::enabled = true;
+
+  AccountingProcess process;
+  spawn(process);
+
+  AWAIT_READY(dispatch(process, &AccountingProcess::work));
+
+  terminate(process);
+  wait(process);
+
+  UPID pid("__processes__", process.self().ip, process.self().port);
+
+  // NOTE: Processes get accounted for by their id without the "(N)".
+  Future<http::Response> response = http::get(pid);
+  AWAIT_READY(response);
+  EXPECT_EQ(http::statuses[200], response.get().status);
+  EXPECT_TRUE(strings::contains(response.get().body, "\"accounting\""))
+    << response.get().body;
+  EXPECT_TRUE(strings::contains(response.get().body, "\"dispatch "))
+    << response.get().body;
+  EXPECT_TRUE(strings::contains(response.get().body, "\"terminate\""))
+    << response.get().body;
+
+  response = http::get(pid, "trace");
+  AWAIT_READY(response);
+  EXPECT_EQ(http::statuses[200], response.get().status);
+  EXPECT_TRUE(strings::contains(response.get().body, "\"traceEvents\""))
+    << response.get().body;
+
+  accounting::enabled = false;
+}
+
+
+TEST(Process, tracing)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  AccountingProcess process;
+  spawn(process);
+
+  UPID pid("__trace__", process.self().ip, process.self().port);
+
+  Future<http::Response> response = http::get(pid, "start");
+  AWAIT_READY(response);
+  EXPECT_EQ(http::statuses[200], response.get().status);
+  EXPECT_TRUE(tracer::enabled);
+
+  AWAIT_READY(dispatch(process, &AccountingProcess::work));
+
+  response = http::get(pid, "stop");
+  AWAIT_READY(response);
+  EXPECT_EQ(http::statuses[200], response.get().status);
+  EXPECT_FALSE(tracer::enabled);
+
+  response = http::get(pid);
+  AWAIT_READY(response);
+  EXPECT_EQ(http::statuses[200], response.get().status);
+  EXPECT_TRUE(strings::contains(response.get().body, "\"traceEvents\""))
+    << response.get().body;
+  EXPECT_TRUE(strings::contains(response.get().body, "\"ph\":\"B\""))
+    << response.get().body;
+  EXPECT_TRUE(strings::contains(response.get().body, process.self().id))
+    << response.get().body;
+
+  terminate(process);
+  wait(process);
+}
+
+
+class ChurnProcess : public Process<ChurnProcess>
+{
+public:
+  ChurnProcess() : ProcessBase(ID::generate("churn")) {}
+};
+
+
+static void* churn(void* arg)
+{
+  const int iterations = *(int*) arg;
+
+  for (int i = 0; i < iterations; i++) {
+    ChurnProcess process;
+    spawn(process);
+    terminate(process);
+    wait(process);
+  }
+
+  return NULL;
+}
+
+
+// Benchmarks spawning and terminating short-lived processes from
+// multiple threads (which contend on the process registry).
+TEST(Process, churn)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  // Make sure the id prefix exists before the threads use it.
+  ChurnProcess process;
+
+  const int threads = 8;
+  int iterations = 1000;
+
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  pthread_t pthreads[threads];
+  for (int i = 0; i < threads; i++) {
+    ASSERT_EQ(0, pthread_create(&pthreads[i], NULL, churn, &iterations));
+  }
+
+  for (int i = 0; i < threads; i++) {
+    ASSERT_EQ(0, pthread_join(pthreads[i], NULL));
+  }
+
+  stopwatch.stop();
+
+  std::cout << "Spawned and terminated " << threads * iterations
+            << " processes from " << threads << " threads in "
+            << stopwatch.elapsed() << std::endl;
+}
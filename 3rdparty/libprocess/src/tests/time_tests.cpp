@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 
+#include <pthread.h>
+
 #include <gmock/gmock.h>
 
 #include <process/clock.hpp>
@@ -8,6 +10,7 @@
 #include <stout/duration.hpp>
 #include <stout/gtest.hpp>
 #include <stout/os.hpp>
+#include <stout/stopwatch.hpp>
 
 using namespace process;
 
@@ -36,6 +39,46 @@ TEST(TimeTest, Now)
 }
 
 
+static void* now(void* arg)
+{
+  const int iterations = *(int*) arg;
+
+  for (int i = 0; i < iterations; i++) {
+    Clock::now();
+  }
+
+  return NULL;
+}
+
+
+// Benchmarks Clock::now from multiple threads at the same time.
+TEST(TimeTest, NowContention)
+{
+  const int threads = 8;
+  int iterations = 100000;
+
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  pthread_t pthreads[threads];
+  for (int i = 0; i < threads; i++) {
+    ASSERT_EQ(0, pthread_create(&pthreads[i], NULL, now, &iterations));
+  }
+
+  for (int i = 0; i < threads; i++) {
+    ASSERT_EQ(0, pthread_join(pthreads[i], NULL));
+  }
+
+  stopwatch.stop();
+
+  std::cout << "Called Clock::now " << threads * iterations
+            << " times from " << threads << " threads in "
+            << stopwatch.elapsed() << " ("
+            << stopwatch.elapsed().ns() / (threads * iterations)
+            << "ns per call)" << std::endl;
+}
+
+
 TEST(TimeTest, Output)
 {
   EXPECT_EQ("1989-03-02 00:00:00+00:00", stringify(Time::EPOCH + Weeks(1000)));
@@ -0,0 +1,256 @@
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <list>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/json.hpp>
+#include <stout/stringify.hpp>
+#include <stout/thread.hpp>
+#include <stout/uuid.hpp>
+
+#include "accounting.hpp"
+#include "synchronized.hpp"
+#include "tracer.hpp"
+
+using std::list;
+using std::string;
+using std::vector;
+
+namespace process {
+namespace tracer {
+
+volatile bool enabled = false;
+
+// Number of records kept per thread.
+static const uint64_t RECORDS = 4096;
+
+// A trace record. The 'sequence' is used to detect records that are
+// being (over)written while the trace is being dumped: it's set to
+// zero while a record is being written, and to the 1-based index of
+// the record in the buffer once it's written.
+struct Record
+{
+  volatile uint64_t sequence;
+  uint64_t timestamp; // Nanoseconds since the epoch.
+  uint64_t span;
+  Type type;
+  uint8_t length; // Of the key.
+  char id[47];
+  char key[80];
+};
+
+
+// A per thread ring buffer of records, only written by the owning
+// thread.
+struct Buffer
+{
+  explicit Buffer(uint64_t _thread) : thread(_thread), head(0)
+  {
+    memset(records, 0, sizeof(records));
+  }
+
+  const uint64_t thread;
+  volatile uint64_t head; // Index of the next record to write.
+  Record records[RECORDS];
+};
+
+
+// Buffers of every thread that has recorded any events (these are
+// never deleted since libprocess threads live forever).
+static list<Buffer*>* buffers = new list<Buffer*>();
+static synchronizable(buffers) = SYNCHRONIZED_INITIALIZER;
+
+// Buffer of the current thread.
+static ThreadLocal<Buffer>* _buffer_ = new ThreadLocal<Buffer>();
+
+// Span of the event currently being served by this thread.
+static __thread uint64_t __span__ = 0;
+
+
+static Buffer* local()
+{
+  Buffer* local = *_buffer_;
+  if (local == NULL) {
+    synchronized (buffers) {
+      local = new Buffer(buffers->size());
+      buffers->push_back(local);
+    }
+    *_buffer_ = local;
+  }
+  return local;
+}
+
+
+uint64_t span()
+{
+  return __span__;
+}
+
+
+void span(uint64_t span)
+{
+  __span__ = span;
+}
+
+
+uint64_t generate()
+{
+  uint64_t span = 0;
+  while (span == 0) {
+    const string uuid = UUID::random().toBytes();
+    memcpy(&span, uuid.data(), sizeof(span));
+  }
+  return span;
+}
+
+
+void record(Type type, uint64_t span, const string& id, const string& key)
+{
+  if (!enabled) {
+    return;
+  }
+
+  timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+
+  Buffer* buffer = local();
+
+  const uint64_t index = buffer->head;
+
+  Record* record = &buffer->records[index % RECORDS];
+
+  record->sequence = 0;
+  __sync_synchronize();
+
+  record->timestamp = (ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+  record->span = span;
+  record->type = type;
+
+  size_t length = std::min(id.size(), sizeof(record->id) - 1);
+  memcpy(record->id, id.data(), length);
+  record->id[length] = '\0';
+
+  // NOTE: Keys can contain arbitrary bytes (see accounting::key).
+  record->length = std::min(key.size(), sizeof(record->key));
+  memcpy(record->key, key.data(), record->length);
+
+  __sync_synchronize();
+  record->sequence = index + 1;
+
+  buffer->head = index + 1;
+}
+
+
+// A copy of a record, tagged with the thread that recorded it.
+struct Entry
+{
+  uint64_t thread;
+  Record record;
+
+  bool operator < (const Entry& that) const
+  {
+    return record.timestamp < that.record.timestamp;
+  }
+};
+
+
+JSON::Object dump()
+{
+  vector<Entry> entries;
+
+  synchronized (buffers) {
+    foreach (Buffer* buffer, *buffers) {
+      const uint64_t head = buffer->head;
+      const uint64_t tail = head > RECORDS ? head - RECORDS : 0;
+      for (uint64_t index = tail; index < head; index++) {
+        const Record& record = buffer->records[index % RECORDS];
+
+        Entry entry;
+        entry.thread = buffer->thread;
+
+        // Skip records that are (or have been) overwritten.
+        if (record.sequence != index + 1) {
+          continue;
+        }
+        __sync_synchronize();
+        memcpy(&entry.record, &record, sizeof(Record));
+        __sync_synchronize();
+        if (record.sequence != index + 1) {
+          continue;
+        }
+
+        entries.push_back(entry);
+      }
+    }
+  }
+
+  std::sort(entries.begin(), entries.end());
+
+  // Cache the described keys since describing them can be expensive.
+  hashmap<string, string> keys;
+
+  JSON::Array events;
+  foreach (const Entry& entry, entries) {
+    const Record& record = entry.record;
+
+    const string key(record.key, record.length);
+    if (!keys.contains(key)) {
+      keys[key] = accounting::describe(key);
+    }
+
+    JSON::Object args;
+    args.values["process"] = string(record.id);
+    if (record.span != 0) {
+      std::ostringstream out;
+      out << std::hex << record.span;
+      args.values["span"] = out.str();
+    }
+
+    JSON::Object event;
+    event.values["name"] = keys[key];
+    event.values["ts"] = JSON::Number(record.timestamp / 1000.0);
+    event.values["pid"] = JSON::Number(getpid());
+    event.values["tid"] = JSON::Number(entry.thread);
+    event.values["args"] = args;
+
+    switch (record.type) {
+      case DEQUEUE:
+        event.values["ph"] = "B";
+        break;
+      case SERVED:
+        event.values["ph"] = "E";
+        break;
+      default:
+        // An "instant" event, scoped to the thread.
+        event.values["ph"] = "i";
+        event.values["s"] = "t";
+        break;
+    }
+
+    switch (record.type) {
+      case ENQUEUE: event.values["cat"] = "enqueue"; break;
+      case DEQUEUE: event.values["cat"] = "serve"; break;
+      case SERVED: event.values["cat"] = "serve"; break;
+      case DISPATCH: event.values["cat"] = "dispatch"; break;
+      case SEND: event.values["cat"] = "send"; break;
+      case RECEIVE: event.values["cat"] = "receive"; break;
+    }
+
+    events.values.push_back(event);
+  }
+
+  JSON::Object object;
+  object.values["traceEvents"] = events;
+  return object;
+}
+
+} // namespace tracer {
+} // namespace process {
@@ -0,0 +1,110 @@
+#ifndef __TRACER_HPP__
+#define __TRACER_HPP__
+
+#include <stdint.h>
+
+#include <string>
+
+#include <process/future.hpp>
+#include <process/http.hpp>
+#include <process/process.hpp>
+
+#include <stout/json.hpp>
+
+namespace process {
+namespace tracer {
+
+// Provides a low overhead event tracer that can be toggled at
+// runtime (see TraceProcess below). Each thread records into its own
+// fixed size ring buffer without any locking, the buffers get merged
+// (and the oldest records dropped) when the trace is dumped.
+//
+// Every event belongs to a "span" (a random 64-bit identifier) which
+// is inherited by any events (dispatches, messages, etc) created while
+// serving it, including messages sent to remote processes (see
+// MessageEncoder), so that a trace can be followed across processes
+// and machines. Events without a span get a new span when they're
+// served while tracing is enabled.
+
+enum Type
+{
+  ENQUEUE,  // Event enqueued in a process' mailbox.
+  DEQUEUE,  // Event dequeued and about to be served.
+  SERVED,   // Event has been served.
+  DISPATCH, // Dispatch created.
+  SEND,     // Message sent.
+  RECEIVE   // Message received from a remote process.
+};
+
+// Whether or not tracing is currently enabled.
+extern volatile bool enabled;
+
+// Returns the span of the event currently being served by the
+// calling thread, or 0 if none.
+uint64_t span();
+
+// Sets the span of the event currently being served by the calling
+// thread (0 when no event is being served).
+void span(uint64_t span);
+
+// Returns a new (random) span.
+uint64_t generate();
+
+// Records the trace event, which is a no-op if tracing is not
+// enabled. The 'key' describes the event (see accounting::key).
+void record(
+    Type type,
+    uint64_t span,
+    const std::string& id,
+    const std::string& key);
+
+// Returns the recorded events in the Chrome trace event format (see
+// chrome://tracing).
+JSON::Object dump();
+
+} // namespace tracer {
+
+
+// Exposes the tracer at '/__trace__', with '/__trace__/start' and
+// '/__trace__/stop' for enabling and disabling tracing at runtime.
+class TraceProcess : public Process<TraceProcess>
+{
+public:
+  TraceProcess() : ProcessBase("__trace__") {}
+
+  virtual ~TraceProcess() {}
+
+protected:
+  virtual void initialize()
+  {
+    route("/", &TraceProcess::dump);
+    route("/start", &TraceProcess::start);
+    route("/stop", &TraceProcess::stop);
+  }
+
+private:
+  // Returns the recorded events as a Chrome trace. Supports an
+  // optional 'jsonp' query parameter.
+  Future<http::Response> dump(const http::Request& request)
+  {
+    return http::OK(tracer::dump(), request.query.get("jsonp"));
+  }
+
+  // Starts tracing. There are no request parameters.
+  Future<http::Response> start(const http::Request& request)
+  {
+    tracer::enabled = true;
+    return http::OK("Tracing started.\n");
+  }
+
+  // Stops tracing. There are no request parameters.
+  Future<http::Response> stop(const http::Request& request)
+  {
+    tracer::enabled = false;
+    return http::OK("Tracing stopped.\n");
+  }
+};
+
+} // namespace process {
+
+#endif // __TRACER_HPP__
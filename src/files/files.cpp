@@ -1,26 +1,46 @@
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <poll.h>
+#include <regex.h>
 #include <unistd.h>
 
+#include <sys/socket.h>
 #include <sys/stat.h>
 
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif // __linux__
+
 #include <algorithm>
-#include <map>
+#include <queue>
 #include <string>
 #include <vector>
 
 #include <boost/shared_array.hpp>
 
+#include <process/async.hpp>
+#include <process/clock.hpp>
+#include <process/defer.hpp>
+#include <process/delay.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/http.hpp>
+#include <process/id.hpp>
 #include <process/io.hpp>
 #include <process/mime.hpp>
 #include <process/process.hpp>
 
+#include <stout/bytes.hpp>
+#include <stout/duration.hpp>
 #include <stout/error.hpp>
+#include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/json.hpp>
 #include <stout/lambda.hpp>
 #include <stout/none.hpp>
+#include <stout/nothing.hpp>
 #include <stout/numify.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
@@ -45,13 +65,342 @@ using process::http::OK;
 using process::http::Response;
 using process::http::Request;
 
-using std::map;
 using std::string;
 using std::vector;
 
 namespace mesos {
 namespace internal {
 
+// Tails don't read faster than this (per second), unless asked to
+// read slower.
+static const Bytes TAIL_RATE_LIMIT = Megabytes(1);
+
+// How often a tail checks whether the file grew (when it can't be
+// notified, or missed a notification) and whether the client is
+// still there.
+static const Duration TAIL_CHECK_INTERVAL = Seconds(1);
+
+// Longer lines are sent (or filtered) in pieces.
+static const size_t TAIL_MAX_LINE_LENGTH = 64 * 1024;
+
+
+// OS X doesn't have MSG_NOSIGNAL, the tail sets SO_NOSIGPIPE instead.
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+
+// Follows a file, writing the lines that get appended to it (and
+// that match the filter, if any) to a socket which gets streamed back
+// to the client (see FilesProcess::tail). On Linux the tail waits
+// for inotify to say that the file was modified, otherwise it checks
+// every TAIL_CHECK_INTERVAL. A truncated file gets tailed from the
+// start again. The tail terminates once the client goes away (i.e.,
+// the other end of the socket gets closed) or once it has read all of
+// a file that got rotated (i.e., the path refers to another file).
+class TailProcess : public Process<TailProcess>
+{
+public:
+  // Takes ownership of 'fd', 'pipe' (one end of a socketpair) and
+  // 'filter'.
+  TailProcess(const string& _path,
+              int _fd,
+              off_t _offset,
+              int _pipe,
+              regex_t* _filter,
+              const Bytes& _rate)
+    : ProcessBase(ID::generate("tail")),
+      path(_path),
+      fd(_fd),
+      offset(_offset),
+      pipe(_pipe),
+      filter(_filter),
+      rate(_rate.bytes()),
+      tokens(_rate.bytes()),
+      inotify(-1),
+      watching(false),
+      waiting(false),
+      finished(false) {}
+
+  virtual ~TailProcess()
+  {
+    os::close(fd);
+    os::close(pipe); // Ends the stream.
+
+    if (inotify >= 0) {
+      os::close(inotify);
+    }
+
+    if (filter != NULL) {
+      regfree(filter);
+      delete filter;
+    }
+  }
+
+protected:
+  virtual void initialize()
+  {
+    refilled = Clock::now();
+
+#ifdef __linux__
+    inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (inotify < 0) {
+      PLOG(WARNING) << "Failed to initialize inotify for '" << path << "'";
+    } else if (inotify_add_watch(inotify, path.c_str(), IN_MODIFY) < 0) {
+      PLOG(WARNING) << "Failed to watch '" << path << "'";
+      os::close(inotify);
+      inotify = -1;
+    }
+#endif // __linux__
+
+    check();
+  }
+
+private:
+  void check()
+  {
+    if (closed()) {
+      VLOG(1) << "Stopped tailing '" << path << "'";
+      finish();
+      return;
+    }
+
+    read();
+
+    delay(TAIL_CHECK_INTERVAL, self(), &TailProcess::check);
+  }
+
+  // Reads what got appended to the file, until caught up, the rate
+  // limit kicks in or the pipe is full.
+  void read()
+  {
+    if (waiting || finished) {
+      return; // Reading again once 'resume' gets called.
+    }
+
+    char data[16 * 4096];
+
+    while (true) {
+      if (!flush()) {
+        if (!finished) {
+          waiting = true;
+          io::poll(pipe, io::WRITE)
+            .onAny(defer(self(), &TailProcess::writable, lambda::_1));
+        }
+        return;
+      }
+
+      // Refill the tokens, allowing bursts of up to a second.
+      const Time now = Clock::now();
+      tokens = std::min(rate, tokens + rate * (now - refilled).secs());
+      refilled = now;
+
+      if (tokens < 1) {
+        waiting = true;
+        delay(Seconds(1) * ((1 - tokens) / rate),
+              self(),
+              &TailProcess::resume);
+        return;
+      }
+
+      size_t size = std::min(sizeof(data), (size_t) tokens);
+
+      ssize_t length = ::pread(fd, data, size, offset);
+
+      if (length < 0 && errno == EINTR) {
+        continue;
+      } else if (length < 0) {
+        PLOG(WARNING) << "Failed to read '" << path << "'";
+        finish();
+        return;
+      } else if (length == 0) {
+        // Caught up, unless the file got truncated (start over) or
+        // rotated (there's nothing more to read from this file).
+        if (truncated()) {
+          continue;
+        } else if (rotated()) {
+          VLOG(1) << "Stopped tailing '" << path << "': Rotated";
+          finish();
+          return;
+        }
+        watch();
+        return;
+      }
+
+      offset += length;
+      tokens -= length;
+
+      frame(data, length);
+    }
+  }
+
+  // Returns true (and starts over) if the file is shorter than what
+  // was read already.
+  bool truncated()
+  {
+    struct stat s;
+    if (::fstat(fd, &s) < 0 || s.st_size >= offset) {
+      return false;
+    }
+
+    VLOG(1) << "Tailing '" << path << "' from the start: Truncated";
+    offset = 0;
+    line.clear();
+    return true;
+  }
+
+  // Returns true if the path no longer refers to the file being read.
+  bool rotated()
+  {
+    struct stat s;
+    struct stat current;
+    return ::fstat(fd, &s) == 0 &&
+      (::stat(path.c_str(), &current) < 0 ||
+       current.st_dev != s.st_dev ||
+       current.st_ino != s.st_ino);
+  }
+
+  void resume()
+  {
+    waiting = false;
+    read();
+  }
+
+  void writable(const Future<short>& poll)
+  {
+    resume();
+  }
+
+  void changed(const Future<short>& poll)
+  {
+    watching = false;
+
+#ifdef __linux__
+    // Drain the events, all that matters is that there were some.
+    char events[4096];
+    while (::read(inotify, events, sizeof(events)) > 0);
+#endif // __linux__
+
+    read();
+  }
+
+  // Gets notified about the next modification, if possible.
+  void watch()
+  {
+    if (inotify >= 0 && !watching) {
+      watching = true;
+      io::poll(inotify, io::READ)
+        .onAny(defer(self(), &TailProcess::changed, lambda::_1));
+    }
+  }
+
+  // Splits the data into lines, holding on to the last line until it
+  // is complete, and queues the lines that match the filter.
+  void frame(const char* data, size_t length)
+  {
+    line.append(data, length);
+
+    size_t start = 0;
+    size_t end;
+    while ((end = line.find('\n', start)) != string::npos) {
+      append(start, end + 1);
+      start = end + 1;
+    }
+
+    if (line.size() - start > TAIL_MAX_LINE_LENGTH) {
+      append(start, line.size());
+      start = line.size();
+    }
+
+    line.erase(0, start);
+  }
+
+  void append(size_t start, size_t end)
+  {
+    if (filter != NULL) {
+      // Match without the newline so that '$' matches the end of
+      // the line.
+      size_t length = end - start;
+      if (length > 0 && line[end - 1] == '\n') {
+        length--;
+      }
+      const string& text = line.substr(start, length);
+      if (regexec(filter, text.c_str(), 0, NULL, 0) != 0) {
+        return;
+      }
+    }
+
+    output.append(line, start, end - start);
+  }
+
+  // Writes as much of the queued output as the pipe takes, returns
+  // false if some of it is left.
+  bool flush()
+  {
+    while (!output.empty()) {
+      // Sending with MSG_NOSIGNAL means a client that went away results
+      // in EPIPE rather than a SIGPIPE, which would kill the daemon
+      // (see the failure signal handlers in logging/logging.cpp).
+      ssize_t length =
+        ::send(pipe, output.data(), output.size(), MSG_NOSIGNAL);
+
+      if (length < 0 && errno == EINTR) {
+        continue;
+      } else if (length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return false;
+      } else if (length < 0) {
+        // Most likely EPIPE (or ECONNRESET), i.e., the client went away.
+        VLOG(1) << "Stopped tailing '" << path << "': " << strerror(errno);
+        finish();
+        return false;
+      }
+
+      output.erase(0, length);
+    }
+
+    return true;
+  }
+
+  // Returns true if nobody reads from the pipe anymore.
+  bool closed()
+  {
+    struct pollfd pollfd;
+    pollfd.fd = pipe;
+    pollfd.events = 0;
+    pollfd.revents = 0;
+
+    return ::poll(&pollfd, 1, 0) > 0 &&
+      (pollfd.revents & (POLLERR | POLLHUP)) != 0;
+  }
+
+  void finish()
+  {
+    finished = true;
+    terminate(self());
+  }
+
+  const string path;
+  const int fd;
+  off_t offset;
+  const int pipe;
+  regex_t* filter;
+
+  // Token bucket for the rate limit, in bytes.
+  const double rate;
+  double tokens;
+  Time refilled;
+
+  int inotify;
+  bool watching; // Whether waiting for inotify.
+  bool waiting;  // Whether throttled or waiting for the pipe.
+  bool finished;
+
+  string line;   // The last, incomplete line.
+  string output; // Queued for the pipe.
+};
+
+
 class FilesProcess : public Process<FilesProcess>
 {
 public:
@@ -77,14 +426,28 @@ private:
   // Returns a file listing for a directory.
   // Requests have the following parameters:
   //   path: The directory to browse. Required.
+  //   pattern: Only list the entries whose names match this glob.
+  //   limit: The maximum number of entries to list.
+  //   after: Only list the entries whose names sort after this one,
+  //     i.e., the name of the last entry of the previous page.
   // The response will contain a list of JSON files and directories contained
-  // in the path (see files::jsonFileInfo for the format).
+  // in the path (see files::jsonFileInfo for the format), sorted by name.
   Future<Response> browse(const Request& request);
 
   // Reads data from a file at a given offset and for a given length.
   // See the jquery pailer for the expected behavior.
   Future<Response> read(const Request& request);
 
+  // Streams what gets appended to a file, a line at a time.
+  // Requests have the following parameters:
+  //   path: The file to tail. Required.
+  //   offset: Where to start from, defaults to the end of the file.
+  //   filter: Only stream the lines that match this (extended)
+  //     regular expression.
+  //   rate: The most to read from the file per second (e.g., 64KB),
+  //     at most (and by default) TAIL_RATE_LIMIT.
+  Future<Response> tail(const Request& request);
+
   // Returns the raw file contents for a given path.
   // Requests have the following parameters:
   //   path: The directory to browse. Required.
@@ -106,6 +469,7 @@ void FilesProcess::initialize()
 {
   route("/browse.json", &FilesProcess::browse);
   route("/read.json", &FilesProcess::read);
+  route("/tail.json", &FilesProcess::tail);
   route("/download.json", &FilesProcess::download);
   route("/debug.json", &FilesProcess::debug);
 }
@@ -144,6 +508,105 @@ void FilesProcess::detach(const string& name)
 }
 
 
+// Lists the entries of 'directory' (attached at 'path') whose names
+// match 'pattern' and sort after 'after', sorted by name and up to
+// 'limit' of them. Only the names are kept while reading the
+// directory and only the entries that get listed are stat'ed (relative
+// to the directory), so a page of a huge directory stays cheap.
+static Try<JSON::Array> list(
+    const string& directory,
+    const string& path,
+    const Option<string>& pattern,
+    const Option<string>& after,
+    const Option<size_t>& limit)
+{
+  int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+
+  if (fd < 0) {
+    return ErrnoError("Failed to open '" + directory + "'");
+  }
+
+  DIR* dir = fdopendir(fd);
+
+  if (dir == NULL) {
+    Error error = ErrnoError("Failed to open '" + directory + "'");
+    ::close(fd);
+    return error;
+  }
+
+  // The (at most 'limit') smallest names so far, largest on top.
+  std::priority_queue<string> names;
+
+  struct dirent* entry;
+
+  errno = 0;
+  while ((entry = readdir(dir)) != NULL) {
+    const string name = entry->d_name;
+
+    if (name == "." || name == ".." ||
+        (after.isSome() && name <= after.get()) ||
+        (pattern.isSome() &&
+         fnmatch(pattern.get().c_str(), name.c_str(), 0) != 0)) {
+      errno = 0;
+      continue;
+    }
+
+    if (limit.isSome() && names.size() == limit.get()) {
+      if (name >= names.top()) {
+        errno = 0;
+        continue;
+      }
+      names.pop();
+    }
+
+    names.push(name);
+    errno = 0;
+  }
+
+  if (errno != 0) {
+    Error error = ErrnoError("Failed to read '" + directory + "'");
+    closedir(dir);
+    return error;
+  }
+
+  vector<string> sorted(names.size());
+  for (size_t i = sorted.size(); i > 0; i--) {
+    sorted[i - 1] = names.top();
+    names.pop();
+  }
+
+  JSON::Array listing;
+  foreach (const string& name, sorted) {
+    struct stat s;
+
+    if (fstatat(dirfd(dir), name.c_str(), &s, 0) < 0) {
+      PLOG(WARNING) << "Found " << path::join(directory, name)
+                    << " in the directory but stat failed";
+      continue;
+    }
+
+    listing.values.push_back(jsonFileInfo(path::join(path, name), s));
+  }
+
+  closedir(dir); // Also closes 'fd'.
+
+  return listing;
+}
+
+
+static Future<Response> _browse(
+    const Try<JSON::Array>& listing,
+    const Option<string>& jsonp)
+{
+  if (listing.isError()) {
+    LOG(WARNING) << listing.error();
+    return InternalServerError(listing.error() + ".\n");
+  }
+
+  return OK(listing.get(), jsonp);
+}
+
+
 Future<Response> FilesProcess::browse(const Request& request)
 {
   Option<string> path = request.query.get("path");
@@ -152,6 +615,18 @@ Future<Response> FilesProcess::browse(const Request& request)
     return BadRequest("Expecting 'path=value' in query.\n");
   }
 
+  Option<size_t> limit = None();
+
+  if (request.query.get("limit").isSome()) {
+    Try<size_t> result = numify<size_t>(request.query.get("limit").get());
+    if (result.isError()) {
+      return BadRequest("Failed to parse limit: " + result.error() + ".\n");
+    } else if (result.get() == 0) {
+      return BadRequest("Expecting a positive limit.\n");
+    }
+    limit = result.get();
+  }
+
   Result<string> resolvedPath = resolve(path.get());
 
   if (resolvedPath.isError()) {
@@ -160,27 +635,23 @@ Future<Response> FilesProcess::browse(const Request& request)
     return NotFound();
   }
 
-  // The result will be a sorted (on path) array of files and dirs:
-  // [{"name": "README", "path": "dir/README" "dir":False, "size":42}, ...]
-  map<string, JSON::Object> files;
-  foreach (const string& filename, os::ls(resolvedPath.get())) {
-    struct stat s;
-    string fullPath = path::join(resolvedPath.get(), filename);
-
-    if (stat(fullPath.c_str(), &s) < 0) {
-      PLOG(WARNING) << "Found " << fullPath << " in ls but stat failed";
-      continue;
-    }
-
-    files[fullPath] = jsonFileInfo(path::join(path.get(), filename), s);
+  // Files don't have any entries.
+  if (!os::isdir(resolvedPath.get())) {
+    return OK(JSON::Array(), request.query.get("jsonp"));
   }
 
-  JSON::Array listing;
-  foreachvalue(const JSON::Object& file, files) {
-    listing.values.push_back(file);
-  }
-
-  return OK(listing, request.query.get("jsonp"));
+  // The result will be a sorted (on path) array of files and dirs:
+  // [{"name": "README", "path": "dir/README" "dir":False, "size":42}, ...]
+  // Reading the directory happens off of this process since it can
+  // take a while for big directories.
+  return async(lambda::bind(
+      &list,
+      resolvedPath.get(),
+      path.get(),
+      request.query.get("pattern"),
+      request.query.get("after"),
+      limit))
+    .then(lambda::bind(&_browse, lambda::_1, request.query.get("jsonp")));
 }
 
 
@@ -314,6 +785,141 @@ Future<Response> FilesProcess::read(const Request& request)
 }
 
 
+Future<Response> FilesProcess::tail(const Request& request)
+{
+  Option<string> path = request.query.get("path");
+
+  if (!path.isSome() || path.get().empty()) {
+    return BadRequest("Expecting 'path=value' in query.\n");
+  }
+
+  off_t offset = -1;
+
+  if (request.query.get("offset").isSome()) {
+    Try<off_t> result = numify<off_t>(request.query.get("offset").get());
+    if (result.isError()) {
+      return BadRequest("Failed to parse offset: " + result.error() + ".\n");
+    } else if (result.get() < -1) {
+      return BadRequest("Negative offset provided: " +
+                        stringify(result.get()) + ".\n");
+    }
+    offset = result.get();
+  }
+
+  Bytes rate = TAIL_RATE_LIMIT;
+
+  if (request.query.get("rate").isSome()) {
+    Try<Bytes> result = Bytes::parse(request.query.get("rate").get());
+    if (result.isError()) {
+      return BadRequest("Failed to parse rate: " + result.error() + ".\n");
+    } else if (result.get() == Bytes(0)) {
+      return BadRequest("Expecting a positive rate.\n");
+    }
+    rate = std::min(rate, result.get());
+  }
+
+  Result<string> resolvedPath = resolve(path.get());
+
+  if (resolvedPath.isError()) {
+    return BadRequest(resolvedPath.error() + ".\n");
+  } else if (!resolvedPath.isSome()) {
+    return NotFound();
+  }
+
+  // Don't tail directories.
+  if (os::isdir(resolvedPath.get())) {
+    return BadRequest("Cannot tail a directory.\n");
+  }
+
+  regex_t* filter = NULL;
+
+  if (request.query.get("filter").isSome()) {
+    filter = new regex_t();
+    int code = regcomp(
+        filter,
+        request.query.get("filter").get().c_str(),
+        REG_EXTENDED | REG_NOSUB);
+
+    if (code != 0) {
+      char error[1024];
+      regerror(code, filter, error, sizeof(error));
+      delete filter;
+      return BadRequest("Failed to compile filter: " + string(error) + ".\n");
+    }
+  }
+
+  Try<int> fd = os::open(resolvedPath.get(), O_RDONLY);
+
+  if (fd.isError()) {
+    string error = strings::format("Failed to open file at '%s': %s",
+        resolvedPath.get(), fd.error()).get();
+    LOG(WARNING) << error;
+    if (filter != NULL) {
+      regfree(filter);
+      delete filter;
+    }
+    return InternalServerError(error + ".\n");
+  }
+
+  // The tail can hold on to the file for a long time, don't leak it
+  // into the executors (or anything else) that get forked meanwhile.
+  Try<Nothing> cloexec = os::cloexec(fd.get());
+
+  if (cloexec.isError()) {
+    string error = "Failed to set close-on-exec: " + cloexec.error();
+    LOG(WARNING) << error;
+    os::close(fd.get());
+    if (filter != NULL) {
+      regfree(filter);
+      delete filter;
+    }
+    return InternalServerError(error + ".\n");
+  }
+
+  // Start from the end if asked to or if the offset is past it.
+  off_t size = lseek(fd.get(), 0, SEEK_END);
+  if (offset == -1 || offset > size) {
+    offset = size;
+  }
+
+  // A socketpair rather than a pipe so that the tail can write to it
+  // without getting a SIGPIPE once the client went away (see
+  // TailProcess::flush).
+  int pipes[2];
+
+  if (::socketpair(AF_UNIX, SOCK_STREAM, 0, pipes) < 0 ||
+      os::cloexec(pipes[0]).isError() ||
+      os::cloexec(pipes[1]).isError() ||
+      os::nonblock(pipes[1]).isError()) {
+    string error = "Failed to create socketpair: " + string(strerror(errno));
+    LOG(WARNING) << error;
+    os::close(fd.get());
+    if (filter != NULL) {
+      regfree(filter);
+      delete filter;
+    }
+    return InternalServerError(error + ".\n");
+  }
+
+#ifdef SO_NOSIGPIPE
+  int on = 1;
+  ::setsockopt(pipes[1], SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif // SO_NOSIGPIPE
+
+  // The tail cleans up after itself once the response (and with it
+  // the read end of the socketpair) goes away.
+  spawn(new TailProcess(
+      resolvedPath.get(), fd.get(), offset, pipes[1], filter, rate), true);
+
+  OK response;
+  response.type = response.PIPE;
+  response.pipe = pipes[0];
+  response.headers["Content-Type"] = "text/plain";
+
+  return response;
+}
+
+
 Future<Response> FilesProcess::download(const Request& request)
 {
   Option<string> path = request.query.get("path");
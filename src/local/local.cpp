@@ -43,7 +43,7 @@ using namespace mesos::internal;
 using mesos::internal::master::allocator::Allocator;
 using mesos::internal::master::allocator::AllocatorProcess;
 using mesos::internal::master::allocator::DRFSorter;
-using mesos::internal::master::allocator::HierarchicalDRFAllocatorProcess;
+using mesos::internal::master::allocator::createHierarchicalDRFAllocatorProcess;
 
 using mesos::internal::master::Master;
 
@@ -78,19 +78,6 @@ PID<Master> launch(const Flags& flags, Allocator* _allocator)
     LOG(FATAL) << "Can only launch one local cluster at a time (for now)";
   }
 
-  if (_allocator == NULL) {
-    // Create default allocator, save it for deleting later.
-    allocatorProcess = new HierarchicalDRFAllocatorProcess();
-    _allocator = allocator = new Allocator(allocatorProcess);
-  } else {
-    // TODO(benh): Figure out the behavior of allocator pointer and remove the
-    // else block.
-    allocator = NULL;
-    allocatorProcess = NULL;
-  }
-
-  files = new Files();
-
   {
     master::Flags flags;
     Try<Nothing> load = flags.load("MESOS_", true); // Allow unknown flags.
@@ -98,6 +85,25 @@ PID<Master> launch(const Flags& flags, Allocator* _allocator)
       EXIT(1) << "Failed to start a local cluster while loading "
               << "master flags from the environment: " << load.error();
     }
+
+    if (_allocator == NULL) {
+      // Create default allocator, save it for deleting later.
+      Try<AllocatorProcess*> process =
+        createHierarchicalDRFAllocatorProcess(flags.placement);
+      if (process.isError()) {
+        EXIT(1) << "Failed to start a local cluster: " << process.error();
+      }
+      allocatorProcess = process.get();
+      _allocator = allocator = new Allocator(allocatorProcess);
+    } else {
+      // TODO(benh): Figure out the behavior of allocator pointer and remove
+      // the else block.
+      allocator = NULL;
+      allocatorProcess = NULL;
+    }
+
+    files = new Files();
+
     master = new Master(_allocator, files, flags);
   }
 
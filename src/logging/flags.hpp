@@ -21,6 +21,7 @@
 
 #include <string>
 
+#include <stout/bytes.hpp>
 #include <stout/flags.hpp>
 #include <stout/option.hpp>
 
@@ -48,11 +49,27 @@ public:
         "logbufsecs",
         "How many seconds to buffer log messages for",
         0);
+
+    add(&Flags::async_logging,
+        "async_logging",
+        "Write log files from a dedicated thread so that a slow\n"
+        "disk can't stall the caller (warnings and errors are\n"
+        "still written before the logging call returns)",
+        false);
+
+    add(&Flags::async_logging_buffer,
+        "async_logging_buffer",
+        "Maximum number of bytes of log messages waiting to be\n"
+        "written when using --async_logging, informational\n"
+        "messages that don't fit are dropped (and counted)",
+        Megabytes(8));
   }
 
   bool quiet;
   Option<std::string> log_dir;
   int logbufsecs;
+  bool async_logging;
+  Bytes async_logging_buffer;
 };
 
 } // namespace logging {
@@ -17,7 +17,9 @@
  */
 
 #include <signal.h> // For sigaction(), sigemptyset().
+#include <stdlib.h> // For atexit().
 #include <string.h> // For strsignal().
+#include <unistd.h> // For getpid().
 
 #include <glog/logging.h>
 
@@ -27,16 +29,20 @@
 
 #include <stout/error.hpp>
 #include <stout/exit.hpp>
+#include <stout/foreach.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
 #include <stout/stringify.hpp>
 #include <stout/try.hpp>
 
+#include "common/lock.hpp"
+
 #include "logging/logging.hpp"
 
 using process::Once;
 
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -46,6 +52,19 @@ namespace logging {
 // string we pass to it to be accessible indefinitely.
 string argv0;
 
+// The logger installed for INFO when logging asynchronously (see
+// 'initialize' below), never deleted so that it can be used while
+// exiting.
+AsyncLogger* async = NULL;
+
+
+void flush()
+{
+  if (async != NULL) {
+    async->Flush();
+  }
+}
+
 
 void handler(int signal)
 {
@@ -88,6 +107,21 @@ void initialize(
 
   google::InitGoogleLogging(argv0.c_str());
 
+  // Every message gets written to the INFO log (glog also writes a
+  // message to the log of each severity below its own), so that is
+  // the only log we write asynchronously; the logs of the other
+  // severities only get the less frequent messages, which glog
+  // flushes immediately anyway.
+  if (flags.async_logging) {
+    async = new AsyncLogger(
+        google::base::GetLogger(google::INFO),
+        flags.async_logging_buffer.bytes());
+    google::base::SetLogger(google::INFO, async);
+
+    // Make sure any queued messages get written when exiting.
+    atexit(&flush);
+  }
+
   VLOG(1) << "Logging to " <<
     (flags.log_dir.isSome() ? flags.log_dir.get() : "STDERR");
 
@@ -135,6 +169,188 @@ Try<string> getLogFile(google::LogSeverity severity)
   return path::join(FLAGS_log_dir, basename.get()) + "." + suffix;
 }
 
+
+uint64_t dropped()
+{
+  return async != NULL ? async->dropped() : 0;
+}
+
+
+AsyncLogger::AsyncLogger(google::base::Logger* _logger, size_t _capacity)
+  : logger(CHECK_NOTNULL(_logger)),
+    capacity(_capacity),
+    pid(getpid()),
+    bytes(0),
+    writing(0),
+    queued(0),
+    completed(0),
+    drops(0),
+    terminating(false)
+{
+  pthread_mutex_init(&mutex, NULL);
+  pthread_cond_init(&pending, NULL);
+  pthread_cond_init(&written, NULL);
+
+  if (pthread_create(&thread, NULL, &AsyncLogger::run, this) != 0) {
+    PLOG(FATAL) << "Failed to create log writer thread";
+  }
+}
+
+
+AsyncLogger::~AsyncLogger()
+{
+  {
+    Lock lock(&mutex);
+    terminating = true;
+    pthread_cond_signal(&pending);
+  }
+
+  // The writer thread writes any queued messages before exiting.
+  pthread_join(thread, NULL);
+
+  pthread_cond_destroy(&written);
+  pthread_cond_destroy(&pending);
+  pthread_mutex_destroy(&mutex);
+}
+
+
+void AsyncLogger::Write(
+    bool flush,
+    time_t timestamp,
+    const char* message,
+    int length)
+{
+  // After a fork there's no writer thread (and the mutex might have
+  // been held by a thread that doesn't exist in the child).
+  if (getpid() != pid) {
+    logger->Write(flush, timestamp, message, length);
+    return;
+  }
+
+  Lock lock(&mutex);
+
+  // Never drop a message that needs to be flushed, those are the
+  // warnings and errors. The batch being written still holds its
+  // memory so it counts against the capacity as well.
+  if (!flush && bytes + writing + length > capacity) {
+    drops++;
+    return;
+  }
+
+  Entry entry;
+  entry.timestamp = timestamp;
+  entry.flush = flush;
+  entries.push_back(entry);
+  entries.back().message.assign(message, length);
+
+  bytes += length;
+
+  uint64_t sequence = ++queued;
+
+  pthread_cond_signal(&pending);
+
+  if (flush) {
+    while (completed < sequence) {
+      pthread_cond_wait(&written, &mutex);
+    }
+  }
+}
+
+
+void AsyncLogger::Flush()
+{
+  if (getpid() == pid) {
+    Lock lock(&mutex);
+    uint64_t sequence = queued;
+    while (completed < sequence) {
+      pthread_cond_wait(&written, &mutex);
+    }
+  }
+
+  logger->Flush();
+}
+
+
+google::uint32 AsyncLogger::LogSize()
+{
+  return logger->LogSize();
+}
+
+
+uint64_t AsyncLogger::dropped()
+{
+  if (getpid() != pid) {
+    return drops; // No other threads to race with.
+  }
+
+  Lock lock(&mutex);
+  return drops;
+}
+
+
+void* AsyncLogger::run(void* arg)
+{
+  AsyncLogger* logger = reinterpret_cast<AsyncLogger*>(arg);
+  logger->loop();
+  return NULL;
+}
+
+
+void AsyncLogger::loop()
+{
+  uint64_t reported = 0; // Number of drops already logged.
+
+  vector<Entry> batch;
+
+  Lock lock(&mutex);
+
+  while (true) {
+    while (entries.empty() && drops == reported && !terminating) {
+      pthread_cond_wait(&pending, &mutex);
+    }
+
+    if (entries.empty() && drops == reported) {
+      CHECK(terminating);
+      return;
+    }
+
+    // Take everything that's queued so that callers only contend
+    // with us for as long as it takes to swap the vectors.
+    batch.swap(entries);
+    writing = bytes;
+    bytes = 0;
+
+    uint64_t dropped = drops - reported;
+    reported = drops;
+
+    lock.unlock();
+
+    if (dropped > 0) {
+      const string message =
+        "Dropped " + stringify(dropped) + " log messages because "
+        "too many messages were waiting to be written\n";
+      logger->Write(false, time(NULL), message.data(), message.size());
+    }
+
+    foreach (const Entry& entry, batch) {
+      logger->Write(
+          entry.flush,
+          entry.timestamp,
+          entry.message.data(),
+          entry.message.size());
+    }
+
+    size_t size = batch.size();
+    batch.clear();
+
+    lock.lock();
+
+    completed += size;
+    writing = 0;
+    pthread_cond_broadcast(&written);
+  }
+}
+
 } // namespace logging {
 } // namespace internal {
 } // namespace mesos {
@@ -19,10 +19,18 @@
 #ifndef __LOGGING_LOGGING_HPP__
 #define __LOGGING_LOGGING_HPP__
 
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
 #include <string>
+#include <vector>
 
 #include <glog/logging.h> // Includes LOG(*), PLOG(*), CHECK, etc.
 
+#include <stout/try.hpp>
+
 #include "logging/flags.hpp"
 
 namespace mesos {
@@ -39,6 +47,70 @@ void initialize(
 // LogSeverity is one of {INFO, WARNING, ERROR}.
 Try<std::string> getLogFile(google::LogSeverity severity);
 
+
+// Returns the number of log messages that were dropped because too
+// many messages were waiting to be written (see --async_logging).
+uint64_t dropped();
+
+
+// A glog logger that writes messages through another logger from a
+// dedicated thread, so that logging only costs the caller a copy of
+// the (already formatted) message rather than a write to a possibly
+// slow disk. Messages glog wants flushed (i.e., anything above
+// --logbuflevel, which includes warnings and errors) are written
+// before 'Write' returns. When more than 'capacity' bytes of
+// messages are waiting to be written other messages are dropped
+// (and counted) instead of blocking the caller. A child that forks
+// without exec'ing doesn't get the writer thread, so in the child
+// messages get written synchronously through the wrapped logger.
+class AsyncLogger : public google::base::Logger
+{
+public:
+  AsyncLogger(google::base::Logger* logger, size_t capacity);
+  virtual ~AsyncLogger();
+
+  virtual void Write(
+      bool flush,
+      time_t timestamp,
+      const char* message,
+      int length);
+
+  virtual void Flush();
+
+  virtual google::uint32 LogSize();
+
+  // Returns the number of messages dropped so far.
+  uint64_t dropped();
+
+private:
+  struct Entry
+  {
+    time_t timestamp;
+    bool flush;
+    std::string message;
+  };
+
+  static void* run(void* arg);
+  void loop();
+
+  google::base::Logger* logger; // Not owned.
+  const size_t capacity;
+  const pid_t pid; // Process that started the writer thread.
+
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t pending; // Signaled when an entry is queued.
+  pthread_cond_t written; // Broadcasted when entries are written.
+
+  std::vector<Entry> entries; // Queued but not yet written.
+  size_t bytes; // Size of the queued messages.
+  size_t writing; // Size of the messages being written.
+  uint64_t queued; // Total number of entries queued.
+  uint64_t completed; // Total number of entries written.
+  uint64_t drops; // Total number of messages dropped.
+  bool terminating;
+};
+
 } // namespace logging {
 } // namespace internal {
 } // namespace mesos {
@@ -20,12 +20,14 @@
 #define __ALLOCATOR_HPP__
 
 #include <string>
+#include <vector>
 
 #include <process/future.hpp>
 #include <process/dispatch.hpp>
 #include <process/pid.hpp>
 #include <process/process.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
 #include <stout/option.hpp>
@@ -44,6 +46,35 @@ class Master; // Forward declaration.
 
 namespace allocator {
 
+// A slave being added, see AllocatorProcess::slavesAdded.
+struct AddedSlave
+{
+  AddedSlave(const SlaveID& _slaveId,
+             const SlaveInfo& _slaveInfo,
+             const hashmap<FrameworkID, Resources>& _used)
+    : slaveId(_slaveId), slaveInfo(_slaveInfo), used(_used) {}
+
+  SlaveID slaveId;
+  SlaveInfo slaveInfo;
+  hashmap<FrameworkID, Resources> used;
+};
+
+
+// Resources being recovered, see
+// AllocatorProcess::resourcesRecoveredBatch.
+struct RecoveredResources
+{
+  RecoveredResources(const FrameworkID& _frameworkId,
+                     const SlaveID& _slaveId,
+                     const Resources& _resources)
+    : frameworkId(_frameworkId), slaveId(_slaveId), resources(_resources) {}
+
+  FrameworkID frameworkId;
+  SlaveID slaveId;
+  Resources resources;
+};
+
+
 // Basic model of an allocator: resources are allocated to a framework
 // in the form of offers. A framework can refuse some resources in
 // offers and run tasks in others. Resources can be recovered from a
@@ -111,6 +142,30 @@ public:
   // offers for those resources the master invokes this callback.
   virtual void offersRevived(
       const FrameworkID& frameworkId) = 0;
+
+  // Bulk versions of 'slaveAdded' and 'resourcesRecovered' that the
+  // master invokes when it has many changes at once (e.g., slaves
+  // re-registering after a failover or a framework being removed),
+  // so that an allocator can apply them all before (re)allocating.
+  // By default these just invoke the single versions in order.
+  virtual void slavesAdded(
+      const std::vector<AddedSlave>& slaves)
+  {
+    foreach (const AddedSlave& slave, slaves) {
+      slaveAdded(slave.slaveId, slave.slaveInfo, slave.used);
+    }
+  }
+
+  virtual void resourcesRecoveredBatch(
+      const std::vector<RecoveredResources>& recovered)
+  {
+    foreach (const RecoveredResources& resources, recovered) {
+      resourcesRecovered(
+          resources.frameworkId,
+          resources.slaveId,
+          resources.resources);
+    }
+  }
 };
 
 
@@ -175,6 +230,12 @@ public:
   void offersRevived(
       const FrameworkID& frameworkId);
 
+  void slavesAdded(
+      const std::vector<AddedSlave>& slaves);
+
+  void resourcesRecoveredBatch(
+      const std::vector<RecoveredResources>& recovered);
+
 private:
   Allocator(const Allocator&); // Not copyable.
   Allocator& operator=(const Allocator&); // Not assignable.
@@ -339,6 +400,30 @@ inline void Allocator::offersRevived(
       frameworkId);
 }
 
+
+inline void Allocator::slavesAdded(
+    const std::vector<AddedSlave>& slaves)
+{
+  if (!slaves.empty()) {
+    process::dispatch(
+        process,
+        &AllocatorProcess::slavesAdded,
+        slaves);
+  }
+}
+
+
+inline void Allocator::resourcesRecoveredBatch(
+    const std::vector<RecoveredResources>& recovered)
+{
+  if (!recovered.empty()) {
+    process::dispatch(
+        process,
+        &AllocatorProcess::resourcesRecoveredBatch,
+        recovered);
+  }
+}
+
 } // namespace allocator {
 } // namespace master {
 } // namespace internal {
@@ -31,9 +31,15 @@ const uint32_t MAX_CPUS = 1000 * 1000;
 const uint32_t MAX_MEM = 1024 * 1024 * Megabyte;
 const Duration SLAVE_PING_TIMEOUT = Seconds(15);
 const uint32_t MAX_SLAVE_PING_TIMEOUTS = 5;
+const Duration SLAVE_PING_BATCH_INTERVAL = Milliseconds(100);
+const double SLAVE_PING_JITTER = 0.1;
 const uint32_t MAX_COMPLETED_FRAMEWORKS = 50;
 const uint32_t MAX_COMPLETED_TASKS_PER_FRAMEWORK = 1000;
+const uint32_t MAX_HISTORY_PAGE_SIZE = 1000;
+const uint32_t MAX_HISTORY_RECORDS = 1000000;
 const Duration WHITELIST_WATCH_INTERVAL = Seconds(5);
+const Duration OFFER_HOLD_TIME_RESOLUTION = Milliseconds(10);
+const uint32_t OFFER_HOLD_TIME_BUCKETS = 6;
 
 } // namespace mesos {
 } // namespace internal {
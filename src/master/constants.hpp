@@ -57,17 +57,41 @@ extern const Duration SLAVE_PING_TIMEOUT;
 // Maximum number of ping timeouts until slave is considered failed.
 extern const uint32_t MAX_SLAVE_PING_TIMEOUTS;
 
+// Default minimum amount of time between two rounds of slave pings
+// (see --slave_ping_batch_interval).
+extern const Duration SLAVE_PING_BATCH_INTERVAL;
+
+// Default fraction of the slave ping timeout by which a slave's next
+// ping may be moved up (see --slave_ping_jitter).
+extern const double SLAVE_PING_JITTER;
+
 // Maximum number of completed frameworks to store in the cache.
 // TODO(thomasm): Make configurable.
 extern const uint32_t MAX_COMPLETED_FRAMEWORKS;
 
-// Maximum number of completed tasks per framework to store in the
-// cache.  TODO(thomasm): Make configurable.
+// Default maximum number of completed tasks per framework to store
+// in the cache (see --max_completed_tasks_per_framework).
 extern const uint32_t MAX_COMPLETED_TASKS_PER_FRAMEWORK;
 
+// Maximum number of completed tasks or frameworks returned per
+// request for the on-disk history (see --history_dir).
+extern const uint32_t MAX_HISTORY_PAGE_SIZE;
+
+// Default maximum number of completed tasks and frameworks kept in
+// the on-disk history (see --max_history_records).
+extern const uint32_t MAX_HISTORY_RECORDS;
+
 // Time interval to check for updated watchers list.
 extern const Duration WHITELIST_WATCH_INTERVAL;
 
+// Upper bound of the first bucket of the offer hold time histograms,
+// each following bucket's bound is 10 times larger.
+extern const Duration OFFER_HOLD_TIME_RESOLUTION;
+
+// Number of bounded buckets in the offer hold time histograms (there
+// is one more bucket for everything longer).
+extern const uint32_t OFFER_HOLD_TIME_BUCKETS;
+
 } // namespace mesos {
 } // namespace internal {
 } // namespace master {
@@ -34,6 +34,9 @@ bool DRFComparator::operator () (
     const Client& client1,
     const Client& client2)
 {
+  if (client1.satisfied != client2.satisfied) {
+    return !client1.satisfied;
+  }
   if (client1.share == client2.share) {
     return client1.name < client2.name;
   }
@@ -43,24 +46,27 @@ bool DRFComparator::operator () (
 
 void DRFSorter::add(const string& name)
 {
-  Client client;
-  client.name = name;
-  client.share = 0;
-  clients.insert(client);
-
   allocations[name] = Resources::parse("");
+  scalars[name] = hashmap<string, double>();
+
+  activate(name);
 }
 
 
 void DRFSorter::remove(const string& name)
 {
-  set<Client, DRFComparator>::iterator it = find(name);
+  deactivate(name);
 
-  if (it != clients.end()) {
-    clients.erase(it);
+  if (scalars.contains(name)) {
+    foreachkey (const string& kind, scalars[name]) {
+      holders[kind].erase(name);
+    }
   }
 
   allocations.erase(name);
+  scalars.erase(name);
+  weights.erase(name);
+  quotas.erase(name);
 }
 
 
@@ -68,20 +74,53 @@ void DRFSorter::activate(const string& name)
 {
   CHECK(allocations.contains(name));
 
+  // Inserting an active client again would leave a stale entry
+  // behind in 'clients'.
+  if (active.contains(name)) {
+    return;
+  }
+
   Client client;
   client.name = name;
   client.share = calculateShare(name);
+  client.satisfied = calculateSatisfied(name);
   clients.insert(client);
+  active[name] = client;
 }
 
 
 void DRFSorter::deactivate(const string& name)
 {
-  set<Client, DRFComparator>::iterator it = find(name);
+  if (active.contains(name)) {
+    clients.erase(active[name]);
+    active.erase(name);
+  }
+}
+
+
+void DRFSorter::weight(const string& name, double weight)
+{
+  CHECK(weight > 0) << "Invalid weight " << weight << " for " << name;
 
-  if (it != clients.end()) {
-    clients.erase(it);
+  if (weight == 1) {
+    weights.erase(name);
+  } else {
+    weights[name] = weight;
   }
+
+  update(name);
+}
+
+
+void DRFSorter::quota(const string& name, const Resources& quota)
+{
+  if (quota.size() == 0) {
+    quotas.erase(name);
+  } else {
+    quotas[name] = quota;
+  }
+
+  update(name);
 }
 
 
@@ -91,12 +130,13 @@ void DRFSorter::allocated(
 {
   allocations[name] += resources;
 
-  // If the total resources have changed, we're going to
-  // recalculate all the shares, so don't bother just
-  // updating this client.
-  if (!dirty) {
-    update(name);
+  foreach (const Resource& resource, resources) {
+    if (resource.type() == Value::SCALAR) {
+      allocate(name, resource.name(), resource.scalar().value());
+    }
   }
+
+  update(name);
 }
 
 
@@ -113,45 +153,60 @@ void DRFSorter::unallocated(
 {
   allocations[name] -= resources;
 
-  if (!dirty) {
-    update(name);
+  foreach (const Resource& resource, resources) {
+    if (resource.type() == Value::SCALAR) {
+      allocate(name, resource.name(), -resource.scalar().value());
+    }
   }
+
+  update(name);
 }
 
 
 void DRFSorter::add(const Resources& _resources)
 {
-  resources += _resources;
+  foreach (const Resource& resource, _resources) {
+    if (resource.type() == Value::SCALAR) {
+      totals[resource.name()] += resource.scalar().value();
 
-  // We have to recalculate all shares when the total resources
-  // change, but we put it off until sort is called
-  // so that if something else changes before the next allocation
-  // we don't recalculate everything twice.
-  dirty = true;
+      // Only the clients holding this kind of resource have to get
+      // a new share, but we put it off until sort is called so that
+      // if something else changes before the next allocation we
+      // don't recalculate them twice.
+      dirty.insert(resource.name());
+    }
+  }
 }
 
 
 void DRFSorter::remove(const Resources& _resources)
 {
-  resources -= _resources;
-  dirty = true;
+  foreach (const Resource& resource, _resources) {
+    if (resource.type() == Value::SCALAR) {
+      totals[resource.name()] -= resource.scalar().value();
+      dirty.insert(resource.name());
+    }
+  }
 }
 
 
 list<string> DRFSorter::sort()
 {
-  if (dirty) {
-    set<Client, DRFComparator> temp;
+  if (!dirty.empty()) {
+    hashset<string> stale;
+    foreach (const string& kind, dirty) {
+      if (holders.contains(kind)) {
+        foreach (const string& name, holders[kind]) {
+          stale.insert(name);
+        }
+      }
+    }
 
-    set<Client, DRFComparator>::iterator it;
-    for (it = clients.begin(); it != clients.end(); it++) {
-      Client client;
-      client.name = (*it).name;
-      client.share = calculateShare((*it).name);
-      temp.insert(client);
+    foreach (const string& name, stale) {
+      update(name);
     }
 
-    clients = temp;
+    dirty.clear();
   }
 
   list<string> ret;
@@ -176,16 +231,22 @@ int DRFSorter::count()
   return allocations.size();
 }
 
+
 void DRFSorter::update(const string& name)
 {
-  set<Client, DRFComparator>::iterator it;
-  it = find(name);
-  clients.erase(it);
+  if (!active.contains(name)) {
+    // Deactivated clients get a new share when they are activated.
+    return;
+  }
+
+  clients.erase(active[name]);
 
   Client client;
   client.name = name;
   client.share = calculateShare(name);
+  client.satisfied = calculateSatisfied(name);
   clients.insert(client);
+  active[name] = client;
 }
 
 
@@ -197,34 +258,64 @@ double DRFSorter::calculateShare(const string& name)
   // currently does not take into account resources that are not
   // scalars.
 
-  foreach (const Resource& resource, resources) {
-    if (resource.type() == Value::SCALAR) {
-      double total = resource.scalar().value();
-
-    if (total > 0) {
-      Value::Scalar none;
-      const Value::Scalar& scalar =
-        allocations[name].get(resource.name(), none);
-
-      share = std::max(share, scalar.value() / total);
+  // Only the kinds of resources the client holds can contribute
+  // to its share.
+  foreachpair (const string& kind, double amount, scalars[name]) {
+    if (totals.contains(kind) && totals[kind] > 0) {
+      share = std::max(share, amount / totals[kind]);
     }
   }
-}
+
+  if (weights.contains(name)) {
+    share /= weights[name];
+  }
 
   return share;
 }
 
 
-set<Client, DRFComparator>::iterator DRFSorter::find(const string& name)
+bool DRFSorter::calculateSatisfied(const string& name)
 {
-  set<Client, DRFComparator>::iterator it;
-  for (it = clients.begin(); it != clients.end(); it++) {
-    if (name == (*it).name) {
-      break;
+  if (!quotas.contains(name)) {
+    return true;
+  }
+
+  const hashmap<string, double>& allocated = scalars[name];
+
+  foreach (const Resource& resource, quotas[name]) {
+    if (resource.type() == Value::SCALAR) {
+      double amount =
+        allocated.contains(resource.name())
+        ? allocated.find(resource.name())->second
+        : 0;
+
+      if (amount < resource.scalar().value()) {
+        return false;
+      }
     }
   }
 
-  return it;
+  return true;
+}
+
+
+void DRFSorter::allocate(
+    const string& name,
+    const string& kind,
+    double amount)
+{
+  hashmap<string, double>& allocated = scalars[name];
+
+  allocated[kind] += amount;
+
+  // Comparing against a small epsilon rather than zero so that
+  // rounding errors don't leave behind clients holding nothing.
+  if (allocated[kind] <= 1e-9) {
+    allocated.erase(kind);
+    holders[kind].erase(name);
+  } else {
+    holders[kind].insert(name);
+  }
 }
 
 } // namespace allocator {
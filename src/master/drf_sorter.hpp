@@ -23,6 +23,7 @@
 #include <string>
 
 #include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
 
 #include "common/resources.hpp"
 
@@ -37,10 +38,17 @@ namespace allocator {
 struct Client
 {
   std::string name;
+
+  // Dominant share divided by the client's weight.
   double share;
+
+  // False while the client's allocation doesn't cover its quota.
+  bool satisfied;
 };
 
 
+// Clients that are below their quota come first, then clients are
+// ordered by (weighted) share.
 struct DRFComparator
 {
   virtual ~DRFComparator() {}
@@ -65,6 +73,10 @@ public:
 
   virtual void deactivate(const std::string& name);
 
+  virtual void weight(const std::string& name, double weight);
+
+  virtual void quota(const std::string& name, const Resources& quota);
+
   virtual void allocated(const std::string& name,
                          const Resources& resources);
 
@@ -84,28 +96,54 @@ public:
   virtual int count();
 
 private:
-  // Recalculates the share for the client and moves
-  // it in 'clients' accordingly.
+  // Recalculates the share for the client and, if it is active,
+  // moves it in 'clients' accordingly.
   void update(const std::string& name);
 
-  // Returns the dominant resource share for the client.
+  // Returns the dominant resource share for the client,
+  // divided by its weight.
   double calculateShare(const std::string& name);
 
-  // Returns an iterator to the specified client, if
-  // it exists in this Sorter.
-  std::set<Client, DRFComparator>::iterator find(const std::string& name);
+  // Returns true if the client's allocation covers its quota.
+  bool calculateSatisfied(const std::string& name);
+
+  // Adds 'amount' of the scalar resource 'kind' to (or removes
+  // it from, if negative) the client's allocation.
+  void allocate(const std::string& name,
+                const std::string& kind,
+                double amount);
 
-  // If true, start() will recalculate all shares.
-  bool dirty;
+  // Kinds of resources whose total changed since the last sort,
+  // only the clients holding these need a new share.
+  hashset<std::string> dirty;
 
-  // A set of Clients (names and shares) sorted by share.
+  // A set of active Clients (names and shares) sorted by share.
   std::set<Client, DRFComparator> clients;
 
+  // The entry in 'clients' of each active client, so that
+  // it can be found without walking 'clients'.
+  hashmap<std::string, Client> active;
+
   // Maps client names to the resources they have been allocated.
   hashmap<std::string, Resources> allocations;
 
-  // Total resources.
-  Resources resources;
+  // Maps client names to the amount of each scalar resource they
+  // have been allocated (absent kinds are zero). This is what the
+  // shares are computed from.
+  hashmap<std::string, hashmap<std::string, double> > scalars;
+
+  // Maps each kind of scalar resource to the clients that hold
+  // some of it, i.e., whose share depends on its total.
+  hashmap<std::string, hashset<std::string> > holders;
+
+  // Clients with a weight other than 1.
+  hashmap<std::string, double> weights;
+
+  // Clients with a quota.
+  hashmap<std::string, Resources> quotas;
+
+  // Total amount of each kind of scalar resource.
+  hashmap<std::string, double> totals;
 };
 
 } // namespace allocator {
@@ -26,6 +26,8 @@
 
 #include "logging/flags.hpp"
 
+#include "master/constants.hpp"
+
 namespace mesos {
 namespace internal {
 namespace master {
@@ -73,12 +75,99 @@ public:
         "are the same as for user_allocator",
         "drf");
 
+    add(&Flags::user_weights,
+        "user_weights",
+        "Weights of users for the user_sorter, a user with\n"
+        "twice the weight is entitled to twice the resources\n"
+        "(e.g., alice=2,bob=0.5). Users not listed get 1");
+
+    add(&Flags::user_quotas,
+        "user_quotas",
+        "Resources guaranteed to users, that get offered\n"
+        "ahead of everyone else until they hold their quota.\n"
+        "Quotas are separated by whitespace, e.g.,\n"
+        "'alice=cpus:8;ports:[31000-31099,32000-32099] bob=cpus:2'");
+
+    add(&Flags::placement,
+        "placement",
+        "Policy to use for choosing which slaves'\n"
+        "resources to offer a framework. May be one of:\n"
+        "  default (offer every slave, in no particular order)\n"
+        "  spread (offer every slave, emptiest first)\n"
+        "  pack (offer the fullest slaves first and\n"
+        "        idle slaves only when needed)",
+        "default");
+
     add(&Flags::allocation_interval,
         "allocation_interval",
         "Amount of time to wait between performing\n"
         " (batch) allocations (e.g., 500ms, 1sec, etc)",
         Seconds(1));
 
+    add(&Flags::offer_timeout,
+        "offer_timeout",
+        "Duration of time before an offer is rescinded from a\n"
+        "framework, so that a framework that holds on to offers\n"
+        "can't keep the resources from other frameworks\n"
+        "(e.g., 30secs, 5mins, etc). Offers never time out by default");
+
+    add(&Flags::slave_reregistration_batch,
+        "slave_reregistration_batch",
+        "Maximum number of slave re-registrations to\n"
+        "process before handling other messages, the\n"
+        "rest stay queued (e.g., after a failover when\n"
+        "all slaves re-register at once)",
+        50);
+
+    add(&Flags::slave_ping_timeout,
+        "slave_ping_timeout",
+        "Amount of time to wait for a slave to answer a ping\n"
+        "before pinging it again (e.g., 15secs, 1mins, etc)",
+        SLAVE_PING_TIMEOUT);
+
+    add(&Flags::slave_ping_batch_interval,
+        "slave_ping_batch_interval",
+        "Minimum amount of time between two rounds of slave\n"
+        "pings, the slaves that come due in between get\n"
+        "pinged in the same round (e.g., 100ms, 1secs, etc)",
+        SLAVE_PING_BATCH_INTERVAL);
+
+    add(&Flags::slave_ping_jitter,
+        "slave_ping_jitter",
+        "Fraction of --slave_ping_timeout (between 0 and 1)\n"
+        "by which a slave's next ping may be moved up, to\n"
+        "spread out the pings of slaves that registered at\n"
+        "the same time",
+        SLAVE_PING_JITTER);
+
+    add(&Flags::max_slave_ping_timeouts,
+        "max_slave_ping_timeouts",
+        "Number of pings in a row a slave can leave\n"
+        "unanswered before it is considered lost",
+        MAX_SLAVE_PING_TIMEOUTS);
+
+    add(&Flags::history_dir,
+        "history_dir",
+        "Directory where the completed frameworks and tasks that\n"
+        "no longer fit in memory get appended to, instead of\n"
+        "being dropped. They can be read back a page at a time\n"
+        "from /master/completed_frameworks.json and\n"
+        "/master/completed_tasks.json");
+
+    add(&Flags::max_history_records,
+        "max_history_records",
+        "Maximum number of completed tasks and frameworks\n"
+        "kept in the history (see --history_dir), the\n"
+        "oldest ones get deleted first",
+        MAX_HISTORY_RECORDS);
+
+    add(&Flags::max_completed_tasks_per_framework,
+        "max_completed_tasks_per_framework",
+        "Maximum number of completed tasks per framework\n"
+        "to keep in memory, older ones get dropped (or\n"
+        "appended to the history, see --history_dir)",
+        MAX_COMPLETED_TASKS_PER_FRAMEWORK);
+
     add(&Flags::cluster,
         "cluster",
         "Human readable name for the cluster,\n"
@@ -91,7 +180,19 @@ public:
   std::string whitelist;
   std::string user_sorter;
   std::string framework_sorter;
+  Option<std::string> user_weights;
+  Option<std::string> user_quotas;
+  std::string placement;
   Duration allocation_interval;
+  Option<Duration> offer_timeout;
+  size_t slave_reregistration_batch;
+  Duration slave_ping_timeout;
+  Duration slave_ping_batch_interval;
+  double slave_ping_jitter;
+  uint32_t max_slave_ping_timeouts;
+  Option<std::string> history_dir;
+  uint32_t max_history_records;
+  uint32_t max_completed_tasks_per_framework;
   Option<std::string> cluster;
 };
 
@@ -19,21 +19,32 @@
 #ifndef __HIERARCHICAL_ALLOCATOR_PROCESS_HPP__
 #define __HIERARCHICAL_ALLOCATOR_PROCESS_HPP__
 
+#include <map>
+#include <string>
+#include <vector>
+
 #include <process/delay.hpp>
+#include <process/http.hpp>
 #include <process/id.hpp>
 #include <process/timeout.hpp>
 
 #include <stout/check.hpp>
 #include <stout/duration.hpp>
+#include <stout/exit.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/json.hpp>
+#include <stout/numify.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+#include <stout/try.hpp>
 
 #include "common/resources.hpp"
 
 #include "master/allocator.hpp"
 #include "master/drf_sorter.hpp"
 #include "master/master.hpp"
+#include "master/placement.hpp"
 #include "master/sorter.hpp"
 
 namespace mesos {
@@ -46,13 +57,21 @@ class Filter;
 
 
 // We forward declare the hierarchical allocator process so that we
-// can typedef an instantiation of it with DRF sorters.
-template <typename UserSorter, typename FrameworkSorter>
+// can typedef instantiations of it with DRF sorters.
+template <typename UserSorter,
+          typename FrameworkSorter,
+          typename SlavePlacement>
 class HierarchicalAllocatorProcess;
 
-typedef HierarchicalAllocatorProcess<DRFSorter, DRFSorter>
+typedef HierarchicalAllocatorProcess<DRFSorter, DRFSorter, DefaultPlacement>
 HierarchicalDRFAllocatorProcess;
 
+typedef HierarchicalAllocatorProcess<DRFSorter, DRFSorter, SpreadPlacement>
+HierarchicalDRFSpreadAllocatorProcess;
+
+typedef HierarchicalAllocatorProcess<DRFSorter, DRFSorter, PackPlacement>
+HierarchicalDRFPackAllocatorProcess;
+
 
 struct Slave
 {
@@ -99,6 +118,22 @@ private:
 };
 
 
+// A filter that is due to expire, see
+// HierarchicalAllocatorProcess::expire.
+struct Expiration
+{
+  Expiration(
+      const FrameworkID& _frameworkId,
+      const SlaveID& _slaveId,
+      Filter* _filter)
+    : frameworkId(_frameworkId), slaveId(_slaveId), filter(_filter) {}
+
+  FrameworkID frameworkId;
+  SlaveID slaveId;
+  Filter* filter;
+};
+
+
 struct Framework
 {
   Framework() {}
@@ -108,8 +143,9 @@ struct Framework
 
   std::string user() const { return info.user(); }
 
-  // Filters that have been added by this framework.
-  hashset<Filter*> filters;
+  // Filters that have been added by this framework, indexed by the
+  // slave that they filter.
+  hashmap<SlaveID, hashset<Filter*> > filters;
 
 private:
   FrameworkInfo info;
@@ -117,8 +153,11 @@ private:
 
 
 // Implements the basic allocator algorithm - first pick a user by
-// some criteria, then pick one of their frameworks to allocate to.
-template <typename UserSorter, typename FrameworkSorter>
+// some criteria, then pick one of their frameworks to allocate to,
+// then pick (via the SlavePlacement) which slaves to offer it.
+template <typename UserSorter,
+          typename FrameworkSorter,
+          typename SlavePlacement>
 class HierarchicalAllocatorProcess : public AllocatorProcess
 {
 public:
@@ -176,13 +215,26 @@ public:
   void offersRevived(
       const FrameworkID& frameworkId);
 
+  void slavesAdded(
+      const std::vector<AddedSlave>& slaves);
+
+  void resourcesRecoveredBatch(
+      const std::vector<RecoveredResources>& recovered);
+
 protected:
   // Useful typedefs for dispatch/delay/defer to self()/this.
-  typedef HierarchicalAllocatorProcess<UserSorter, FrameworkSorter> Self;
-  typedef HierarchicalAllocatorProcess<UserSorter, FrameworkSorter> This;
+  typedef HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement> Self;
+  typedef HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement> This;
+
+  // Callback for doing batch allocations (virtual so that it can be
+  // instrumented, see src/simulator).
+  virtual void batch();
 
-  // Callback for doing batch allocations.
-  void batch();
+  // Adds a slave without allocating any of its resources.
+  void addSlave(
+      const SlaveID& slaveId,
+      const SlaveInfo& slaveInfo,
+      const hashmap<FrameworkID, Resources>& used);
 
   // Allocate any allocatable resources.
   void allocate();
@@ -193,8 +245,12 @@ protected:
   // Allocate resources from the specified slaves.
   void allocate(const hashset<SlaveID>& slaveIds);
 
-  // Remove a filter for the specified framework.
-  void expire(const FrameworkID& frameworkId, Filter* filter);
+  // Remove (and delete) all filters that have expired.
+  void expire();
+
+  // Returns the filters of every framework.
+  process::Future<process::http::Response> filters(
+      const process::http::Request& request);
 
   // Checks whether the slave is whitelisted.
   bool isWhitelisted(const SlaveID& slave);
@@ -226,6 +282,20 @@ protected:
 
   // Sorter containing all active users.
   UserSorter* userSorter;
+
+  // Weights and quotas of users, from --user_weights and
+  // --user_quotas. They get applied whenever the user is
+  // added to 'userSorter'.
+  hashmap<std::string, double> userWeights;
+  hashmap<std::string, Resources> userQuotas;
+
+  // Determines which slaves get offered to a framework.
+  SlavePlacement* placement;
+
+  // All filters that have not been deleted yet, ordered by when
+  // they expire (even if they have been removed from their
+  // framework already, see HierarchicalAllocatorProcess::expire).
+  std::multimap<Time, Expiration> expirations;
 };
 
 
@@ -236,6 +306,9 @@ public:
   virtual ~Filter() {}
 
   virtual bool filter(const SlaveID& slaveId, const Resources& resources) = 0;
+
+  // Returns a JSON representation of this filter.
+  virtual JSON::Object model() const = 0;
 };
 
 
@@ -255,35 +328,44 @@ public:
            timeout.remaining() > Seconds(0);
   }
 
+  virtual JSON::Object model() const
+  {
+    JSON::Object object;
+    object.values["slave_id"] = slaveId.value();
+    object.values["resources"] = stringify(resources);
+    object.values["remaining_secs"] = timeout.remaining().secs();
+    return object;
+  }
+
   const SlaveID slaveId;
   const Resources resources;
   const Timeout timeout;
 };
 
 
-template <class UserSorter, class FrameworkSorter>
-HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::HierarchicalAllocatorProcess()
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::HierarchicalAllocatorProcess()
   : ProcessBase(ID::generate("hierarchical-allocator")),
     initialized(false) {}
 
 
-template <class UserSorter, class FrameworkSorter>
-HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::~HierarchicalAllocatorProcess()
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::~HierarchicalAllocatorProcess()
 {}
 
 
-template <class UserSorter, class FrameworkSorter>
-process::PID<HierarchicalAllocatorProcess<UserSorter, FrameworkSorter> >
-HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::self()
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
+process::PID<HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement> >
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::self()
 {
   return
-    process::PID<HierarchicalAllocatorProcess<UserSorter, FrameworkSorter> >(this);
+    process::PID<HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement> >(this);
 }
 
 
-template <class UserSorter, class FrameworkSorter>
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
 void
-HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::initialize(
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::initialize(
     const Flags& _flags,
     const process::PID<Master>& _master)
 {
@@ -291,17 +373,48 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::initialize(
   master = _master;
   initialized = true;
   userSorter = new UserSorter();
+  placement = new SlavePlacement();
+
+  if (flags.user_weights.isSome()) {
+    foreach (const std::string& token,
+             strings::tokenize(flags.user_weights.get(), ",")) {
+      std::vector<std::string> pair = strings::split(token, "=");
+      if (pair.size() != 2) {
+        EXIT(1) << "Invalid user weight '" << token << "'";
+      }
+      Try<double> weight = numify<double>(pair[1]);
+      if (weight.isError() || weight.get() <= 0) {
+        EXIT(1) << "Invalid user weight '" << token << "'";
+      }
+      userWeights[pair[0]] = weight.get();
+    }
+  }
+
+  if (flags.user_quotas.isSome()) {
+    // Quotas are separated by whitespace since resources (e.g.,
+    // ranges) can contain ','.
+    foreach (const std::string& token,
+             strings::tokenize(flags.user_quotas.get(), " \t\n")) {
+      std::vector<std::string> pair = strings::split(token, "=");
+      if (pair.size() != 2) {
+        EXIT(1) << "Invalid user quota '" << token << "'";
+      }
+      userQuotas[pair[0]] = Resources::parse(pair[1]);
+    }
+  }
 
   VLOG(1) << "Initializing hierarchical allocator process "
           << "with master : " << master;
 
+  route("/filters.json", &Self::filters);
+
   delay(flags.allocation_interval, self(), &Self::batch);
 }
 
 
-template <class UserSorter, class FrameworkSorter>
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
 void
-HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::frameworkAdded(
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::frameworkAdded(
     const FrameworkID& frameworkId,
     const FrameworkInfo& frameworkInfo,
     const Resources& used)
@@ -311,11 +424,20 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::frameworkAdded(
   const std::string& user = frameworkInfo.user();
   if (!userSorter->contains(user)) {
     userSorter->add(user);
+    if (userWeights.contains(user)) {
+      userSorter->weight(user, userWeights[user]);
+    }
+    if (userQuotas.contains(user)) {
+      userSorter->quota(user, userQuotas[user]);
+    }
     sorters[user] = new FrameworkSorter();
   }
 
   CHECK(!sorters[user]->contains(frameworkId.value()));
   sorters[user]->add(frameworkId.value());
+  if (frameworkInfo.weight() > 0) {
+    sorters[user]->weight(frameworkId.value(), frameworkInfo.weight());
+  }
 
   // Update the allocation to this framework.
   userSorter->allocated(user, used);
@@ -330,9 +452,9 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::frameworkAdded(
 }
 
 
-template <class UserSorter, class FrameworkSorter>
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
 void
-HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::frameworkRemoved(
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::frameworkRemoved(
     const FrameworkID& frameworkId)
 {
   CHECK(initialized);
@@ -350,8 +472,7 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::frameworkRemoved(
   }
 
   // Do not delete the filters contained in this
-  // framework's 'filters' hashset yet, see comments in
-  // HierarchicalAllocatorProcess::offersRevived and
+  // framework's 'filters' yet, see comments in
   // HierarchicalAllocatorProcess::expire.
   frameworks.erase(frameworkId);
 
@@ -368,15 +489,20 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::frameworkRemoved(
 }
 
 
-template <class UserSorter, class FrameworkSorter>
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
 void
-HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::frameworkActivated(
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::frameworkActivated(
     const FrameworkID& frameworkId,
     const FrameworkInfo& frameworkInfo)
 {
   CHECK(initialized);
 
   const std::string& user = frameworkInfo.user();
+
+  // The framework might have failed over with a different weight.
+  sorters[user]->weight(
+      frameworkId.value(),
+      frameworkInfo.weight() > 0 ? frameworkInfo.weight() : 1);
   sorters[user]->activate(frameworkId.value());
 
   LOG(INFO) << "Activated framework " << frameworkId;
@@ -385,9 +511,9 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::frameworkActivated(
 }
 
 
-template <class UserSorter, class FrameworkSorter>
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
 void
-HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::frameworkDeactivated(
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::frameworkDeactivated(
     const FrameworkID& frameworkId)
 {
   CHECK(initialized);
@@ -404,8 +530,7 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::frameworkDeactivated(
   // the added/removed and activated/deactivated in the future.
 
   // Do not delete the filters contained in this
-  // framework's 'filters' hashset yet, see comments in
-  // HierarchicalAllocatorProcess::offersRevived and
+  // framework's 'filters' yet, see comments in
   // HierarchicalAllocatorProcess::expire.
   frameworks[frameworkId].filters.clear();
 
@@ -413,15 +538,54 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::frameworkDeactivated(
 }
 
 
-template <class UserSorter, class FrameworkSorter>
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
 void
-HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::slaveAdded(
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::slaveAdded(
     const SlaveID& slaveId,
     const SlaveInfo& slaveInfo,
     const hashmap<FrameworkID, Resources>& used)
 {
   CHECK(initialized);
 
+  addSlave(slaveId, slaveInfo, used);
+
+  if (slaves[slaveId].allocatable()) {
+    allocate(slaveId);
+  }
+}
+
+
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
+void
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::slavesAdded(
+    const std::vector<AddedSlave>& added)
+{
+  CHECK(initialized);
+
+  hashset<SlaveID> slaveIds;
+
+  foreach (const AddedSlave& slave, added) {
+    addSlave(slave.slaveId, slave.slaveInfo, slave.used);
+
+    if (slaves[slave.slaveId].allocatable()) {
+      slaveIds.insert(slave.slaveId);
+    }
+  }
+
+  // Do a single allocation for all of the slaves.
+  if (!slaveIds.empty()) {
+    allocate(slaveIds);
+  }
+}
+
+
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
+void
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::addSlave(
+    const SlaveID& slaveId,
+    const SlaveInfo& slaveInfo,
+    const hashmap<FrameworkID, Resources>& used)
+{
   CHECK(!slaves.contains(slaveId));
 
   slaves[slaveId] = Slave(slaveInfo);
@@ -446,19 +610,18 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::slaveAdded(
 
   slaves[slaveId].available = unused;
 
+  placement->add(slaveId, slaveInfo.resources());
+  placement->update(slaveId, unused);
+
   LOG(INFO) << "Added slave " << slaveId << " (" << slaveInfo.hostname()
             << ") with " << slaveInfo.resources() << " (and " << unused
             << " available)";
-
-  if (slaves[slaveId].allocatable()) {
-    allocate(slaveId);
-  }
 }
 
 
-template <class UserSorter, class FrameworkSorter>
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
 void
-HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::slaveRemoved(
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::slaveRemoved(
     const SlaveID& slaveId)
 {
   CHECK(initialized);
@@ -468,19 +631,19 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::slaveRemoved(
   userSorter->remove(slaves[slaveId].resources());
 
   slaves.erase(slaveId);
+  placement->remove(slaveId);
 
   // Note that we DO NOT actually delete any filters associated with
-  // this slave, that will occur when the delayed
-  // HierarchicalAllocatorProcess::expire gets invoked (or the framework
-  // that applied the filters gets removed).
+  // this slave, that will occur when they expire (see
+  // HierarchicalAllocatorProcess::expire).
 
   LOG(INFO) << "Removed slave " << slaveId;
 }
 
 
-template <class UserSorter, class FrameworkSorter>
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
 void
-HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::updateWhitelist(
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::updateWhitelist(
     const Option<hashset<std::string> >& _whitelist)
 {
   CHECK(initialized);
@@ -497,9 +660,9 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::updateWhitelist(
 }
 
 
-template <class UserSorter, class FrameworkSorter>
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
 void
-HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::resourcesRequested(
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::resourcesRequested(
     const FrameworkID& frameworkId,
     const std::vector<Request>& requests)
 {
@@ -509,9 +672,9 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::resourcesRequested(
 }
 
 
-template <class UserSorter, class FrameworkSorter>
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
 void
-HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::resourcesUnused(
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::resourcesUnused(
     const FrameworkID& frameworkId,
     const SlaveID& slaveId,
     const Resources& resources,
@@ -542,6 +705,7 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::resourcesUnused(
   // Update resources allocatable on slave.
   CHECK(slaves.contains(slaveId));
   slaves[slaveId].available += resources;
+  placement->update(slaveId, slaves[slaveId].available);
 
   // Create a refused resources filter.
   Try<Duration> seconds_ = Duration::create(Filters().refuse_seconds());
@@ -566,24 +730,29 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::resourcesUnused(
   }
 
   if (seconds != Duration::zero()) {
-    LOG(INFO) << "Framework " << frameworkId
-              << " filtered slave " << slaveId
-              << " for " << seconds;
-
-    // Create a new filter and delay it's expiration.
-    Filter* filter =
-      new RefusedFilter(slaveId, resources, Timeout::in(seconds));
-
-    frameworks[frameworkId].filters.insert(filter);
-
-    delay(seconds, self(), &Self::expire, frameworkId, filter);
+    // Frameworks decline offers all the time, so only log every so
+    // often.
+    LOG_EVERY_N(INFO, 100)
+      << "Framework " << frameworkId
+      << " filtered slave " << slaveId
+      << " for " << seconds
+      << " (" << google::COUNTER << " filters so far)";
+
+    // Create a new filter and schedule it's expiration.
+    Timeout timeout = Timeout::in(seconds);
+    Filter* filter = new RefusedFilter(slaveId, resources, timeout);
+
+    frameworks[frameworkId].filters[slaveId].insert(filter);
+
+    expirations.insert(std::make_pair(
+        timeout.time(), Expiration(frameworkId, slaveId, filter)));
   }
 }
 
 
-template <class UserSorter, class FrameworkSorter>
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
 void
-HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::resourcesRecovered(
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::resourcesRecovered(
     const FrameworkID& frameworkId,
     const SlaveID& slaveId,
     const Resources& resources)
@@ -612,30 +781,80 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::resourcesRecovered(
   // before we received Allocator::slaveRemoved).
   if (slaves.contains(slaveId)) {
     slaves[slaveId].available += resources;
+    placement->update(slaveId, slaves[slaveId].available);
+
+    // Resources are recovered for every declined (or partially
+    // used) offer, so only log every so often.
+    LOG_EVERY_N(INFO, 100)
+      << "Recovered " << resources.allocatable()
+      << " (total allocatable: " << slaves[slaveId].available
+      << ") on slave " << slaveId
+      << " from framework " << frameworkId
+      << " (" << google::COUNTER << " recoveries so far)";
+  }
+}
+
+
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
+void
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::resourcesRecoveredBatch(
+    const std::vector<RecoveredResources>& recovered)
+{
+  CHECK(initialized);
 
-    LOG(INFO) << "Recovered " << resources.allocatable()
-              << " (total allocatable: " << slaves[slaveId].available
-              << ") on slave " << slaveId
-              << " from framework " << frameworkId;
+  // Add up the resources recovered from each framework and on each
+  // slave so that we only update each sorter and slave once (see
+  // HierarchicalAllocatorProcess::resourcesRecovered for why either
+  // might be gone already).
+  hashmap<FrameworkID, Resources> recoveredFrom;
+  hashmap<SlaveID, Resources> recoveredOn;
+
+  foreach (const RecoveredResources& resources, recovered) {
+    if (resources.resources.allocatable().size() > 0) {
+      recoveredFrom[resources.frameworkId] += resources.resources;
+      recoveredOn[resources.slaveId] += resources.resources;
+    }
   }
+
+  foreachpair (const FrameworkID& frameworkId,
+               const Resources& resources,
+               recoveredFrom) {
+    if (frameworks.contains(frameworkId) &&
+        sorters[frameworks[frameworkId].user()]->contains(
+            frameworkId.value())) {
+      const std::string& user = frameworks[frameworkId].user();
+      sorters[user]->unallocated(frameworkId.value(), resources);
+      sorters[user]->remove(resources);
+      userSorter->unallocated(user, resources);
+    }
+  }
+
+  foreachpair (const SlaveID& slaveId,
+               const Resources& resources,
+               recoveredOn) {
+    if (slaves.contains(slaveId)) {
+      slaves[slaveId].available += resources;
+      placement->update(slaveId, slaves[slaveId].available);
+    }
+  }
+
+  VLOG(1) << "Recovered resources " << recovered.size() << " times from "
+          << recoveredFrom.size() << " frameworks on "
+          << recoveredOn.size() << " slaves";
 }
 
 
-template <class UserSorter, class FrameworkSorter>
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
 void
-HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::offersRevived(
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::offersRevived(
     const FrameworkID& frameworkId)
 {
   CHECK(initialized);
 
   frameworks[frameworkId].filters.clear();
 
-  // We delete each actual Filter when
-  // HierarchicalAllocatorProcess::expire gets invoked. If we delete the
-  // Filter here it's possible that the same Filter (i.e., same
-  // address) could get reused and HierarchicalAllocatorProcess::expire
-  // would expire that filter too soon. Note that this only works
-  // right now because ALL Filter types "expire".
+  // We delete each actual Filter when it expires, see
+  // HierarchicalAllocatorProcess::expire.
 
   LOG(INFO) << "Removed filters for framework " << frameworkId;
 
@@ -643,19 +862,20 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::offersRevived(
 }
 
 
-template <class UserSorter, class FrameworkSorter>
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
 void
-HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::batch()
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::batch()
 {
   CHECK(initialized);
+  expire();
   allocate();
   delay(flags.allocation_interval, self(), &Self::batch);
 }
 
 
-template <class UserSorter, class FrameworkSorter>
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
 void
-HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::allocate()
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::allocate()
 {
   CHECK(initialized);
 
@@ -669,9 +889,9 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::allocate()
 }
 
 
-template <class UserSorter, class FrameworkSorter>
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
 void
-HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::allocate(
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::allocate(
     const SlaveID& slaveId)
 {
   CHECK(initialized);
@@ -689,9 +909,9 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::allocate(
 }
 
 
-template <class UserSorter, class FrameworkSorter>
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
 void
-HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::allocate(
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::allocate(
     const hashset<SlaveID>& slaveIds)
 {
   CHECK(initialized);
@@ -706,6 +926,9 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::allocate(
     return;
   }
 
+  // Slaves in the order that their resources should be offered.
+  std::vector<SlaveID> ordered = placement->sort(slaveIds);
+
   foreach (const std::string& user, userSorter->sort()) {
     foreach (const std::string& frameworkIdValue, sorters[user]->sort()) {
       FrameworkID frameworkId;
@@ -713,11 +936,15 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::allocate(
 
       Resources allocatedResources;
       hashmap<SlaveID, Resources> offerable;
-      foreach (const SlaveID& slaveId, slaveIds) {
+      foreach (const SlaveID& slaveId, ordered) {
         if (!slaves[slaveId].allocatable()) {
           continue;
         }
 
+        if (placement->enough(offerable, slaveId)) {
+          break;
+        }
+
         Resources resources = slaves[slaveId].available;
 
         // Check whether or not this framework filters this slave.
@@ -732,6 +959,7 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::allocate(
 
           // Update framework and slave resources.
           slaves[slaveId].available -= resources;
+          placement->update(slaveId, slaves[slaveId].available);
           allocatedResources += resources;
         }
       }
@@ -748,29 +976,73 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::allocate(
 }
 
 
-template <class UserSorter, class FrameworkSorter>
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
 void
-HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::expire(
-    const FrameworkID& frameworkId,
-    Filter* filter)
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::expire()
 {
-  // The filter might have already been removed (e.g., if the
-  // framework no longer exists or in
-  // HierarchicalAllocatorProcess::offersRevived) but not yet deleted (to
-  // keep the address from getting reused possibly causing premature
-  // expiration).
-  if (frameworks.contains(frameworkId) &&
-      frameworks[frameworkId].filters.contains(filter)) {
-    frameworks[frameworkId].filters.erase(filter);
+  // Expired filters no longer filter anything (see
+  // RefusedFilter::filter), so it's sufficient to delete them during
+  // each batch allocation rather than keeping a timer per filter.
+  const Time now = Clock::now();
+
+  while (!expirations.empty() && expirations.begin()->first <= now) {
+    const Expiration& expiration = expirations.begin()->second;
+
+    // The filter might have already been removed (e.g., if the
+    // framework no longer exists or in
+    // HierarchicalAllocatorProcess::offersRevived), filters are only
+    // ever deleted here so that 'expirations' never refers to a
+    // deleted (or reused) filter.
+    if (frameworks.contains(expiration.frameworkId)) {
+      hashmap<SlaveID, hashset<Filter*> >& filters =
+        frameworks[expiration.frameworkId].filters;
+
+      if (filters.contains(expiration.slaveId)) {
+        filters[expiration.slaveId].erase(expiration.filter);
+        if (filters[expiration.slaveId].empty()) {
+          filters.erase(expiration.slaveId);
+        }
+      }
+    }
+
+    delete expiration.filter;
+    expirations.erase(expirations.begin());
   }
+}
 
-  delete filter;
+
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
+process::Future<process::http::Response>
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::filters(
+    const process::http::Request& request)
+{
+  JSON::Array array;
+
+  foreachpair (const FrameworkID& frameworkId,
+               const Framework& framework,
+               frameworks) {
+    foreachvalue (const hashset<Filter*>& filters, framework.filters) {
+      foreach (Filter* filter, filters) {
+        JSON::Object object = filter->model();
+        object.values["framework_id"] = frameworkId.value();
+        array.values.push_back(object);
+      }
+    }
+  }
+
+  JSON::Object object;
+  object.values["filters"] = array;
+
+  // Includes removed filters that have not been deleted yet.
+  object.values["pending_expirations"] = expirations.size();
+
+  return process::http::OK(object, request.query.get("jsonp"));
 }
 
 
-template <class UserSorter, class FrameworkSorter>
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
 bool
-HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::isWhitelisted(
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::isWhitelisted(
     const SlaveID& slaveId)
 {
   CHECK(initialized);
@@ -782,9 +1054,9 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::isWhitelisted(
 }
 
 
-template <class UserSorter, class FrameworkSorter>
+template <class UserSorter, class FrameworkSorter, class SlavePlacement>
 bool
-HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::isFiltered(
+HierarchicalAllocatorProcess<UserSorter, FrameworkSorter, SlavePlacement>::isFiltered(
     const FrameworkID& frameworkId,
     const SlaveID& slaveId,
     const Resources& resources)
@@ -792,7 +1064,13 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::isFiltered(
   bool filtered = false;
 
   CHECK(frameworks.contains(frameworkId));
-  foreach (Filter* filter, frameworks[frameworkId].filters) {
+
+  // Only the filters for this slave need to be checked.
+  if (!frameworks[frameworkId].filters.contains(slaveId)) {
+    return false;
+  }
+
+  foreach (Filter* filter, frameworks[frameworkId].filters[slaveId]) {
     if (filter->filter(slaveId, resources)) {
       VLOG(1) << "Filtered " << resources
               << " on slave " << slaveId
@@ -804,6 +1082,23 @@ HierarchicalAllocatorProcess<UserSorter, FrameworkSorter>::isFiltered(
   return filtered;
 }
 
+
+// Returns a new hierarchical DRF allocator process using the named
+// placement (see the 'placement' flag of the master).
+inline Try<AllocatorProcess*> createHierarchicalDRFAllocatorProcess(
+    const std::string& placement)
+{
+  if (placement == "default") {
+    return new HierarchicalDRFAllocatorProcess();
+  } else if (placement == "spread") {
+    return new HierarchicalDRFSpreadAllocatorProcess();
+  } else if (placement == "pack") {
+    return new HierarchicalDRFPackAllocatorProcess();
+  }
+
+  return Error("Unknown placement '" + placement + "'");
+}
+
 } // namespace allocator {
 } // namespace master {
 } // namespace internal {
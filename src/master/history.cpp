@@ -0,0 +1,420 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <leveldb/db.h>
+#include <leveldb/write_batch.h>
+
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <process/future.hpp>
+#include <process/process.hpp>
+
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/nothing.hpp>
+#include <stout/numify.hpp>
+#include <stout/option.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+#include <stout/try.hpp>
+
+#include "common/type_utils.hpp"
+
+#include "logging/logging.hpp"
+
+#include "master/history.hpp"
+
+#include "messages/messages.hpp"
+
+using namespace process;
+
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// The records are kept under "framework/<index>" and
+// "task/<framework ID>/<index>", where the index counts the records
+// appended under the prefix. The range of indexes kept for a prefix
+// is kept under "range/<prefix>". Every record also gets a sequence
+// number, the key of the record is kept under "order/<sequence>" (so
+// that the oldest records can be found and deleted) and the last
+// sequence number used under "sequence".
+static const string FRAMEWORKS = "framework/";
+static const string TASKS = "task/";
+static const string RANGES = "range/";
+static const string ORDER = "order/";
+static const string SEQUENCE = "sequence";
+
+// Length of the zero padded numbers in the keys.
+static const size_t PADDING = 20;
+
+
+// Returns the number zero padded so that keys sort in numeric order.
+static string pad(uint64_t number)
+{
+  std::ostringstream out;
+  out << std::setw(PADDING) << std::setfill('0') << number;
+  return out.str();
+}
+
+
+HistoryProcess::HistoryProcess(const string& _path, size_t _capacity)
+  : path(_path),
+    capacity(_capacity),
+    db(NULL),
+    sequence(0),
+    oldest(1) {}
+
+
+HistoryProcess::~HistoryProcess()
+{
+  delete db; // NULL if open failed in HistoryProcess::initialize.
+}
+
+
+void HistoryProcess::initialize()
+{
+  leveldb::Options options;
+  options.create_if_missing = true;
+
+  leveldb::Status status = leveldb::DB::Open(options, path, &db);
+
+  if (!status.ok()) {
+    error = Option<string>::some(status.ToString());
+    LOG(ERROR) << "Failed to open the history at " << path << ": "
+               << error.get() << ", completed tasks and frameworks "
+               << "that don't fit in memory will be dropped";
+    return;
+  }
+
+  string value;
+  status = db->Get(leveldb::ReadOptions(), SEQUENCE, &value);
+
+  if (status.ok()) {
+    Try<uint64_t> last = numify<uint64_t>(value);
+    if (last.isError()) {
+      error = Option<string>::some(
+          "Failed to parse the sequence number: " + last.error());
+      LOG(ERROR) << "Failed to recover the history at " << path << ": "
+                 << error.get();
+      return;
+    }
+    sequence = last.get();
+  } else if (!status.IsNotFound()) {
+    error = Option<string>::some(status.ToString());
+    LOG(ERROR) << "Failed to recover the history at " << path << ": "
+               << error.get();
+    return;
+  }
+
+  // Recover the ranges and the oldest record (i.e., the first key
+  // under "order/"), if any.
+  leveldb::Iterator* iterator = db->NewIterator(leveldb::ReadOptions());
+
+  for (iterator->Seek(RANGES);
+       iterator->Valid() && iterator->key().starts_with(RANGES);
+       iterator->Next()) {
+    const string& prefix = iterator->key().ToString().substr(RANGES.size());
+    std::istringstream in(iterator->value().ToString());
+    Range range;
+    if (!(in >> range.first >> range.next)) {
+      error = Option<string>::some("Failed to parse the range of " + prefix);
+      break;
+    }
+    ranges[prefix] = range;
+  }
+
+  if (error.isNone()) {
+    iterator->Seek(ORDER);
+    oldest = sequence + 1;
+    if (iterator->Valid() && iterator->key().starts_with(ORDER)) {
+      Try<uint64_t> first = numify<uint64_t>(
+          iterator->key().ToString().substr(ORDER.size()));
+      if (first.isError()) {
+        error = Option<string>::some(
+            "Failed to parse the oldest sequence number: " + first.error());
+      } else {
+        oldest = first.get();
+      }
+    }
+  }
+
+  if (error.isNone() && !iterator->status().ok()) {
+    error = Option<string>::some(iterator->status().ToString());
+  }
+
+  delete iterator;
+
+  if (error.isSome()) {
+    LOG(ERROR) << "Failed to recover the history at " << path << ": "
+               << error.get();
+    return;
+  }
+
+  LOG(INFO) << "Recovered the history at " << path
+            << " (" << sequence + 1 - oldest << " records)";
+}
+
+
+void HistoryProcess::add(const Task& task)
+{
+  if (error.isSome()) {
+    return;
+  }
+
+  string value;
+  if (!task.SerializeToString(&value)) {
+    LOG(WARNING) << "Failed to serialize completed task " << task.task_id();
+    return;
+  }
+
+  Try<Nothing> result =
+    append(TASKS + task.framework_id().value() + "/", value);
+
+  if (result.isError()) {
+    LOG(WARNING) << "Failed to append completed task " << task.task_id()
+                 << " to the history: " << result.error();
+  }
+}
+
+
+void HistoryProcess::add(const CompletedFramework& framework)
+{
+  if (error.isSome()) {
+    return;
+  }
+
+  string value;
+  if (!framework.SerializeToString(&value)) {
+    LOG(WARNING) << "Failed to serialize completed framework "
+                 << framework.info().id();
+    return;
+  }
+
+  Try<Nothing> result = append(FRAMEWORKS, value);
+
+  if (result.isError()) {
+    LOG(WARNING) << "Failed to append completed framework "
+                 << framework.info().id() << " to the history: "
+                 << result.error();
+  }
+}
+
+
+Future<vector<Task> > HistoryProcess::tasks(
+    const Option<FrameworkID>& frameworkId,
+    size_t offset,
+    size_t limit)
+{
+  if (error.isSome()) {
+    return Future<vector<Task> >::failed(error.get());
+  }
+
+  const string& prefix = frameworkId.isSome()
+    ? TASKS + frameworkId.get().value() + "/"
+    : TASKS;
+
+  Try<vector<string> > values = read(prefix, offset, limit);
+
+  if (values.isError()) {
+    return Future<vector<Task> >::failed(values.error());
+  }
+
+  vector<Task> tasks;
+  foreach (const string& value, values.get()) {
+    Task task;
+    if (!task.ParseFromString(value)) {
+      return Future<vector<Task> >::failed("Failed to deserialize Task");
+    }
+    tasks.push_back(task);
+  }
+
+  return tasks;
+}
+
+
+Future<vector<CompletedFramework> > HistoryProcess::frameworks(
+    size_t offset,
+    size_t limit)
+{
+  if (error.isSome()) {
+    return Future<vector<CompletedFramework> >::failed(error.get());
+  }
+
+  Try<vector<string> > values = read(FRAMEWORKS, offset, limit);
+
+  if (values.isError()) {
+    return Future<vector<CompletedFramework> >::failed(values.error());
+  }
+
+  vector<CompletedFramework> frameworks;
+  foreach (const string& value, values.get()) {
+    CompletedFramework framework;
+    if (!framework.ParseFromString(value)) {
+      return Future<vector<CompletedFramework> >::failed(
+          "Failed to deserialize CompletedFramework");
+    }
+    frameworks.push_back(framework);
+  }
+
+  return frameworks;
+}
+
+
+Try<Nothing> HistoryProcess::append(const string& prefix, const string& value)
+{
+  CHECK(error.isNone());
+
+  // The ranges that change, applied once the batch got written.
+  std::map<string, Range> changed;
+  if (ranges.count(prefix) > 0) {
+    changed[prefix] = ranges[prefix];
+  }
+
+  const string& key = prefix + pad(changed[prefix].next++);
+
+  leveldb::WriteBatch batch;
+  batch.Put(key, value);
+  batch.Put(ORDER + pad(sequence + 1), key);
+  batch.Put(SEQUENCE, stringify(sequence + 1));
+
+  // Delete the oldest records while there are too many, they are
+  // always the first ones of their prefix.
+  uint64_t first = oldest;
+  while (sequence + 2 - first > capacity && first <= sequence) {
+    string oldestKey;
+    leveldb::Status status =
+      db->Get(leveldb::ReadOptions(), ORDER + pad(first), &oldestKey);
+
+    if (!status.ok()) {
+      return Error("Failed to find the oldest record: " + status.ToString());
+    }
+
+    CHECK_GT(oldestKey.size(), PADDING);
+    const string& oldestPrefix =
+      oldestKey.substr(0, oldestKey.size() - PADDING);
+
+    if (changed.count(oldestPrefix) == 0) {
+      CHECK(ranges.count(oldestPrefix) > 0);
+      changed[oldestPrefix] = ranges[oldestPrefix];
+    }
+    changed[oldestPrefix].first++;
+
+    batch.Delete(oldestKey);
+    batch.Delete(ORDER + pad(first));
+    first++;
+  }
+
+  typedef std::map<string, Range>::value_type Entry;
+  foreach (const Entry& entry, changed) {
+    if (entry.second.first == entry.second.next) {
+      batch.Delete(RANGES + entry.first);
+    } else {
+      batch.Put(RANGES + entry.first,
+                stringify(entry.second.first) + " " +
+                stringify(entry.second.next));
+    }
+  }
+
+  // Not syncing, losing the most recent history when the machine
+  // crashes is not worth a disk flush per completed task.
+  leveldb::Status status = db->Write(leveldb::WriteOptions(), &batch);
+
+  if (!status.ok()) {
+    return Error(status.ToString());
+  }
+
+  sequence++;
+  oldest = first;
+
+  foreach (const Entry& entry, changed) {
+    if (entry.second.first == entry.second.next) {
+      ranges.erase(entry.first);
+    } else {
+      ranges[entry.first] = entry.second;
+    }
+  }
+
+  return Nothing();
+}
+
+
+Try<vector<string> > HistoryProcess::read(
+    const string& prefix,
+    size_t offset,
+    size_t limit)
+{
+  CHECK(error.isNone());
+
+  vector<string> values;
+
+  leveldb::ReadOptions options;
+
+  // Pages are usually read once, don't let them push the recently
+  // appended records out of the cache.
+  options.fill_cache = false;
+
+  leveldb::Iterator* iterator = db->NewIterator(options);
+
+  // Skip the ranges that are entirely before the offset and then
+  // seek straight to the first record of the page.
+  std::map<string, Range>::const_iterator range = ranges.lower_bound(prefix);
+
+  while (range != ranges.end() &&
+         strings::startsWith(range->first, prefix) &&
+         values.size() < limit) {
+    const uint64_t size = range->second.next - range->second.first;
+
+    if (offset >= size) {
+      offset -= size;
+    } else {
+      iterator->Seek(range->first + pad(range->second.first + offset));
+      offset = 0;
+
+      while (iterator->Valid() &&
+             iterator->key().starts_with(range->first) &&
+             values.size() < limit) {
+        values.push_back(iterator->value().ToString());
+        iterator->Next();
+      }
+    }
+
+    ++range;
+  }
+
+  leveldb::Status status = iterator->status();
+
+  delete iterator;
+
+  if (!status.ok()) {
+    return Error(status.ToString());
+  }
+
+  return values;
+}
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
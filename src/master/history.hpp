@@ -0,0 +1,204 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MASTER_HISTORY_HPP__
+#define __MASTER_HISTORY_HPP__
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <mesos/mesos.hpp>
+
+#include <process/dispatch.hpp>
+#include <process/future.hpp>
+#include <process/process.hpp>
+
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+#include <stout/try.hpp>
+
+#include "messages/messages.hpp"
+
+// Forward declarations.
+namespace leveldb { class DB; }
+
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// More forward declarations.
+class HistoryProcess;
+
+
+// The master's on-disk history of completed tasks and frameworks.
+// The master only keeps the most recent ones in memory, the ones
+// that get pushed out are appended here (in a leveldb) instead of
+// being dropped. The history can be read back a page at a time, in
+// the order it was appended in, without loading all of it. Once it
+// holds more than 'capacity' records (tasks and frameworks) the
+// oldest ones get deleted.
+class History
+{
+public:
+  History(const std::string& path, size_t capacity);
+  virtual ~History();
+
+  // Appends a completed task.
+  void add(const Task& task);
+
+  // Appends a completed framework. Its completed tasks have to be
+  // appended separately.
+  void add(const CompletedFramework& framework);
+
+  // Returns up to 'limit' completed tasks, skipping the first
+  // 'offset' ones. The tasks are grouped by framework, unless only
+  // the tasks of the specified framework are asked for.
+  process::Future<std::vector<Task> > tasks(
+      const Option<FrameworkID>& frameworkId,
+      size_t offset,
+      size_t limit);
+
+  // Returns up to 'limit' completed frameworks, skipping the first
+  // 'offset' ones.
+  process::Future<std::vector<CompletedFramework> > frameworks(
+      size_t offset,
+      size_t limit);
+
+private:
+  HistoryProcess* process;
+};
+
+
+class HistoryProcess : public process::Process<HistoryProcess>
+{
+public:
+  HistoryProcess(const std::string& path, size_t capacity);
+  virtual ~HistoryProcess();
+
+  virtual void initialize();
+
+  void add(const Task& task);
+  void add(const CompletedFramework& framework);
+
+  process::Future<std::vector<Task> > tasks(
+      const Option<FrameworkID>& frameworkId,
+      size_t offset,
+      size_t limit);
+
+  process::Future<std::vector<CompletedFramework> > frameworks(
+      size_t offset,
+      size_t limit);
+
+private:
+  // The indexes of the records kept under a prefix, i.e., of the
+  // frameworks or of the tasks of a framework. The indexes are
+  // consecutive so a page can be found without counting records.
+  struct Range
+  {
+    Range() : first(0), next(0) {}
+
+    uint64_t first; // Index of the oldest record still kept.
+    uint64_t next;  // Index of the next record appended.
+  };
+
+  // Writes the (serialized) record under the key 'prefix' followed
+  // by the next index for the prefix, and deletes the oldest records
+  // once there are more than 'capacity'.
+  Try<Nothing> append(const std::string& prefix, const std::string& value);
+
+  // Reads up to 'limit' of the (serialized) records whose keys start
+  // with 'prefix', skipping the first 'offset' ones.
+  Try<std::vector<std::string> > read(
+      const std::string& prefix,
+      size_t offset,
+      size_t limit);
+
+  const std::string path;
+  const size_t capacity;
+  leveldb::DB* db;
+
+  uint64_t sequence; // Last sequence number used.
+  uint64_t oldest;   // Sequence number of the oldest record kept.
+
+  // Ranges by prefix, sorted like the keys so that the tasks of all
+  // frameworks can be paged through in key order.
+  std::map<std::string, Range> ranges;
+
+  Option<std::string> error;
+};
+
+
+inline History::History(const std::string& path, size_t capacity)
+{
+  process = new HistoryProcess(path, capacity);
+  process::spawn(process);
+}
+
+
+inline History::~History()
+{
+  // Not injecting the termination, so that the appends which are
+  // still queued get written first.
+  process::terminate(process, false);
+  process::wait(process);
+  delete process;
+}
+
+
+inline void History::add(const Task& task)
+{
+  void (HistoryProcess::*add)(const Task&) = &HistoryProcess::add;
+  process::dispatch(process, add, task);
+}
+
+
+inline void History::add(const CompletedFramework& framework)
+{
+  void (HistoryProcess::*add)(const CompletedFramework&) =
+    &HistoryProcess::add;
+  process::dispatch(process, add, framework);
+}
+
+
+inline process::Future<std::vector<Task> > History::tasks(
+    const Option<FrameworkID>& frameworkId,
+    size_t offset,
+    size_t limit)
+{
+  return process::dispatch(
+      process, &HistoryProcess::tasks, frameworkId, offset, limit);
+}
+
+
+inline process::Future<std::vector<CompletedFramework> > History::frameworks(
+    size_t offset,
+    size_t limit)
+{
+  return process::dispatch(
+      process, &HistoryProcess::frameworks, offset, limit);
+}
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MASTER_HISTORY_HPP__
@@ -16,6 +16,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <iomanip>
 #include <map>
 #include <sstream>
@@ -24,13 +25,19 @@
 
 #include <mesos/mesos.hpp>
 
+#include <stout/error.hpp>
 #include <stout/foreach.hpp>
 #include <stout/json.hpp>
+#include <stout/lambda.hpp>
 #include <stout/net.hpp>
+#include <stout/nothing.hpp>
 #include <stout/numify.hpp>
+#include <stout/option.hpp>
 #include <stout/os.hpp>
 #include <stout/result.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
+#include <stout/try.hpp>
 
 #include "common/attributes.hpp"
 #include "common/build.hpp"
@@ -39,6 +46,8 @@
 
 #include "logging/logging.hpp"
 
+#include "master/constants.hpp"
+#include "master/history.hpp"
 #include "master/http.hpp"
 #include "master/master.hpp"
 
@@ -146,6 +155,19 @@ JSON::Object model(const Offer& offer)
 }
 
 
+// Returns a JSON object modeled on a CompletedFramework.
+JSON::Object model(const CompletedFramework& framework)
+{
+  JSON::Object object;
+  object.values["id"] = framework.info().id().value();
+  object.values["name"] = framework.info().name();
+  object.values["user"] = framework.info().user();
+  object.values["registered_time"] = framework.registered_time();
+  object.values["unregistered_time"] = framework.unregistered_time();
+  return object;
+}
+
+
 // Returns a JSON object modeled on a Framework.
 JSON::Object model(const Framework& framework)
 {
@@ -176,8 +198,9 @@ JSON::Object model(const Framework& framework)
   // Model all of the completed tasks of a framework.
   {
     JSON::Array array;
-    foreach (const Task& task, framework.completedTasks) {
-      array.values.push_back(model(task));
+    foreach (const std::tr1::shared_ptr<const Task>& task,
+             framework.completedTasks) {
+      array.values.push_back(model(*task));
     }
 
     object.values["completed_tasks"] = array;
@@ -193,6 +216,21 @@ JSON::Object model(const Framework& framework)
     object.values["offers"] = array;
   }
 
+  // Model how long the framework held on to its offers, labeling
+  // each bucket by its bound in milliseconds (stringifying a
+  // Duration picks the unit, e.g., "1.66666666666667mins").
+  {
+    JSON::Object histogram;
+    const vector<uint64_t>& counts = framework.offerHoldTimes.counts;
+    for (size_t i = 0; i < OFFER_HOLD_TIME_BUCKETS; i++) {
+      const uint64_t ms = (uint64_t) OfferHoldTimes::bound(i).ms();
+      histogram.values[stringify(ms)] = counts[i];
+    }
+    histogram.values["+Inf"] = counts[OFFER_HOLD_TIME_BUCKETS];
+
+    object.values["offer_hold_times_ms"] = histogram;
+  }
+
   return object;
 }
 
@@ -279,6 +317,22 @@ Future<Response> stats(
   object.values["valid_status_updates"] = master.stats.validStatusUpdates;
   object.values["invalid_status_updates"] = master.stats.invalidStatusUpdates;
   object.values["outstanding_offers"] = master.offers.size();
+  object.values["timed_out_offers"] = master.stats.timedOutOffers;
+  object.values["queued_slave_reregistrations"] = master.admissions.size();
+
+  // Memory used by the task and offer records.
+  size_t completedTaskBytes = 0;
+  foreachvalue (Framework* framework, master.frameworks) {
+    completedTaskBytes += framework->completedTasksBytes;
+  }
+  foreach (const std::tr1::shared_ptr<Framework>& framework,
+           master.completedFrameworks) {
+    completedTaskBytes += framework->completedTasksBytes;
+  }
+  object.values["task_bytes"] = master.stats.taskBytes;
+  object.values["completed_task_bytes"] = completedTaskBytes;
+  object.values["offer_bytes"] = master.stats.offerBytes;
+  object.values["dropped_log_messages"] = logging::dropped();
 
   // Get total and used (note, not offered) resources in order to
   // compute capacity of scalar resources.
@@ -378,6 +432,126 @@ Future<Response> state(
   return OK(object, request.query.get("jsonp"));
 }
 
+
+// Parses the 'offset' and 'limit' of a page of the history from the
+// query. The limit defaults to (and is capped at) the page size.
+Try<Nothing> page(const Request& request, size_t* offset, size_t* limit)
+{
+  *offset = 0;
+  *limit = MAX_HISTORY_PAGE_SIZE;
+
+  if (request.query.get("offset").isSome()) {
+    Try<size_t> result = numify<size_t>(request.query.get("offset").get());
+    if (result.isError()) {
+      return Error("Failed to parse offset: " + result.error());
+    }
+    *offset = result.get();
+  }
+
+  if (request.query.get("limit").isSome()) {
+    Try<size_t> result = numify<size_t>(request.query.get("limit").get());
+    if (result.isError()) {
+      return Error("Failed to parse limit: " + result.error());
+    }
+    *limit = std::min(result.get(), (size_t) MAX_HISTORY_PAGE_SIZE);
+  }
+
+  return Nothing();
+}
+
+
+Future<Response> _completedFrameworks(
+    size_t offset,
+    const Option<string>& jsonp,
+    const vector<CompletedFramework>& frameworks)
+{
+  JSON::Array array;
+  foreach (const CompletedFramework& framework, frameworks) {
+    array.values.push_back(model(framework));
+  }
+
+  JSON::Object object;
+  object.values["offset"] = offset;
+  object.values["completed_frameworks"] = array;
+
+  return OK(object, jsonp);
+}
+
+
+Future<Response> completedFrameworks(
+    const Master& master,
+    const Request& request)
+{
+  VLOG(1) << "HTTP request for '" << request.path << "'";
+
+  CHECK_NOTNULL(master.history);
+
+  size_t offset;
+  size_t limit;
+
+  Try<Nothing> result = page(request, &offset, &limit);
+  if (result.isError()) {
+    return BadRequest(result.error() + ".\n");
+  }
+
+  return master.history->frameworks(offset, limit)
+    .then(lambda::bind(
+        _completedFrameworks,
+        offset,
+        request.query.get("jsonp"),
+        lambda::_1));
+}
+
+
+Future<Response> _completedTasks(
+    size_t offset,
+    const Option<string>& jsonp,
+    const vector<Task>& tasks)
+{
+  JSON::Array array;
+  foreach (const Task& task, tasks) {
+    array.values.push_back(model(task));
+  }
+
+  JSON::Object object;
+  object.values["offset"] = offset;
+  object.values["completed_tasks"] = array;
+
+  return OK(object, jsonp);
+}
+
+
+Future<Response> completedTasks(
+    const Master& master,
+    const Request& request)
+{
+  VLOG(1) << "HTTP request for '" << request.path << "'";
+
+  CHECK_NOTNULL(master.history);
+
+  size_t offset;
+  size_t limit;
+
+  Try<Nothing> result = page(request, &offset, &limit);
+  if (result.isError()) {
+    return BadRequest(result.error() + ".\n");
+  }
+
+  Option<FrameworkID> frameworkId;
+  if (request.query.get("framework_id").isSome()) {
+    FrameworkID id;
+    id.set_value(request.query.get("framework_id").get());
+    frameworkId = Option<FrameworkID>::some(id);
+  }
+
+  return master.history->tasks(frameworkId, offset, limit)
+    .then(lambda::bind(
+        _completedTasks,
+        offset,
+        request.query.get("jsonp"),
+        lambda::_1));
+}
+
 } // namespace json {
 } // namespace http {
 } // namespace master {
@@ -56,6 +56,20 @@ process::Future<process::http::Response> state(
     const Master& master,
     const process::http::Request& request);
 
+
+// Returns a page of the completed frameworks from the on-disk
+// history, see 'offset' and 'limit' in the query.
+process::Future<process::http::Response> completedFrameworks(
+    const Master& master,
+    const process::http::Request& request);
+
+
+// Returns a page of the completed tasks from the on-disk history,
+// see 'offset', 'limit' and 'framework_id' in the query.
+process::Future<process::http::Response> completedTasks(
+    const Master& master,
+    const process::http::Request& request);
+
 } // namespace json {
 } // namespace http {
 } // namespace master {
@@ -114,10 +114,15 @@ int main(int argc, char** argv)
   LOG(INFO) << "Build: " << build::DATE << " by " << build::USER;
   LOG(INFO) << "Starting Mesos master";
 
-  allocator::AllocatorProcess* allocatorProcess =
-    new allocator::HierarchicalDRFAllocatorProcess();
+  Try<allocator::AllocatorProcess*> allocatorProcess =
+    allocator::createHierarchicalDRFAllocatorProcess(flags.placement);
+  if (allocatorProcess.isError()) {
+    cerr << allocatorProcess.error() << endl;
+    usage(argv[0], flags);
+    exit(1);
+  }
   allocator::Allocator* allocator =
-    new allocator::Allocator(allocatorProcess);
+    new allocator::Allocator(allocatorProcess.get());
 
   Files files;
   Master* master = new Master(allocator, &files, flags);
@@ -131,7 +136,7 @@ int main(int argc, char** argv)
   process::wait(master->self());
   delete master;
   delete allocator;
-  delete allocatorProcess;
+  delete allocatorProcess.get();
 
   MasterDetector::destroy(detector.get());
 
@@ -16,6 +16,9 @@
  * limitations under the License.
  */
 
+#include <stdlib.h> // For rand_r().
+
+#include <algorithm>
 #include <fstream>
 #include <iomanip>
 #include <list>
@@ -27,6 +30,7 @@
 #include <process/run.hpp>
 
 #include <stout/check.hpp>
+#include <stout/exit.hpp>
 #include <stout/multihashmap.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
@@ -42,6 +46,7 @@
 
 #include "master/allocator.hpp"
 #include "master/flags.hpp"
+#include "master/history.hpp"
 #include "master/master.hpp"
 
 namespace params = std::tr1::placeholders;
@@ -60,7 +65,9 @@ namespace mesos {
 namespace internal {
 namespace master {
 
+using allocator::AddedSlave;
 using allocator::Allocator;
+using allocator::RecoveredResources;
 
 class WhitelistWatcher : public Process<WhitelistWatcher> {
 public:
@@ -125,64 +132,154 @@ private:
 };
 
 
-class SlaveObserver : public Process<SlaveObserver>
+// Pings all of the slaves from a single process, rather than from
+// one process (with its own timer) per slave, and asks the master to
+// deactivate the slaves that missed too many pings in a row. Each
+// wake up handles every slave that is due, and wake ups are at least
+// 'batchInterval' apart. The pings of each slave are jittered so that
+// slaves that were added together don't stay in lockstep.
+class SlaveHealthChecker : public Process<SlaveHealthChecker>
 {
 public:
-  SlaveObserver(const UPID& _slave,
-                const SlaveInfo& _slaveInfo,
-                const SlaveID& _slaveId,
-                const PID<Master>& _master)
-    : ProcessBase(ID::generate("slave-observer")),
-      slave(_slave),
-      slaveInfo(_slaveInfo),
-      slaveId(_slaveId),
+  SlaveHealthChecker(const PID<Master>& _master,
+                     const Duration& _timeout,
+                     uint32_t _maxTimeouts,
+                     const Duration& _batchInterval,
+                     double _jitter)
+    : ProcessBase(ID::generate("slave-health-checker")),
       master(_master),
-      timeouts(0),
-      pinged(false)
+      timeout(_timeout),
+      maxTimeouts(_maxTimeouts),
+      batchInterval(_batchInterval),
+      jitter(_jitter),
+      checks(0)
+  {
+    install("PONG", &SlaveHealthChecker::pong);
+  }
+
+  void add(const SlaveID& slaveId, const UPID& pid)
+  {
+    remove(slaveId); // In case the slave re-registered from elsewhere.
+
+    Health health;
+    health.pid = pid;
+    health.timeouts = 0;
+
+    slaves[slaveId] = health;
+    pids[pid] = slaveId;
+
+    // Ping right away, rather than waiting for the next check.
+    ping(&slaves[slaveId]);
+
+    if (armed.isNone() || slaves[slaveId].due < armed.get()) {
+      schedule(slaves[slaveId].due);
+    }
+  }
+
+  void remove(const SlaveID& slaveId)
   {
-    install("PONG", &SlaveObserver::pong);
+    if (slaves.contains(slaveId)) {
+      const UPID& pid = slaves[slaveId].pid;
+      if (pids.contains(pid) && pids[pid] == slaveId) {
+        pids.erase(pid);
+      }
+      slaves.erase(slaveId);
+    }
   }
 
 protected:
   virtual void initialize()
   {
-    send(slave, "PING");
-    pinged = true;
-    delay(SLAVE_PING_TIMEOUT, self(), &SlaveObserver::timeout);
+    seed = std::tr1::hash<string>()(UUID::random().toBytes());
   }
 
   void pong(const UPID& from, const string& body)
   {
-    timeouts = 0;
-    pinged = false;
+    if (pids.contains(from)) {
+      Health& health = slaves[pids[from]];
+      health.timeouts = 0;
+      health.pinged = false;
+    }
   }
 
-  void timeout()
+  void check(uint64_t id)
   {
-    if (pinged) { // So we haven't got back a pong yet ...
-      if (++timeouts >= MAX_SLAVE_PING_TIMEOUTS) {
-        deactivate();
-        return;
+    if (id != checks) {
+      return; // Superseded by a check scheduled later.
+    }
+
+    armed = None();
+
+    const Time now = Clock::now();
+
+    vector<SlaveID> deactivated;
+    Option<Time> next;
+
+    foreachpair (const SlaveID& slaveId, Health& health, slaves) {
+      if (health.due <= now) {
+        if (health.pinged) { // So we haven't got back a pong yet ...
+          if (++health.timeouts >= maxTimeouts) {
+            deactivated.push_back(slaveId);
+            continue;
+          }
+        }
+
+        ping(&health);
+      }
+
+      if (next.isNone() || health.due < next.get()) {
+        next = health.due;
       }
     }
 
-    send(slave, "PING");
-    pinged = true;
-    delay(SLAVE_PING_TIMEOUT, self(), &SlaveObserver::timeout);
+    foreach (const SlaveID& slaveId, deactivated) {
+      remove(slaveId);
+      dispatch(master, &Master::deactivateSlave, slaveId);
+    }
+
+    if (next.isSome()) {
+      schedule(std::max(next.get(), now + batchInterval));
+    }
   }
 
-  void deactivate()
+private:
+  struct Health
   {
-    dispatch(master, &Master::deactivateSlave, slaveId);
+    UPID pid;
+    Time due;          // When to check on the slave next.
+    uint32_t timeouts; // Pings in a row that didn't get a pong.
+    bool pinged;       // Whether a pong is expected.
+  };
+
+  void ping(Health* health)
+  {
+    send(health->pid, "PING");
+    health->pinged = true;
+
+    // The next check comes up to 'jitter' of the timeout early.
+    double early = jitter * ((double) rand_r(&seed) / RAND_MAX);
+    health->due = Clock::now() + timeout - timeout * early;
+  }
+
+  void schedule(const Time& when)
+  {
+    armed = when;
+    delay(when - Clock::now(), self(), &SlaveHealthChecker::check, ++checks);
   }
 
-private:
-  const UPID slave;
-  const SlaveInfo slaveInfo;
-  const SlaveID slaveId;
   const PID<Master> master;
-  uint32_t timeouts;
-  bool pinged;
+  const Duration timeout;
+  const uint32_t maxTimeouts;
+  const Duration batchInterval;
+  const double jitter;
+
+  hashmap<SlaveID, Health> slaves;
+  hashmap<UPID, SlaveID> pids;
+
+  Option<Time> armed; // When the next check happens, if any.
+  uint64_t checks;    // Identifies the latest scheduled check.
+
+  unsigned int seed; // For rand_r().
 };
 
 
@@ -191,7 +288,8 @@ Master::Master(Allocator* _allocator, Files* _files)
     flags(),
     allocator(_allocator),
     files(_files),
-    completedFrameworks(MAX_COMPLETED_FRAMEWORKS) {}
+    completedFrameworks(MAX_COMPLETED_FRAMEWORKS),
+    history(NULL) {}
 
 
 Master::Master(Allocator* _allocator, Files* _files, const Flags& _flags)
@@ -199,7 +297,8 @@ Master::Master(Allocator* _allocator, Files* _files, const Flags& _flags)
     flags(_flags),
     allocator(_allocator),
     files(_files),
-    completedFrameworks(MAX_COMPLETED_FRAMEWORKS) {}
+    completedFrameworks(MAX_COMPLETED_FRAMEWORKS),
+    history(NULL) {}
 
 
 Master::~Master()
@@ -220,6 +319,15 @@ Master::~Master()
   wait(whitelistWatcher);
 
   delete whitelistWatcher;
+
+  terminate(healthChecker);
+  wait(healthChecker);
+
+  delete healthChecker;
+
+  // Deleted last, removing the frameworks above may have appended
+  // to it.
+  delete history;
 }
 
 
@@ -237,6 +345,10 @@ void Master::initialize()
   CHECK(!id.isError()) << id.error();
 
   info.set_id(id.get());
+
+  // Used for generating framework, offer and slave IDs.
+  prefix = info.id() + "-";
+
   info.set_ip(self().ip);
   info.set_port(self().port);
 
@@ -249,6 +361,19 @@ void Master::initialize()
   whitelistWatcher = new WhitelistWatcher(flags.whitelist, allocator);
   spawn(whitelistWatcher);
 
+  if (flags.slave_ping_jitter < 0 || flags.slave_ping_jitter >= 1) {
+    EXIT(1) << "Invalid --slave_ping_jitter " << flags.slave_ping_jitter
+            << ", it must be at least 0 and less than 1";
+  }
+
+  healthChecker = new SlaveHealthChecker(
+      self(),
+      flags.slave_ping_timeout,
+      flags.max_slave_ping_timeouts,
+      flags.slave_ping_batch_interval,
+      flags.slave_ping_jitter);
+  spawn(healthChecker);
+
   elected = false;
 
   nextFrameworkId = 0;
@@ -267,6 +392,9 @@ void Master::initialize()
   stats.invalidStatusUpdates = 0;
   stats.validFrameworkMessages = 0;
   stats.invalidFrameworkMessages = 0;
+  stats.timedOutOffers = 0;
+  stats.taskBytes = 0;
+  stats.offerBytes = 0;
 
   startTime = Clock::now();
 
@@ -360,6 +488,22 @@ void Master::initialize()
   route("/stats.json", bind(&http::json::stats, cref(*this), params::_1));
   route("/state.json", bind(&http::json::state, cref(*this), params::_1));
 
+  if (flags.history_dir.isSome()) {
+    Try<Nothing> mkdir = os::mkdir(flags.history_dir.get());
+    if (mkdir.isError()) {
+      EXIT(1) << "Failed to create the history directory '"
+              << flags.history_dir.get() << "': " << mkdir.error();
+    }
+
+    history = new History(
+        flags.history_dir.get(), flags.max_history_records);
+
+    route("/completed_frameworks.json",
+          bind(&http::json::completedFrameworks, cref(*this), params::_1));
+    route("/completed_tasks.json",
+          bind(&http::json::completedTasks, cref(*this), params::_1));
+  }
+
   // Provide HTTP assets from a "webui" directory. This is either
   // specified via flags (which is necessary for running out of the
   // build directory before 'make install') or determined at build
@@ -431,14 +575,16 @@ void Master::exited(const UPID& pid)
           framework->reregisteredTime);
 
       // Remove the framework's offers.
+      vector<RecoveredResources> recovered;
       foreach (Offer* offer, utils::copy(framework->offers)) {
-        allocator->resourcesRecovered(
+        recovered.push_back(RecoveredResources(
             offer->framework_id(),
             offer->slave_id(),
-            Resources(offer->resources()));
+            Resources(offer->resources())));
 
         removeOffer(offer);
       }
+      allocator->resourcesRecoveredBatch(recovered);
       return;
     }
   }
@@ -451,7 +597,9 @@ void Master::exited(const UPID& pid)
   //    fall into one of the 2 cases:
   //    2.1) Framework is checkpointing: No immediate action is taken.
   //         The slave is given a chance to reconnect until the slave
-  //         observer times out (75s) and removes the slave (Case 1).
+  //         health checker times out (75s by default, see the
+  //         --slave_ping_timeout and --max_slave_ping_timeouts flags)
+  //         and removes the slave (Case 1).
   //    2.2) Framework is not-checkpointing: The slave is not removed
   //         but the framework is removed from the slave's structs,
   //         its tasks transitioned to LOST and resources recovered.
@@ -564,7 +712,11 @@ void Master::registerFramework(const FrameworkInfo& frameworkInfo)
   }
 
   Framework* framework =
-    new Framework(frameworkInfo, newFrameworkId(), from, Clock::now());
+    new Framework(frameworkInfo,
+                  newFrameworkId(),
+                  from,
+                  Clock::now(),
+                  flags.max_completed_tasks_per_framework);
 
   LOG(INFO) << "Registering framework " << framework->id << " at " << from;
 
@@ -630,12 +782,14 @@ void Master::reregisterFramework(const FrameworkInfo& frameworkInfo,
       // NOTE: We need to do this because the scheduler might have
       // replied to the offers but the driver might have dropped
       // those messages since it wasn't connected to the master.
+      vector<RecoveredResources> recovered;
       foreach (Offer* offer, utils::copy(framework->offers)) {
-        allocator->resourcesRecovered(offer->framework_id(),
-                                      offer->slave_id(),
-                                      offer->resources());
+        recovered.push_back(RecoveredResources(offer->framework_id(),
+                                               offer->slave_id(),
+                                               offer->resources()));
         removeOffer(offer);
       }
+      allocator->resourcesRecoveredBatch(recovered);
 
       FrameworkReregisteredMessage message;
       message.mutable_framework_id()->MergeFrom(frameworkInfo.id());
@@ -649,7 +803,11 @@ void Master::reregisterFramework(const FrameworkInfo& frameworkInfo,
     // failed-over one is connecting. Create a Framework object and add
     // any tasks it has that have been reported by reconnecting slaves.
     Framework* framework =
-      new Framework(frameworkInfo, frameworkInfo.id(), from, Clock::now());
+      new Framework(frameworkInfo,
+                    frameworkInfo.id(),
+                    from,
+                    Clock::now(),
+                    flags.max_completed_tasks_per_framework);
 
     // TODO(benh): Check for root submissions like above!
 
@@ -923,77 +1081,159 @@ void Master::reregisterSlave(const SlaveID& slaveId,
   if (slaveId == "") {
     LOG(ERROR) << "Slave " << from << " re-registered without an id!";
     reply(ShutdownMessage());
-  } else if (deactivatedSlaves.contains(from)) {
+    return;
+  }
+
+  // After a failover every slave re-registers at (about) the same
+  // time, so rather than re-registering each slave (and reconciling
+  // its tasks) as soon as its message arrives we queue the
+  // re-registrations and admit them in batches, handling any other
+  // messages in between batches (see Master::admitSlaves). A slave
+  // that retries while it is still queued only gets queued once,
+  // with its latest message.
+  if (!reregistrations.contains(slaveId)) {
+    admissions.push_back(slaveId);
+
+    if (admissions.size() == 1) {
+      dispatch(self(), &Master::admitSlaves);
+    }
+  }
+
+  Reregistration& reregistration = reregistrations[slaveId];
+  reregistration.pid = from;
+  reregistration.slaveInfo = slaveInfo;
+  reregistration.executorInfos = executorInfos;
+  reregistration.tasks = tasks;
+}
+
+
+void Master::admitSlaves()
+{
+  size_t admitted = 0;
+
+  // Slaves that are new to this master get handed to the allocator
+  // together once the whole batch has been admitted.
+  vector<AddedSlave> added;
+
+  while (!admissions.empty() && admitted < flags.slave_reregistration_batch) {
+    const SlaveID slaveId = admissions.front();
+    admissions.pop_front();
+
+    // Not copying the re-registration, it holds all of the tasks
+    // running on the slave.
+    CHECK(reregistrations.contains(slaveId));
+    const Reregistration& reregistration = reregistrations[slaveId];
+
+    _reregisterSlave(
+        slaveId,
+        reregistration.pid,
+        reregistration.slaveInfo,
+        reregistration.executorInfos,
+        reregistration.tasks,
+        &added);
+
+    reregistrations.erase(slaveId);
+
+    admitted++;
+  }
+
+  allocator->slavesAdded(added);
+
+  if (!admissions.empty()) {
+    LOG(INFO) << "Admitted " << admitted << " slave re-registrations, "
+              << admissions.size() << " still queued";
+
+    // Let any other queued messages get processed first.
+    dispatch(self(), &Master::admitSlaves);
+  }
+}
+
+
+void Master::_reregisterSlave(const SlaveID& slaveId,
+                              const UPID& pid,
+                              const SlaveInfo& slaveInfo,
+                              const vector<ExecutorInfo>& executorInfos,
+                              const vector<Task>& tasks,
+                              vector<AddedSlave>* added)
+{
+  if (!elected) {
+    LOG(WARNING) << "Ignoring re-register slave message from "
+                 << slaveInfo.hostname() << " since no longer elected";
+    return;
+  }
+
+  if (deactivatedSlaves.contains(pid)) {
     // We disallow deactivated slaves from re-registering. This is
     // to ensure that when a master deactivates a slave that was
     // partitioned, we don't allow the slave to re-register, as we've
     // already informed frameworks that the tasks were lost.
-    LOG(ERROR) << "Slave " << slaveId << " at " << from
+    LOG(ERROR) << "Slave " << slaveId << " at " << pid
                << " attempted to re-register after deactivation";
-    reply(ShutdownMessage());
-  } else {
-    Slave* slave = getSlave(slaveId);
-    if (slave != NULL) {
-      // NOTE: This handles the case where a slave tries to
-      // re-register with an existing master (e.g. because of a
-      // spurious Zookeeper session expiration or after the slave
-      // recovers after a restart).
-      // For now, we assume this slave is not nefarious (eventually
-      // this will be handled by orthogonal security measures like key
-      // based authentication).
-      LOG(WARNING) << "Slave at " << from << " (" << slave->info.hostname()
-                   << ") is being allowed to re-register with an already"
-                   << " in use id (" << slaveId << ")";
-
-      // Reconcile tasks between master and the slave.
-      reconcileTasks(slave, tasks);
-
-      SlaveReregisteredMessage message;
-      message.mutable_slave_id()->MergeFrom(slave->id);
-      reply(message);
+    send(pid, ShutdownMessage());
+    return;
+  }
 
-      // Update the slave pid and relink to it.
-      slave->pid = from;
-      link(slave->pid);
-    } else {
-      // NOTE: This handles the case when the slave tries to
-      // re-register with a failed over master.
-      slave = new Slave(slaveInfo, slaveId, from, Clock::now());
-
-      LOG(INFO) << "Attempting to re-register slave " << slave->id << " at "
-                << slave->pid << " (" << slave->info.hostname() << ")";
-
-      // TODO(benh): We assume all slaves can register for now.
-      CHECK(flags.slaves == "*");
-      readdSlave(slave, executorInfos, tasks);
-
-//       // Checks if this slave, or if all slaves, can be accepted.
-//       if (slaveHostnamePorts.contains(slaveInfo.hostname(), from.port)) {
-//         run(&SlaveReregistrar::run, slave, executorInfos, tasks, self());
-//       } else if (flags.slaves == "*") {
-//         run(&SlaveReregistrar::run,
-//             slave, executorInfos, tasks, self(), slavesManager->self());
-//       } else {
-//         LOG(WARNING) << "Cannot re-register slave at "
-//                      << slaveInfo.hostname() << ":" << from.port
-//                      << " because not in allocated set of slaves!";
-//         reply(ShutdownMessage());
-//       }
-    }
+  Slave* slave = getSlave(slaveId);
+  if (slave != NULL) {
+    // NOTE: This handles the case where a slave tries to
+    // re-register with an existing master (e.g. because of a
+    // spurious Zookeeper session expiration or after the slave
+    // recovers after a restart).
+    // For now, we assume this slave is not nefarious (eventually
+    // this will be handled by orthogonal security measures like key
+    // based authentication).
+    LOG(WARNING) << "Slave at " << pid << " (" << slave->info.hostname()
+                 << ") is being allowed to re-register with an already"
+                 << " in use id (" << slaveId << ")";
+
+    // Reconcile tasks between master and the slave.
+    reconcileTasks(slave, tasks);
 
-    // Send the latest framework pids to the slave.
-    CHECK_NOTNULL(slave);
-    hashset<UPID> pids;
-    foreach (const Task& task, tasks) {
-      Framework* framework = getFramework(task.framework_id());
-      if (framework != NULL && !pids.contains(framework->pid)) {
-        UpdateFrameworkMessage message;
-        message.mutable_framework_id()->MergeFrom(framework->id);
-        message.set_pid(framework->pid);
-        send(slave->pid, message);
-
-        pids.insert(framework->pid);
-      }
+    SlaveReregisteredMessage message;
+    message.mutable_slave_id()->MergeFrom(slave->id);
+    send(pid, message);
+
+    // Update the slave pid and relink to it.
+    slave->pid = pid;
+    link(slave->pid);
+  } else {
+    // NOTE: This handles the case when the slave tries to
+    // re-register with a failed over master.
+    slave = new Slave(slaveInfo, slaveId, pid, Clock::now());
+
+    LOG(INFO) << "Attempting to re-register slave " << slave->id << " at "
+              << slave->pid << " (" << slave->info.hostname() << ")";
+
+    // TODO(benh): We assume all slaves can register for now.
+    CHECK(flags.slaves == "*");
+    readdSlave(slave, executorInfos, tasks, added);
+
+//     // Checks if this slave, or if all slaves, can be accepted.
+//     if (slaveHostnamePorts.contains(slaveInfo.hostname(), from.port)) {
+//       run(&SlaveReregistrar::run, slave, executorInfos, tasks, self());
+//     } else if (flags.slaves == "*") {
+//       run(&SlaveReregistrar::run,
+//           slave, executorInfos, tasks, self(), slavesManager->self());
+//     } else {
+//       LOG(WARNING) << "Cannot re-register slave at "
+//                    << slaveInfo.hostname() << ":" << from.port
+//                    << " because not in allocated set of slaves!";
+//       reply(ShutdownMessage());
+//     }
+  }
+
+  // Send the latest framework pids to the slave.
+  CHECK_NOTNULL(slave);
+  hashset<UPID> pids;
+  foreach (const Task& task, tasks) {
+    Framework* framework = getFramework(task.framework_id());
+    if (framework != NULL && !pids.contains(framework->pid)) {
+      UpdateFrameworkMessage message;
+      message.mutable_framework_id()->MergeFrom(framework->id);
+      message.set_pid(framework->pid);
+      send(slave->pid, message);
+
+      pids.insert(framework->pid);
     }
   }
 }
@@ -1145,8 +1385,8 @@ void Master::exitedExecutor(const SlaveID& slaveId,
 void Master::deactivateSlave(const SlaveID& slaveId)
 {
   if (!slaves.contains(slaveId)) {
-    // Possible when the SlaveObserver dispatched to deactivate a slave,
-    // but exited() was already called for this slave.
+    // Possible when the SlaveHealthChecker dispatched to deactivate
+    // a slave, but exited() was already called for this slave.
     LOG(WARNING) << "Unable to deactivate unknown slave " << slaveId;
     return;
   }
@@ -1183,15 +1423,19 @@ void Master::offer(const FrameworkID& frameworkId,
                  << frameworkId << " because the framework"
                  << " has terminated or is inactive";
 
+    vector<RecoveredResources> recovered;
     foreachpair (const SlaveID& slaveId, const Resources& offered, resources) {
-      allocator->resourcesRecovered(frameworkId, slaveId, offered);
+      recovered.push_back(RecoveredResources(frameworkId, slaveId, offered));
     }
+    allocator->resourcesRecoveredBatch(recovered);
     return;
   }
 
   // Create an offer for each slave and add it to the message.
   ResourceOffersMessage message;
 
+  vector<RecoveredResources> recovered;
+
   Framework* framework = frameworks[frameworkId];
   foreachpair (const SlaveID& slaveId, const Resources& offered, resources) {
     if (!slaves.contains(slaveId)) {
@@ -1199,7 +1443,7 @@ void Master::offer(const FrameworkID& frameworkId,
                    << frameworkId << " because slave " << slaveId
                    << " is not valid";
 
-      allocator->resourcesRecovered(frameworkId, slaveId, offered);
+      recovered.push_back(RecoveredResources(frameworkId, slaveId, offered));
       continue;
     }
 
@@ -1224,6 +1468,8 @@ void Master::offer(const FrameworkID& frameworkId,
 
     offers[offer->id()] = offer;
 
+    stats.offerBytes += offer->SpaceUsed();
+
     framework->addOffer(offer);
     slave->addOffer(offer);
 
@@ -1232,14 +1478,62 @@ void Master::offer(const FrameworkID& frameworkId,
     message.add_pids(slave->pid);
   }
 
+  allocator->resourcesRecoveredBatch(recovered);
+
   if (message.offers().size() == 0) {
     return;
   }
 
-  LOG(INFO) << "Sending " << message.offers().size()
-            << " offers to framework " << framework->id;
+  // Offers get sent to every framework on every allocation, so only
+  // log every so often (each offer is logged at VLOG(1) though).
+  LOG_EVERY_N(INFO, 100)
+    << "Sending " << message.offers().size()
+    << " offers to framework " << framework->id
+    << " (" << google::COUNTER << " offer messages so far)";
 
   send(framework->pid, message);
+
+  // Rescind the offers if the framework hasn't replied in time. We
+  // use a single timer for all of the offers we just sent.
+  if (flags.offer_timeout.isSome()) {
+    vector<OfferID> offerIds;
+    foreach (const Offer& offer, message.offers()) {
+      offerIds.push_back(offer.id());
+    }
+
+    delay(flags.offer_timeout.get(),
+          self(),
+          &Master::offerTimeout,
+          offerIds);
+  }
+}
+
+
+void Master::offerTimeout(const vector<OfferID>& offerIds)
+{
+  // Offers that have been used, declined or rescinded in the
+  // meantime are gone already.
+  vector<RecoveredResources> recovered;
+  foreach (const OfferID& offerId, offerIds) {
+    Offer* offer = getOffer(offerId);
+    if (offer != NULL) {
+      recovered.push_back(RecoveredResources(
+          offer->framework_id(),
+          offer->slave_id(),
+          Resources(offer->resources())));
+
+      removeOffer(offer, true); // Rescind.
+    }
+  }
+
+  if (!recovered.empty()) {
+    LOG(INFO) << "Rescinded " << recovered.size() << " offers of framework "
+              << recovered.front().frameworkId << " after they timed out";
+
+    stats.timedOutOffers += recovered.size();
+
+    allocator->resourcesRecoveredBatch(recovered);
+  }
 }
 
 
@@ -1469,10 +1763,14 @@ void Master::processTasks(Offer* offer,
   CHECK_NOTNULL(framework);
   CHECK_NOTNULL(slave);
 
-  LOG(INFO) << "Processing reply for offer " << offer->id()
-            << " on slave " << slave->id
-            << " (" << slave->info.hostname() << ")"
-            << " for framework " << framework->id;
+  // Like sending offers, only log replies to them every so often
+  // (tasks that get launched are logged below).
+  LOG_EVERY_N(INFO, 100)
+    << "Processing reply for offer " << offer->id()
+    << " on slave " << slave->id
+    << " (" << slave->info.hostname() << ")"
+    << " for framework " << framework->id
+    << " (" << google::COUNTER << " offer replies so far)";
 
   Resources usedResources; // Accumulated resources used from this offer.
 
@@ -1585,6 +1883,9 @@ Resources Master::launchTask(const TaskInfo& task,
 
   slave->addTask(t);
 
+  taskBytes[t] = t->SpaceUsed();
+  stats.taskBytes += taskBytes[t];
+
   resources += task.resources();
 
   // Tell the slave to launch the task!
@@ -1621,6 +1922,7 @@ void Master::reconcileTasks(Slave* slave, const vector<Task>& tasks)
   // missing from the slave. This could happen if the task was
   // dropped by the slave (e.g., slave exited before getting the
   // task or the task was launched while slave was in recovery).
+  vector<RecoveredResources> recovered;
   foreachvalue (Task* task, utils::copy(slave->tasks)) {
     if (!slaveTasks.contains(task->framework_id(), task->task_id())) {
       LOG(WARNING) << "Sending TASK_LOST for task " << task->task_id()
@@ -1640,9 +1942,11 @@ void Master::reconcileTasks(Slave* slave, const vector<Task>& tasks)
         message.mutable_update()->CopyFrom(update);
         send(framework->pid, message);
       }
-      removeTask(task);
+      removeTask(task, &recovered);
     }
   }
+
+  allocator->resourcesRecoveredBatch(recovered);
 }
 
 
@@ -1708,12 +2012,14 @@ void Master::failoverFramework(Framework* framework, const UPID& newPid)
   // registered message so that the allocator can immediately re-offer
   // these resources to this framework if it wants.
   // TODO(benh): Consider just reoffering these to
+  vector<RecoveredResources> recovered;
   foreach (Offer* offer, utils::copy(framework->offers)) {
-    allocator->resourcesRecovered(offer->framework_id(),
-                                  offer->slave_id(),
-                                  Resources(offer->resources()));
+    recovered.push_back(RecoveredResources(offer->framework_id(),
+                                           offer->slave_id(),
+                                           Resources(offer->resources())));
     removeOffer(offer);
   }
+  allocator->resourcesRecoveredBatch(recovered);
 }
 
 
@@ -1731,20 +2037,24 @@ void Master::removeFramework(Framework* framework)
     send(slave->pid, message);
   }
 
+  // The resources of the framework's tasks, offers and executors
+  // are handed back to the allocator in a single batch below.
+  vector<RecoveredResources> recovered;
+
   // Remove pointers to the framework's tasks in slaves.
   foreachvalue (Task* task, utils::copy(framework->tasks)) {
     Slave* slave = getSlave(task->slave_id());
     // Since we only find out about tasks when the slave re-registers,
     // it must be the case that the slave exists!
     CHECK(slave != NULL);
-    removeTask(task);
+    removeTask(task, &recovered);
   }
 
   // Remove the framework's offers (if they weren't removed before).
   foreach (Offer* offer, utils::copy(framework->offers)) {
-    allocator->resourcesRecovered(offer->framework_id(),
-                                  offer->slave_id(),
-                                  Resources(offer->resources()));
+    recovered.push_back(RecoveredResources(offer->framework_id(),
+                                           offer->slave_id(),
+                                           Resources(offer->resources())));
     removeOffer(offer);
   }
 
@@ -1755,14 +2065,16 @@ void Master::removeFramework(Framework* framework)
       foreachpair (const ExecutorID& executorId,
                    const ExecutorInfo& executorInfo,
                    framework->executors[slaveId]) {
-        allocator->resourcesRecovered(framework->id,
-                                      slave->id,
-                                      executorInfo.resources());
+        recovered.push_back(RecoveredResources(framework->id,
+                                               slave->id,
+                                               executorInfo.resources()));
         slave->removeExecutor(framework->id, executorId);
       }
     }
   }
 
+  allocator->resourcesRecoveredBatch(recovered);
+
   // TODO(benh): Similar code between removeFramework and
   // failoverFramework needs to be shared!
 
@@ -1770,6 +2082,24 @@ void Master::removeFramework(Framework* framework)
 
   framework->unregisteredTime = Clock::now();
 
+  // The oldest completed framework gets pushed out of the buffer
+  // below, along with its completed tasks, keep them in the history.
+  if (history != NULL && completedFrameworks.full()) {
+    const Framework& oldest = *completedFrameworks.front();
+
+    CompletedFramework completed;
+    completed.mutable_info()->MergeFrom(oldest.info);
+    completed.mutable_info()->mutable_id()->MergeFrom(oldest.id);
+    completed.set_registered_time(oldest.registeredTime.secs());
+    completed.set_unregistered_time(oldest.unregisteredTime.secs());
+    history->add(completed);
+
+    foreach (const std::tr1::shared_ptr<const Task>& task,
+             oldest.completedTasks) {
+      history->add(*task);
+    }
+  }
+
   // The completedFramework buffer now owns the framework pointer.
   completedFrameworks.push_back(std::tr1::shared_ptr<Framework>(framework));
 
@@ -1784,6 +2114,8 @@ void Master::removeFramework(Slave* slave, Framework* framework)
   CHECK_NOTNULL(slave);
   CHECK_NOTNULL(framework);
 
+  vector<RecoveredResources> recovered;
+
   // Remove pointers to framework's tasks in slaves, and send status updates.
   foreachvalue (Task* task, utils::copy(slave->tasks)) {
     // Remove tasks that belong to this framework.
@@ -1809,17 +2141,17 @@ void Master::removeFramework(Slave* slave, Framework* framework)
       send(framework->pid, message);
 
       // Remove the task from slave and framework.
-      removeTask(task);
+      removeTask(task, &recovered);
     }
   }
 
   // Remove and rescind offers from this slave given to this framework.
   foreach (Offer* offer, utils::copy(slave->offers)) {
     if (framework->offers.contains(offer)) {
-      allocator->resourcesRecovered(
+      recovered.push_back(RecoveredResources(
           offer->framework_id(),
           offer->slave_id(),
-          Resources(offer->resources()));
+          Resources(offer->resources())));
 
       // Remove the offer from slave and framework.
       removeOffer(offer, true); // Rescind.
@@ -1832,15 +2164,17 @@ void Master::removeFramework(Slave* slave, Framework* framework)
     foreachkey (const ExecutorID& executorId,
                 utils::copy(slave->executors[framework->id])) {
 
-      allocator->resourcesRecovered(
+      recovered.push_back(RecoveredResources(
           framework->id,
           slave->id,
-          slave->executors[framework->id][executorId].resources());
+          slave->executors[framework->id][executorId].resources()));
 
       framework->removeExecutor(slave->id, executorId);
       slave->removeExecutor(framework->id, executorId);
     }
   }
+
+  allocator->resourcesRecoveredBatch(recovered);
 }
 
 
@@ -1872,10 +2206,8 @@ void Master::addSlave(Slave* slave, bool reregister)
   //     dispatch(slavesManager->self(), &SlavesManager::monitor,
   //              slave->pid, slave->info, slave->id);
 
-  // Set up an observer for the slave.
-  slave->observer = new SlaveObserver(slave->pid, slave->info,
-                                      slave->id, self());
-  spawn(slave->observer);
+  // Start pinging the slave.
+  dispatch(healthChecker, &SlaveHealthChecker::add, slave->id, slave->pid);
 
   if (!reregister) {
     allocator->slaveAdded(slave->id,
@@ -1887,7 +2219,8 @@ void Master::addSlave(Slave* slave, bool reregister)
 
 void Master::readdSlave(Slave* slave,
 			const vector<ExecutorInfo>& executorInfos,
-			const vector<Task>& tasks)
+			const vector<Task>& tasks,
+			vector<AddedSlave>* added)
 {
   CHECK(slave != NULL);
 
@@ -1928,6 +2261,9 @@ void Master::readdSlave(Slave* slave,
     // Add the task to the slave.
     slave->addTask(t);
 
+    taskBytes[t] = t->SpaceUsed();
+    stats.taskBytes += taskBytes[t];
+
     // Try and add the task to the framework too, but since the
     // framework might not yet be connected we won't be able to
     // add them. However, when the framework connects later we
@@ -1949,7 +2285,11 @@ void Master::readdSlave(Slave* slave,
     resources[task.framework_id()] += task.resources();
   }
 
-  allocator->slaveAdded(slave->id, slave->info, resources);
+  if (added != NULL) {
+    added->push_back(AddedSlave(slave->id, slave->info, resources));
+  } else {
+    allocator->slaveAdded(slave->id, slave->info, resources);
+  }
 }
 
 
@@ -1962,6 +2302,8 @@ void Master::removeSlave(Slave* slave)
   // below (e.g., removeTask()) are ignored by the allocator.
   allocator->slaveRemoved(slave->id);
 
+  vector<RecoveredResources> recovered;
+
   // Remove pointers to slave's tasks in frameworks, and send status updates
   foreachvalue (Task* task, utils::copy(slave->tasks)) {
     Framework* framework = getFramework(task->framework_id());
@@ -1992,9 +2334,11 @@ void Master::removeSlave(Slave* slave)
       update->set_uuid(UUID::random().toBytes());
       send(framework->pid, message);
     }
-    removeTask(task);
+    removeTask(task, &recovered);
   }
 
+  allocator->resourcesRecoveredBatch(recovered);
+
   // Remove and rescind offers (but don't "recover" any resources
   // since the slave is gone).
   foreach (Offer* offer, utils::copy(slave->offers)) {
@@ -2024,11 +2368,8 @@ void Master::removeSlave(Slave* slave)
   //     dispatch(slavesManager->self(), &SlavesManager::forget,
   //              slave->pid, slave->info, slave->id);
 
-  // Kill the slave observer.
-  terminate(slave->observer);
-  wait(slave->observer);
-
-  delete slave->observer;
+  // Stop pinging the slave.
+  dispatch(healthChecker, &SlaveHealthChecker::remove, slave->id);
 
   // TODO(benh): unlink(slave->pid);
 
@@ -2039,26 +2380,47 @@ void Master::removeSlave(Slave* slave)
 }
 
 
-void Master::removeTask(Task* task)
+void Master::removeTask(Task* task, vector<RecoveredResources>* recovered)
 {
   CHECK_NOTNULL(task);
 
-  // Remove from framework.
-  Framework* framework = getFramework(task->framework_id());
-  if (framework != NULL) { // A framework might not be re-connected yet.
-    framework->removeTask(task);
-  }
-
   // Remove from slave.
   Slave* slave = getSlave(task->slave_id());
   CHECK_NOTNULL(slave);
   slave->removeTask(task);
 
   // Tell the allocator about the recovered resources.
-  allocator->resourcesRecovered(
-      task->framework_id(), task->slave_id(), Resources(task->resources()));
+  if (recovered != NULL) {
+    recovered->push_back(RecoveredResources(
+        task->framework_id(), task->slave_id(), Resources(task->resources())));
+  } else {
+    allocator->resourcesRecovered(
+        task->framework_id(), task->slave_id(), Resources(task->resources()));
+  }
 
-  delete task;
+  CHECK(taskBytes.contains(task));
+  stats.taskBytes -= taskBytes[task];
+  taskBytes.erase(task);
+
+  // Remove from framework, which takes ownership of the task to keep
+  // it around as a completed task (see Framework::removeTask). The
+  // oldest completed task gets pushed out into the history (if any).
+  // Note that a zero capacity buffer is both full and empty, the task
+  // goes straight into the history then.
+  Framework* framework = getFramework(task->framework_id());
+  if (framework != NULL) { // A framework might not be re-connected yet.
+    if (history != NULL && framework->completedTasks.capacity() == 0) {
+      history->add(*task);
+    } else if (history != NULL && framework->completedTasks.full()) {
+      history->add(*framework->completedTasks.front());
+    }
+    framework->removeTask(task);
+  } else {
+    if (history != NULL) {
+      history->add(*task);
+    }
+    delete task;
+  }
 }
 
 
@@ -2082,6 +2444,7 @@ void Master::removeOffer(Offer* offer, bool rescind)
 
   // Delete it.
   offers.erase(offer->id());
+  stats.offerBytes -= offer->SpaceUsed();
   delete offer;
 }
 
@@ -2116,19 +2479,24 @@ Offer* Master::getOffer(const OfferID& offerId)
 }
 
 
+// Returns the prefix followed by the integer (zero padded to at least
+// 'width' digits). We avoid using a stream (or stringify) since IDs
+// get generated for every offer.
+static string format(const string& prefix, int64_t value, int width = 0)
+{
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%0*lld", width, (long long) value);
+  return prefix + buffer;
+}
+
+
 // Create a new framework ID. We format the ID as MASTERID-FWID, where
 // MASTERID is the ID of the master (launch date plus fault tolerant ID)
 // and FWID is an increasing integer.
 FrameworkID Master::newFrameworkId()
 {
-  std::ostringstream out;
-
-  out << info.id() << "-" << std::setw(4)
-      << std::setfill('0') << nextFrameworkId++;
-
   FrameworkID frameworkId;
-  frameworkId.set_value(out.str());
-
+  frameworkId.set_value(format(prefix, nextFrameworkId++, 4));
   return frameworkId;
 }
 
@@ -2136,7 +2504,7 @@ FrameworkID Master::newFrameworkId()
 OfferID Master::newOfferId()
 {
   OfferID offerId;
-  offerId.set_value(info.id() + "-" + stringify(nextOfferId++));
+  offerId.set_value(format(prefix, nextOfferId++));
   return offerId;
 }
 
@@ -2144,7 +2512,7 @@ OfferID Master::newOfferId()
 SlaveID Master::newSlaveId()
 {
   SlaveID slaveId;
-  slaveId.set_value(info.id() + "-" + stringify(nextSlaveId++));
+  slaveId.set_value(format(prefix, nextSlaveId++));
   return slaveId;
 }
 
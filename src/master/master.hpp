@@ -24,13 +24,16 @@
 #include <vector>
 
 #include <tr1/functional>
+#include <tr1/memory>
 
 #include <boost/circular_buffer.hpp>
 
+#include <process/clock.hpp>
 #include <process/http.hpp>
 #include <process/process.hpp>
 #include <process/protobuf.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
@@ -61,9 +64,13 @@ namespace allocator {
 
   class Allocator;
 
+  struct AddedSlave;
+  struct RecoveredResources;
+
 }
 
-class SlaveObserver;
+class History;
+class SlaveHealthChecker;
 class WhitelistWatcher;
 
 struct Framework;
@@ -116,6 +123,10 @@ public:
   void frameworkFailoverTimeout(const FrameworkID& frameworkId,
                                 const Time& reregisteredTime);
 
+  // Rescinds any of the offers that are still outstanding, see
+  // --offer_timeout.
+  void offerTimeout(const std::vector<OfferID>& offerIds);
+
   void offer(const FrameworkID& framework,
              const hashmap<SlaveID, Resources>& resources);
 
@@ -145,6 +156,19 @@ protected:
       Slave* slave,
       const std::vector<Task>& tasks);
 
+  // Re-registers up to --slave_reregistration_batch of the queued
+  // slave re-registrations (see Master::reregisterSlave).
+  void admitSlaves();
+
+  // Re-registers a slave, appending it to 'added' (rather than
+  // telling the allocator) if the slave was not already known.
+  void _reregisterSlave(const SlaveID& slaveId,
+                        const UPID& pid,
+                        const SlaveInfo& slaveInfo,
+                        const std::vector<ExecutorInfo>& executorInfos,
+                        const std::vector<Task>& tasks,
+                        std::vector<allocator::AddedSlave>* added);
+
   // Add a framework.
   void addFramework(Framework* framework, bool reregister = false);
 
@@ -163,9 +187,12 @@ protected:
   // Add a slave.
   void addSlave(Slave* slave, bool reregister = false);
 
+  // Re-add a slave, telling the allocator about it directly unless
+  // 'added' is non-NULL, in which case the slave is appended to it.
   void readdSlave(Slave* slave,
 		  const std::vector<ExecutorInfo>& executorInfos,
-		  const std::vector<Task>& tasks);
+		  const std::vector<Task>& tasks,
+		  std::vector<allocator::AddedSlave>* added = NULL);
 
   // Lose all of a slave's tasks and delete the slave object
   void removeSlave(Slave* slave);
@@ -176,8 +203,12 @@ protected:
                        Framework* framework,
                        Slave* slave);
 
-  // Remove a task.
-  void removeTask(Task* task);
+  // Remove a task. The task's resources are appended to 'recovered'
+  // if it is non-NULL (so the caller can hand them to the allocator
+  // in a single batch), otherwise they are recovered immediately.
+  void removeTask(
+      Task* task,
+      std::vector<allocator::RecoveredResources>* recovered = NULL);
 
   // Remove an offer and optionally rescind the offer as well.
   void removeOffer(Offer* offer, bool rescind = false);
@@ -216,6 +247,14 @@ private:
       const Master& master,
       const process::http::Request& request);
 
+  friend Future<process::http::Response> http::json::completedFrameworks(
+      const Master& master,
+      const process::http::Request& request);
+
+  friend Future<process::http::Response> http::json::completedTasks(
+      const Master& master,
+      const process::http::Request& request);
+
   const Flags flags;
 
   UPID leader; // Current leading master.
@@ -224,6 +263,7 @@ private:
 
   allocator::Allocator* allocator;
   WhitelistWatcher* whitelistWatcher;
+  SlaveHealthChecker* healthChecker;
   Files* files;
 
   MasterInfo info;
@@ -235,8 +275,30 @@ private:
 
   hashmap<OfferID, Offer*> offers;
 
+  // Memory counted in 'stats.taskBytes' for each active task. Tasks
+  // grow as they get updated, so the same amount that was counted
+  // when a task was added gets subtracted when it's removed.
+  hashmap<const Task*, size_t> taskBytes;
+
+  // Slave re-registrations waiting to be admitted.
+  struct Reregistration
+  {
+    UPID pid;
+    SlaveInfo slaveInfo;
+    std::vector<ExecutorInfo> executorInfos;
+    std::vector<Task> tasks;
+  };
+
+  hashmap<SlaveID, Reregistration> reregistrations;
+  std::list<SlaveID> admissions; // In the order they arrived.
+
   boost::circular_buffer<std::tr1::shared_ptr<Framework> > completedFrameworks;
 
+  // Where the completed frameworks and tasks pushed out of the
+  // buffers above go, NULL unless --history_dir is set.
+  History* history;
+
+  std::string prefix;      // Prefix of all IDs, i.e., "<master ID>-".
   int64_t nextFrameworkId; // Used to give each framework a unique ID.
   int64_t nextOfferId;     // Used to give each slot offer a unique ID.
   int64_t nextSlaveId;     // Used to give each slave a unique ID.
@@ -248,6 +310,9 @@ private:
     uint64_t invalidStatusUpdates;
     uint64_t validFrameworkMessages;
     uint64_t invalidFrameworkMessages;
+    uint64_t timedOutOffers;
+    uint64_t taskBytes;  // Memory used by the active tasks.
+    uint64_t offerBytes; // Memory used by the outstanding offers.
   } stats;
 
   Time startTime; // Start time used to calculate uptime.
@@ -265,8 +330,7 @@ struct Slave
       info(_info),
       pid(_pid),
       registeredTime(time),
-      lastHeartbeat(time),
-      observer(NULL) {}
+      lastHeartbeat(time) {}
 
   ~Slave() {}
 
@@ -380,28 +444,58 @@ struct Slave
   // Active offers on this slave.
   hashset<Offer*> offers;
 
-  SlaveObserver* observer;
-
 private:
   Slave(const Slave&);              // No copying.
   Slave& operator = (const Slave&); // No assigning.
 };
 
 
+// A histogram of how long a framework held on to its offers before
+// using or declining them (or them being rescinded). Bucket 'i'
+// counts the offers held for at most bound(i), the last bucket
+// counts the rest.
+struct OfferHoldTimes
+{
+  OfferHoldTimes() : counts(OFFER_HOLD_TIME_BUCKETS + 1, 0) {}
+
+  static Duration bound(size_t bucket)
+  {
+    Duration bound = OFFER_HOLD_TIME_RESOLUTION;
+    for (size_t i = 0; i < bucket; i++) {
+      bound = bound * 10;
+    }
+    return bound;
+  }
+
+  void add(const Duration& duration)
+  {
+    size_t bucket = 0;
+    while (bucket < OFFER_HOLD_TIME_BUCKETS && duration > bound(bucket)) {
+      bucket++;
+    }
+    counts[bucket]++;
+  }
+
+  std::vector<uint64_t> counts;
+};
+
+
 // Information about a connected or completed framework.
 struct Framework
 {
   Framework(const FrameworkInfo& _info,
             const FrameworkID& _id,
             const UPID& _pid,
-            const Time& time)
+            const Time& time,
+            size_t maxCompletedTasks)
     : id(_id),
       info(_info),
       pid(_pid),
       active(true),
       registeredTime(time),
       reregisteredTime(time),
-      completedTasks(MAX_COMPLETED_TASKS_PER_FRAMEWORK) {}
+      completedTasks(maxCompletedTasks),
+      completedTasksBytes(0) {}
 
   ~Framework() {}
 
@@ -421,19 +515,33 @@ struct Framework
     resources += task->resources();
   }
 
+  // Takes ownership of the task, it is kept (rather than a copy of
+  // it) in 'completedTasks' until newer completed tasks push it out.
+  // No completed tasks are kept if the capacity is 0.
   void removeTask(Task* task)
   {
     CHECK(tasks.contains(task->task_id()));
 
-    completedTasks.push_back(*task);
     tasks.erase(task->task_id());
     resources -= task->resources();
+
+    if (completedTasks.capacity() == 0) {
+      delete task;
+      return;
+    }
+
+    if (completedTasks.full()) {
+      completedTasksBytes -= completedTasks.front()->SpaceUsed();
+    }
+    completedTasksBytes += task->SpaceUsed();
+    completedTasks.push_back(std::tr1::shared_ptr<const Task>(task));
   }
 
   void addOffer(Offer* offer)
   {
     CHECK(!offers.contains(offer));
     offers.insert(offer);
+    offerTimes[offer->id()] = Clock::now();
     resources += offer->resources();
   }
 
@@ -441,6 +549,8 @@ struct Framework
   {
     CHECK(offers.find(offer) != offers.end());
     offers.erase(offer);
+    offerHoldTimes.add(Clock::now() - offerTimes[offer->id()]);
+    offerTimes.erase(offer->id());
     resources -= offer->resources();
   }
 
@@ -488,10 +598,17 @@ struct Framework
 
   hashmap<TaskID, Task*> tasks;
 
-  boost::circular_buffer<Task> completedTasks;
+  boost::circular_buffer<std::tr1::shared_ptr<const Task> > completedTasks;
+
+  size_t completedTasksBytes; // Memory used by 'completedTasks'.
 
   hashset<Offer*> offers; // Active offers for framework.
 
+  // When each of the active offers was made.
+  hashmap<OfferID, Time> offerTimes;
+
+  OfferHoldTimes offerHoldTimes;
+
   Resources resources; // Total resources (tasks + offers + executors).
 
   hashmap<SlaveID, hashmap<ExecutorID, ExecutorInfo> > executors;
@@ -0,0 +1,200 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include <stout/foreach.hpp>
+
+#include <glog/logging.h>
+
+#include "master/placement.hpp"
+
+using std::make_pair;
+using std::pair;
+using std::set;
+using std::string;
+using std::vector;
+
+
+namespace mesos {
+namespace internal {
+namespace master {
+namespace allocator {
+
+void DefaultPlacement::add(const SlaveID& slaveId, const Resources& total) {}
+
+
+void DefaultPlacement::remove(const SlaveID& slaveId) {}
+
+
+void DefaultPlacement::update(
+    const SlaveID& slaveId,
+    const Resources& available) {}
+
+
+vector<SlaveID> DefaultPlacement::sort(const hashset<SlaveID>& slaveIds)
+{
+  return vector<SlaveID>(slaveIds.begin(), slaveIds.end());
+}
+
+
+bool DefaultPlacement::enough(
+    const hashmap<SlaveID, Resources>& offerable,
+    const SlaveID& slaveId)
+{
+  return false;
+}
+
+
+void FreeCapacityPlacement::add(const SlaveID& slaveId, const Resources& total)
+{
+  CHECK(!totals.contains(slaveId));
+
+  totals[slaveId] = total;
+  shares[slaveId] = 1.0;
+  index.insert(make_pair(1.0, slaveId.value()));
+}
+
+
+void FreeCapacityPlacement::remove(const SlaveID& slaveId)
+{
+  if (totals.contains(slaveId)) {
+    index.erase(make_pair(shares[slaveId], slaveId.value()));
+    totals.erase(slaveId);
+    shares.erase(slaveId);
+  }
+}
+
+
+void FreeCapacityPlacement::update(
+    const SlaveID& slaveId,
+    const Resources& available)
+{
+  CHECK(totals.contains(slaveId));
+
+  // The dominant resource is the one with the largest used share
+  // (as in DRF), so its free share is the smallest of any resource.
+  double share = 1.0;
+
+  foreach (const Resource& resource, totals[slaveId]) {
+    if (resource.type() == Value::SCALAR && resource.scalar().value() > 0) {
+      Value::Scalar none;
+      Value::Scalar free = available.get(resource.name(), none);
+      share = std::min(share, free.value() / resource.scalar().value());
+    }
+  }
+
+  index.erase(make_pair(shares[slaveId], slaveId.value()));
+  shares[slaveId] = share;
+  index.insert(make_pair(share, slaveId.value()));
+}
+
+
+vector<SlaveID> FreeCapacityPlacement::ascending(
+    const hashset<SlaveID>& slaveIds)
+{
+  vector<SlaveID> result;
+  result.reserve(slaveIds.size());
+
+  if (slaveIds.size() == 1) {
+    result.push_back(*slaveIds.begin());
+    return result;
+  }
+
+  // When sorting (almost) all slaves we walk the index rather than
+  // sorting them from scratch.
+  if (slaveIds.size() * 2 >= index.size()) {
+    typedef pair<double, string> Entry;
+    foreach (const Entry& entry, index) {
+      SlaveID slaveId;
+      slaveId.set_value(entry.second);
+      if (slaveIds.contains(slaveId)) {
+        result.push_back(slaveId);
+      }
+    }
+
+    // Include any slaves we don't know about (last).
+    if (result.size() < slaveIds.size()) {
+      foreach (const SlaveID& slaveId, slaveIds) {
+        if (!shares.contains(slaveId)) {
+          result.push_back(slaveId);
+        }
+      }
+    }
+
+    return result;
+  }
+
+  vector<pair<double, string> > entries;
+  entries.reserve(slaveIds.size());
+
+  foreach (const SlaveID& slaveId, slaveIds) {
+    entries.push_back(make_pair(share(slaveId), slaveId.value()));
+  }
+
+  std::sort(entries.begin(), entries.end());
+
+  for (size_t i = 0; i < entries.size(); i++) {
+    SlaveID slaveId;
+    slaveId.set_value(entries[i].second);
+    result.push_back(slaveId);
+  }
+
+  return result;
+}
+
+
+double FreeCapacityPlacement::share(const SlaveID& slaveId)
+{
+  return shares.contains(slaveId) ? shares[slaveId] : 1.0;
+}
+
+
+vector<SlaveID> SpreadPlacement::sort(const hashset<SlaveID>& slaveIds)
+{
+  vector<SlaveID> result = ascending(slaveIds);
+  std::reverse(result.begin(), result.end());
+  return result;
+}
+
+
+bool SpreadPlacement::enough(
+    const hashmap<SlaveID, Resources>& offerable,
+    const SlaveID& slaveId)
+{
+  return false;
+}
+
+
+vector<SlaveID> PackPlacement::sort(const hashset<SlaveID>& slaveIds)
+{
+  return ascending(slaveIds);
+}
+
+
+bool PackPlacement::enough(
+    const hashmap<SlaveID, Resources>& offerable,
+    const SlaveID& slaveId)
+{
+  return !offerable.empty() && share(slaveId) >= 1.0;
+}
+
+} // namespace allocator {
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,159 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PLACEMENT_HPP__
+#define __PLACEMENT_HPP__
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
+
+#include "common/resources.hpp"
+#include "common/type_utils.hpp"
+
+
+namespace mesos {
+namespace internal {
+namespace master {
+namespace allocator {
+
+// Placements implement the logic for determining which slaves'
+// resources get offered to a framework, and in what order. Where the
+// Sorters pick who gets resources next, a Placement picks where they
+// come from, which determines how tasks end up spread across slaves.
+class Placement
+{
+public:
+  virtual ~Placement() {}
+
+  // Adds a slave with the given total resources.
+  virtual void add(const SlaveID& slaveId, const Resources& total) = 0;
+
+  // Removes a slave.
+  virtual void remove(const SlaveID& slaveId) = 0;
+
+  // Specify the resources currently available on the given slave.
+  virtual void update(const SlaveID& slaveId, const Resources& available) = 0;
+
+  // Returns the given slaves in the order that their resources
+  // should be offered, according to this Placement's policy.
+  virtual std::vector<SlaveID> sort(const hashset<SlaveID>& slaveIds) = 0;
+
+  // Returns true if a framework that is already being offered
+  // 'offerable' should not also be offered the resources of
+  // 'slaveId' (nor of any slave after it in the sort order).
+  virtual bool enough(
+      const hashmap<SlaveID, Resources>& offerable,
+      const SlaveID& slaveId) = 0;
+};
+
+
+// Offers every slave in whatever order the allocator has them,
+// without tracking anything (this is the historic behavior).
+class DefaultPlacement : public Placement
+{
+public:
+  virtual ~DefaultPlacement() {}
+
+  virtual void add(const SlaveID& slaveId, const Resources& total);
+
+  virtual void remove(const SlaveID& slaveId);
+
+  virtual void update(const SlaveID& slaveId, const Resources& available);
+
+  virtual std::vector<SlaveID> sort(const hashset<SlaveID>& slaveIds);
+
+  virtual bool enough(
+      const hashmap<SlaveID, Resources>& offerable,
+      const SlaveID& slaveId);
+};
+
+
+// Keeps the slaves ordered by the share of their dominant resource
+// that is free, i.e., 0 when some resource is used up and 1 only
+// when the slave is idle.
+class FreeCapacityPlacement : public Placement
+{
+public:
+  virtual ~FreeCapacityPlacement() {}
+
+  virtual void add(const SlaveID& slaveId, const Resources& total);
+
+  virtual void remove(const SlaveID& slaveId);
+
+  virtual void update(const SlaveID& slaveId, const Resources& available);
+
+protected:
+  // Returns the given slaves ordered by increasing free share.
+  std::vector<SlaveID> ascending(const hashset<SlaveID>& slaveIds);
+
+  // Returns the free share of the slave's dominant resource.
+  double share(const SlaveID& slaveId);
+
+private:
+  // Slaves (by id) sorted by free share.
+  std::set<std::pair<double, std::string> > index;
+
+  // Maps slaves to their total resources and current free share.
+  hashmap<SlaveID, Resources> totals;
+  hashmap<SlaveID, double> shares;
+};
+
+
+// Spreads allocations out by offering the emptiest slaves first and
+// offering every slave.
+class SpreadPlacement : public FreeCapacityPlacement
+{
+public:
+  virtual ~SpreadPlacement() {}
+
+  virtual std::vector<SlaveID> sort(const hashset<SlaveID>& slaveIds);
+
+  virtual bool enough(
+      const hashmap<SlaveID, Resources>& offerable,
+      const SlaveID& slaveId);
+};
+
+
+// Packs allocations onto as few slaves as possible (best-fit by
+// dominant resource) by offering the fullest slaves first and only
+// offering an idle slave to a framework when it is not being offered
+// anything else, and then only one. This leaves idle slaves idle so
+// they can be drained (e.g., for maintenance or to save power).
+class PackPlacement : public FreeCapacityPlacement
+{
+public:
+  virtual ~PackPlacement() {}
+
+  virtual std::vector<SlaveID> sort(const hashset<SlaveID>& slaveIds);
+
+  virtual bool enough(
+      const hashmap<SlaveID, Resources>& offerable,
+      const SlaveID& slaveId);
+};
+
+} // namespace allocator {
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __PLACEMENT_HPP__
@@ -48,6 +48,17 @@ public:
   // Removes a client from the sort, so it won't get allocated to.
   virtual void deactivate(const std::string& client) = 0;
 
+  // Sets the weight of a client (1 by default). A client with a
+  // weight of 2 is entitled to twice the share of a client with a
+  // weight of 1.
+  virtual void weight(const std::string& client, double weight) = 0;
+
+  // Sets the resources guaranteed to a client. Clients whose
+  // allocation doesn't cover their quota are allocated to before
+  // any other client.
+  virtual void quota(const std::string& client,
+                     const Resources& quota) = 0;
+
   // Specify that resources have been allocated to the given client.
   virtual void allocated(const std::string& client,
                          const Resources& resources) = 0;
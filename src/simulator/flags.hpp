@@ -0,0 +1,115 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SIMULATOR_FLAGS_HPP__
+#define __SIMULATOR_FLAGS_HPP__
+
+#include <stout/duration.hpp>
+#include <stout/flags.hpp>
+
+#include "logging/flags.hpp"
+
+namespace mesos {
+namespace internal {
+namespace simulator {
+
+class Flags : public logging::Flags
+{
+public:
+  Flags()
+  {
+    add(&Flags::num_slaves,
+        "num_slaves",
+        "Number of simulated slaves to register with the master",
+        1000);
+
+    add(&Flags::num_frameworks,
+        "num_frameworks",
+        "Number of synthetic schedulers to register with the master",
+        100);
+
+    add(&Flags::slave_cpus,
+        "slave_cpus",
+        "Number of cpus advertised by each simulated slave",
+        16.0);
+
+    add(&Flags::slave_mem,
+        "slave_mem",
+        "Amount of memory (in MB) advertised by each simulated slave",
+        65536.0);
+
+    add(&Flags::task_cpus,
+        "task_cpus",
+        "Number of cpus requested by each synthetic task",
+        1.0);
+
+    add(&Flags::task_mem,
+        "task_mem",
+        "Amount of memory (in MB) requested by each synthetic task",
+        512.0);
+
+    add(&Flags::tasks_per_offer,
+        "tasks_per_offer",
+        "Maximum number of tasks a scheduler launches from a single offer",
+        4);
+
+    add(&Flags::task_duration,
+        "task_duration",
+        "Mean running time of a synthetic task (exponentially distributed)",
+        Seconds(30));
+
+    add(&Flags::decline_probability,
+        "decline_probability",
+        "Probability that a scheduler declines an offer outright",
+        0.1);
+
+    add(&Flags::duration,
+        "duration",
+        "How long to run the simulation before reporting and exiting",
+        Seconds(60));
+
+    add(&Flags::report_interval,
+        "report_interval",
+        "Interval at which intermediate statistics are reported",
+        Seconds(5));
+
+    add(&Flags::seed,
+        "seed",
+        "Seed for the random number generator driving the workload",
+        42);
+  }
+
+  int num_slaves;
+  int num_frameworks;
+  double slave_cpus;
+  double slave_mem;
+  double task_cpus;
+  double task_mem;
+  int tasks_per_offer;
+  Duration task_duration;
+  double decline_probability;
+  Duration duration;
+  Duration report_interval;
+  int seed;
+};
+
+} // namespace simulator {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __SIMULATOR_FLAGS_HPP__
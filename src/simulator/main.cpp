@@ -0,0 +1,193 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <process/dispatch.hpp>
+#include <process/process.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/os.hpp>
+#include <stout/stringify.hpp>
+
+#include "detector/detector.hpp"
+
+#include "files/files.hpp"
+
+#include "logging/logging.hpp"
+
+#include "master/allocator.hpp"
+#include "master/flags.hpp"
+#include "master/master.hpp"
+
+#include "simulator/flags.hpp"
+#include "simulator/simulator.hpp"
+
+using namespace mesos::internal;
+using namespace mesos::internal::simulator;
+
+using mesos::internal::master::Master;
+using mesos::internal::master::allocator::Allocator;
+
+using process::PID;
+using process::UPID;
+
+using std::cerr;
+using std::endl;
+using std::string;
+using std::vector;
+
+
+void usage(const char* argv0, const flags::FlagsBase& flags)
+{
+  cerr << "Usage: " << os::basename(argv0).get() << " [...]" << endl
+       << endl
+       << "Runs a real master (and allocator) against simulated slaves"
+       << endl
+       << "and schedulers within a single process and reports offer"
+       << endl
+       << "throughput, launch latency, allocation time and memory usage."
+       << endl
+       << endl
+       << "Supported options:" << endl
+       << flags.usage();
+}
+
+
+int main(int argc, char** argv)
+{
+  GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+  simulator::Flags flags;
+
+  // The following flags are executable specific (e.g., since we only
+  // have one instance of libprocess per execution, we only want to
+  // advertise the port and ip option once, here).
+  uint16_t port;
+  flags.add(&port, "port", "Port to listen on", 5050);
+
+  Option<string> ip;
+  flags.add(&ip, "ip", "IP address to listen on");
+
+  bool help;
+  flags.add(&help,
+            "help",
+            "Prints this help message",
+            false);
+
+  // Load flags from environment and command line but allow unknown
+  // flags since we might have some master flags as well.
+  Try<Nothing> load = flags.load("MESOS_", argc, argv, true);
+
+  if (load.isError()) {
+    cerr << load.error() << endl;
+    usage(argv[0], flags);
+    exit(1);
+  }
+
+  if (help) {
+    usage(argv[0], flags);
+    exit(1);
+  }
+
+  // Initialize libprocess.
+  os::setenv("LIBPROCESS_PORT", stringify(port));
+
+  if (ip.isSome()) {
+    os::setenv("LIBPROCESS_IP", ip.get());
+  }
+
+  process::initialize("master");
+
+  logging::initialize(argv[0], flags);
+
+  // The master is configured exactly as it would be in production
+  // (i.e., via the environment and the remaining command line flags).
+  master::Flags masterFlags;
+  load = masterFlags.load("MESOS_", argc, argv, true);
+  if (load.isError()) {
+    EXIT(1) << "Failed to load master flags: " << load.error();
+  }
+
+  TimedAllocatorProcess* allocatorProcess = new TimedAllocatorProcess();
+  Allocator* allocator = new Allocator(allocatorProcess);
+
+  Files* files = new Files();
+  Master* master = new Master(allocator, files, masterFlags);
+
+  PID<Master> pid = process::spawn(master);
+
+  Reporter* reporter = new Reporter(flags, allocatorProcess);
+  process::spawn(reporter);
+
+  vector<UPID> pids;
+
+  vector<SimulatedSlave*> slaves;
+  for (int i = 0; i < flags.num_slaves; i++) {
+    SimulatedSlave* slave = new SimulatedSlave(flags, i, reporter->self());
+    slaves.push_back(slave);
+    pids.push_back(process::spawn(slave));
+  }
+
+  vector<SimulatedScheduler*> schedulers;
+  for (int i = 0; i < flags.num_frameworks; i++) {
+    SimulatedScheduler* scheduler =
+      new SimulatedScheduler(flags, i, reporter->self());
+    schedulers.push_back(scheduler);
+    pids.push_back(process::spawn(scheduler));
+  }
+
+  LOG(INFO) << "Simulating " << flags.num_slaves << " slaves and "
+            << flags.num_frameworks << " frameworks for " << flags.duration;
+
+  MasterDetector* detector = new BasicMasterDetector(pid, pids, true);
+
+  os::sleep(flags.duration);
+
+  // Print the summary before tearing anything down; the terminate is
+  // queued behind the summary so waiting ensures it was printed.
+  process::dispatch(reporter, &Reporter::summary);
+  process::terminate(reporter, false);
+  process::wait(reporter);
+
+  foreach (SimulatedScheduler* scheduler, schedulers) {
+    process::terminate(scheduler);
+    process::wait(scheduler);
+    delete scheduler;
+  }
+
+  foreach (SimulatedSlave* slave, slaves) {
+    process::terminate(slave);
+    process::wait(slave);
+    delete slave;
+  }
+
+  process::terminate(master);
+  process::wait(master);
+
+  delete detector;
+  delete master;
+  delete allocator;
+  delete allocatorProcess;
+  delete files;
+  delete reporter;
+
+  return 0;
+}
@@ -0,0 +1,557 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+#include <process/clock.hpp>
+#include <process/delay.hpp>
+#include <process/dispatch.hpp>
+#include <process/id.hpp>
+
+#include <stout/bytes.hpp>
+#include <stout/foreach.hpp>
+#include <stout/os.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
+
+#include "common/protobuf_utils.hpp"
+#include "common/resources.hpp"
+
+#include "simulator/simulator.hpp"
+
+using process::Clock;
+using process::PID;
+using process::Time;
+using process::UPID;
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace simulator {
+
+// Returns a uniformly distributed value in [0, 1).
+static double uniform(unsigned int* seed)
+{
+  return rand_r(seed) / (RAND_MAX + 1.0);
+}
+
+
+// Returns an exponentially distributed duration with the given mean.
+static Duration exponential(unsigned int* seed, const Duration& mean)
+{
+  return Seconds(-mean.secs() * ::log(1.0 - uniform(seed)));
+}
+
+
+Reporter::Reporter(
+    const Flags& _flags,
+    TimedAllocatorProcess* _allocator)
+  : ProcessBase("simulator-reporter"),
+    flags(_flags),
+    allocator(_allocator) {}
+
+
+void Reporter::initialize()
+{
+  started = last = Clock::now();
+
+  dispatch(PID<TimedAllocatorProcess>(allocator),
+           &TimedAllocatorProcess::report,
+           self());
+
+  delay(flags.report_interval, self(), &Reporter::report);
+}
+
+
+void Reporter::offered(int offers)
+{
+  interval.offers += offers;
+  total.offers += offers;
+}
+
+
+void Reporter::declined(int offers)
+{
+  interval.declines += offers;
+  total.declines += offers;
+}
+
+
+void Reporter::launched(int tasks)
+{
+  interval.launches += tasks;
+  total.launches += tasks;
+}
+
+
+void Reporter::running(const Duration& latency)
+{
+  interval.latencies.add(latency);
+  total.latencies.add(latency);
+}
+
+
+void Reporter::registered()
+{
+  interval.registrations++;
+  total.registrations++;
+}
+
+
+void Reporter::allocated(const Duration& duration)
+{
+  interval.allocations.add(duration);
+  total.allocations.add(duration);
+}
+
+
+void Reporter::report()
+{
+  Time now = Clock::now();
+  print("interval", interval, now - last);
+  interval = Statistics();
+  last = now;
+
+  delay(flags.report_interval, self(), &Reporter::report);
+}
+
+
+void Reporter::summary()
+{
+  print("total", total, Clock::now() - started);
+}
+
+
+void Reporter::print(
+    const string& label,
+    const Statistics& statistics,
+    const Duration& elapsed)
+{
+  // The simulated components all live within this process, so the
+  // resident set size is an upper bound on the master's footprint.
+  Option<Bytes> rss = None();
+  Try<os::Process> process = os::process(getpid());
+  if (process.isSome()) {
+    rss = process.get().rss;
+  }
+
+  const double secs = std::max(elapsed.secs(), 1e-9);
+
+  cout << std::fixed << std::setprecision(2)
+       << "[" << label << "] "
+       << "elapsed=" << elapsed.secs() << "s "
+       << "slaves=" << statistics.registrations << " "
+       << "offers/s=" << statistics.offers / secs << " "
+       << "declined=" << statistics.declines << " "
+       << "launched=" << statistics.launches << " "
+       << "launch_latency_ms(mean/p50/p99)="
+       << statistics.latencies.mean() << "/"
+       << statistics.latencies.percentile(0.5) << "/"
+       << statistics.latencies.percentile(0.99) << " "
+       << "allocation_ms(mean/max)="
+       << statistics.allocations.mean() << "/"
+       << statistics.allocations.percentile(1.0) << " "
+       << "rss=" << (rss.isSome() ? stringify(rss.get()) : "unknown")
+       << endl;
+}
+
+
+double Reporter::Samples::mean() const
+{
+  if (values.empty()) {
+    return 0.0;
+  }
+
+  double sum = 0.0;
+  foreach (double value, values) {
+    sum += value;
+  }
+  return sum / values.size();
+}
+
+
+double Reporter::Samples::percentile(double p) const
+{
+  if (values.empty()) {
+    return 0.0;
+  }
+
+  vector<double> sorted = values;
+  std::sort(sorted.begin(), sorted.end());
+
+  size_t index = static_cast<size_t>(p * (sorted.size() - 1));
+  return sorted[index];
+}
+
+
+void TimedAllocatorProcess::report(const PID<Reporter>& _reporter)
+{
+  reporter = _reporter;
+}
+
+
+void TimedAllocatorProcess::batch()
+{
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  master::allocator::HierarchicalDRFAllocatorProcess::batch();
+
+  if (reporter.isSome()) {
+    dispatch(reporter.get(), &Reporter::allocated, stopwatch.elapsed());
+  }
+}
+
+
+SimulatedSlave::SimulatedSlave(
+    const Flags& _flags,
+    int index,
+    const PID<Reporter>& _reporter)
+  : ProcessBase(process::ID::generate("simulated-slave")),
+    flags(_flags),
+    reporter(_reporter),
+    seed(flags.seed + index)
+{
+  info.set_hostname("simulated-slave-" + stringify(index));
+  info.set_webui_hostname(info.hostname());
+  info.mutable_resources()->MergeFrom(
+      Resources::parse(
+          "cpus:" + stringify(flags.slave_cpus) +
+          ";mem:" + stringify(flags.slave_mem)));
+}
+
+
+void SimulatedSlave::initialize()
+{
+  install<NewMasterDetectedMessage>(
+      &SimulatedSlave::newMasterDetected,
+      &NewMasterDetectedMessage::pid);
+
+  install<SlaveRegisteredMessage>(
+      &SimulatedSlave::registered,
+      &SlaveRegisteredMessage::slave_id);
+
+  install<RunTaskMessage>(
+      &SimulatedSlave::runTask,
+      &RunTaskMessage::framework_id,
+      &RunTaskMessage::task);
+
+  install<KillTaskMessage>(
+      &SimulatedSlave::killTask,
+      &KillTaskMessage::framework_id,
+      &KillTaskMessage::task_id);
+
+  install<ShutdownFrameworkMessage>(
+      &SimulatedSlave::shutdownFramework,
+      &ShutdownFrameworkMessage::framework_id);
+
+  // Acknowledgements need no handling since updates are never resent.
+  install<StatusUpdateAcknowledgementMessage>(&SimulatedSlave::noop);
+
+  install("PING", &SimulatedSlave::ping);
+}
+
+
+void SimulatedSlave::newMasterDetected(const UPID& pid)
+{
+  master = pid;
+  id.Clear();
+  doRegistration();
+}
+
+
+void SimulatedSlave::doRegistration()
+{
+  if (id.has_value() || !master) {
+    return;
+  }
+
+  RegisterSlaveMessage message;
+  message.mutable_slave()->MergeFrom(info);
+  send(master, message);
+
+  delay(Seconds(1), self(), &SimulatedSlave::doRegistration);
+}
+
+
+void SimulatedSlave::registered(const SlaveID& slaveId)
+{
+  if (id.has_value()) {
+    return; // Duplicate acknowledgement from a retried registration.
+  }
+
+  id = slaveId;
+  info.mutable_id()->MergeFrom(id);
+
+  dispatch(reporter, &Reporter::registered);
+}
+
+
+void SimulatedSlave::ping(const UPID& from, const string& body)
+{
+  send(from, "PONG");
+}
+
+
+void SimulatedSlave::runTask(
+    const FrameworkID& frameworkId,
+    const TaskInfo& task)
+{
+  tasks[frameworkId].insert(task.task_id());
+
+  update(frameworkId, task.task_id(), TASK_RUNNING);
+
+  delay(exponential(&seed, flags.task_duration),
+        self(),
+        &SimulatedSlave::finish,
+        frameworkId,
+        task.task_id());
+}
+
+
+void SimulatedSlave::killTask(
+    const FrameworkID& frameworkId,
+    const TaskID& taskId)
+{
+  if (tasks.contains(frameworkId) && tasks[frameworkId].contains(taskId)) {
+    tasks[frameworkId].erase(taskId);
+    update(frameworkId, taskId, TASK_KILLED);
+  }
+}
+
+
+void SimulatedSlave::shutdownFramework(const FrameworkID& frameworkId)
+{
+  tasks.erase(frameworkId);
+}
+
+
+void SimulatedSlave::finish(
+    const FrameworkID& frameworkId,
+    const TaskID& taskId)
+{
+  // The task might have been killed or its framework shut down.
+  if (tasks.contains(frameworkId) && tasks[frameworkId].contains(taskId)) {
+    tasks[frameworkId].erase(taskId);
+    update(frameworkId, taskId, TASK_FINISHED);
+  }
+}
+
+
+void SimulatedSlave::update(
+    const FrameworkID& frameworkId,
+    const TaskID& taskId,
+    const TaskState& state)
+{
+  StatusUpdateMessage message;
+  message.mutable_update()->MergeFrom(
+      protobuf::createStatusUpdate(frameworkId, id, taskId, state));
+  message.set_pid(self());
+  send(master, message);
+}
+
+
+SimulatedScheduler::SimulatedScheduler(
+    const Flags& _flags,
+    int index,
+    const PID<Reporter>& _reporter)
+  : ProcessBase(process::ID::generate("simulated-scheduler")),
+    flags(_flags),
+    reporter(_reporter),
+    tasks(0),
+    seed(flags.seed + flags.num_slaves + index)
+{
+  info.set_user("simulator");
+  info.set_name("simulated-framework-" + stringify(index));
+}
+
+
+void SimulatedScheduler::initialize()
+{
+  install<NewMasterDetectedMessage>(
+      &SimulatedScheduler::newMasterDetected,
+      &NewMasterDetectedMessage::pid);
+
+  install<FrameworkRegisteredMessage>(
+      &SimulatedScheduler::registered,
+      &FrameworkRegisteredMessage::framework_id);
+
+  install<ResourceOffersMessage>(
+      &SimulatedScheduler::resourceOffers,
+      &ResourceOffersMessage::offers);
+
+  install<RescindResourceOfferMessage>(
+      &SimulatedScheduler::rescindOffer,
+      &RescindResourceOfferMessage::offer_id);
+
+  install<StatusUpdateMessage>(
+      &SimulatedScheduler::statusUpdate,
+      &StatusUpdateMessage::update,
+      &StatusUpdateMessage::pid);
+
+  install<LostSlaveMessage>(
+      &SimulatedScheduler::lostSlave,
+      &LostSlaveMessage::slave_id);
+
+  install<FrameworkErrorMessage>(
+      &SimulatedScheduler::error,
+      &FrameworkErrorMessage::message);
+}
+
+
+void SimulatedScheduler::newMasterDetected(const UPID& pid)
+{
+  master = pid;
+  doRegistration();
+}
+
+
+void SimulatedScheduler::doRegistration()
+{
+  if (id.has_value() || !master) {
+    return;
+  }
+
+  RegisterFrameworkMessage message;
+  message.mutable_framework()->MergeFrom(info);
+  send(master, message);
+
+  delay(Seconds(1), self(), &SimulatedScheduler::doRegistration);
+}
+
+
+void SimulatedScheduler::registered(const FrameworkID& frameworkId)
+{
+  id = frameworkId;
+  info.mutable_id()->MergeFrom(id);
+}
+
+
+void SimulatedScheduler::resourceOffers(const vector<Offer>& offers)
+{
+  dispatch(reporter, &Reporter::offered, (int) offers.size());
+
+  int declined = 0;
+  int launched = 0;
+
+  foreach (const Offer& offer, offers) {
+    LaunchTasksMessage message;
+    message.mutable_framework_id()->MergeFrom(id);
+    message.mutable_offer_id()->MergeFrom(offer.id());
+    message.mutable_filters();
+
+    if (uniform(&seed) < flags.decline_probability) {
+      declined++;
+      send(master, message);
+      continue;
+    }
+
+    Value::Scalar none;
+    double cpus = Resources(offer.resources()).get("cpus", none).value();
+    double mem = Resources(offer.resources()).get("mem", none).value();
+
+    Resources resources = Resources::parse(
+        "cpus:" + stringify(flags.task_cpus) +
+        ";mem:" + stringify(flags.task_mem));
+
+    for (int i = 0; i < flags.tasks_per_offer; i++) {
+      if (cpus < flags.task_cpus || mem < flags.task_mem) {
+        break;
+      }
+
+      cpus -= flags.task_cpus;
+      mem -= flags.task_mem;
+
+      TaskInfo* task = message.add_tasks();
+      task->set_name(info.name() + "-" + stringify(tasks));
+      task->mutable_task_id()->set_value(stringify(tasks++));
+      task->mutable_slave_id()->MergeFrom(offer.slave_id());
+      task->mutable_resources()->MergeFrom(resources);
+      task->mutable_command()->set_value("true");
+
+      this->launched[task->task_id()] = Clock::now();
+    }
+
+    if (message.tasks_size() == 0) {
+      declined++;
+    }
+
+    launched += message.tasks_size();
+
+    send(master, message);
+  }
+
+  if (declined > 0) {
+    dispatch(reporter, &Reporter::declined, declined);
+  }
+
+  if (launched > 0) {
+    dispatch(reporter, &Reporter::launched, launched);
+  }
+}
+
+
+void SimulatedScheduler::statusUpdate(
+    const StatusUpdate& update,
+    const UPID& pid)
+{
+  const TaskID& taskId = update.status().task_id();
+
+  // Stop tracking a task once it's running, or once it has reached a
+  // terminal state without ever running (e.g., TASK_LOST).
+  if (launched.contains(taskId)) {
+    const TaskState& state = update.status().state();
+    if (state == TASK_RUNNING) {
+      dispatch(reporter,
+               &Reporter::running,
+               Clock::now() - launched[taskId]);
+      launched.erase(taskId);
+    } else if (protobuf::isTerminalState(state)) {
+      launched.erase(taskId);
+    }
+  }
+
+  // Updates generated by the master (e.g., TASK_LOST) have no pid.
+  if (pid) {
+    StatusUpdateAcknowledgementMessage message;
+    message.mutable_framework_id()->MergeFrom(id);
+    message.mutable_slave_id()->MergeFrom(update.slave_id());
+    message.mutable_task_id()->MergeFrom(taskId);
+    message.set_uuid(update.uuid());
+    send(pid, message);
+  }
+}
+
+
+void SimulatedScheduler::error(const string& message)
+{
+  LOG(ERROR) << "Framework " << info.name() << " received error: " << message;
+}
+
+} // namespace simulator {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,224 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SIMULATOR_SIMULATOR_HPP__
+#define __SIMULATOR_SIMULATOR_HPP__
+
+#include <string>
+#include <vector>
+
+#include <mesos/mesos.hpp>
+
+#include <process/pid.hpp>
+#include <process/process.hpp>
+#include <process/protobuf.hpp>
+#include <process/time.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
+#include <stout/option.hpp>
+
+#include "common/type_utils.hpp"
+
+#include "master/hierarchical_allocator_process.hpp"
+
+#include "messages/messages.hpp"
+
+#include "simulator/flags.hpp"
+
+namespace mesos {
+namespace internal {
+namespace simulator {
+
+// Forward declaration.
+class TimedAllocatorProcess;
+
+
+// Aggregates the measurements taken by the simulated slaves and
+// schedulers and periodically prints them. All measurements are
+// dispatched here so that the simulated components never need to
+// synchronize with one another.
+class Reporter : public process::Process<Reporter>
+{
+public:
+  Reporter(const Flags& flags, TimedAllocatorProcess* allocator);
+
+  // Invoked by the schedulers.
+  void offered(int offers);
+  void declined(int offers);
+  void launched(int tasks);
+  void running(const Duration& latency);
+
+  // Invoked by the slaves.
+  void registered();
+
+  // Invoked by the allocator.
+  void allocated(const Duration& duration);
+
+  // Prints the statistics accumulated since the simulation started.
+  void summary();
+
+protected:
+  virtual void initialize();
+
+private:
+  // Prints (and resets) the statistics for the last interval.
+  void report();
+
+  // Simple accumulator of latency samples (in milliseconds).
+  struct Samples
+  {
+    void add(const Duration& duration) { values.push_back(duration.ms()); }
+    void clear() { values.clear(); }
+    size_t count() const { return values.size(); }
+    double mean() const;
+    double percentile(double p) const;
+
+    std::vector<double> values;
+  };
+
+  struct Statistics
+  {
+    Statistics()
+      : offers(0), declines(0), launches(0), registrations(0) {}
+
+    uint64_t offers;
+    uint64_t declines;
+    uint64_t launches;
+    uint64_t registrations;
+    Samples latencies;
+    Samples allocations;
+  };
+
+  void print(const std::string& label,
+             const Statistics& statistics,
+             const Duration& elapsed);
+
+  const Flags flags;
+  TimedAllocatorProcess* allocator;
+
+  process::Time started;
+  process::Time last;
+
+  Statistics interval;
+  Statistics total;
+};
+
+
+// The hierarchical DRF allocator extended to report how long each of
+// its periodic batch allocations takes. It never allocates on its own
+// so that the measurements don't change the simulated workload.
+class TimedAllocatorProcess
+  : public master::allocator::HierarchicalDRFAllocatorProcess
+{
+public:
+  // Starts reporting the duration of every batch allocation.
+  void report(const process::PID<Reporter>& reporter);
+
+protected:
+  virtual void batch();
+
+private:
+  Option<process::PID<Reporter> > reporter;
+};
+
+
+// A slave which registers with the master, answers health checks and
+// "runs" tasks by sending the appropriate status updates after a
+// sampled running time, without launching any executors.
+class SimulatedSlave : public ProtobufProcess<SimulatedSlave>
+{
+public:
+  SimulatedSlave(const Flags& flags,
+                 int index,
+                 const process::PID<Reporter>& reporter);
+
+protected:
+  virtual void initialize();
+
+private:
+  void newMasterDetected(const process::UPID& pid);
+  void doRegistration();
+  void registered(const SlaveID& slaveId);
+  void ping(const process::UPID& from, const std::string& body);
+  void runTask(const FrameworkID& frameworkId, const TaskInfo& task);
+  void killTask(const FrameworkID& frameworkId, const TaskID& taskId);
+  void shutdownFramework(const FrameworkID& frameworkId);
+  void finish(const FrameworkID& frameworkId, const TaskID& taskId);
+  void update(const FrameworkID& frameworkId,
+              const TaskID& taskId,
+              const TaskState& state);
+  void noop() {}
+
+  const Flags flags;
+  const process::PID<Reporter> reporter;
+
+  SlaveInfo info;
+  SlaveID id;
+  process::UPID master;
+
+  // Tasks currently "running" on this slave.
+  hashmap<FrameworkID, hashset<TaskID> > tasks;
+
+  unsigned int seed;
+};
+
+
+// A scheduler which registers a framework with the master, launches
+// fixed size tasks on (or declines) the offers it receives and
+// measures the time until each task reports TASK_RUNNING.
+class SimulatedScheduler : public ProtobufProcess<SimulatedScheduler>
+{
+public:
+  SimulatedScheduler(const Flags& flags,
+                     int index,
+                     const process::PID<Reporter>& reporter);
+
+protected:
+  virtual void initialize();
+
+private:
+  void newMasterDetected(const process::UPID& pid);
+  void doRegistration();
+  void registered(const FrameworkID& frameworkId);
+  void resourceOffers(const std::vector<Offer>& offers);
+  void rescindOffer(const OfferID& offerId) {}
+  void statusUpdate(const StatusUpdate& update, const process::UPID& pid);
+  void lostSlave(const SlaveID& slaveId) {}
+  void error(const std::string& message);
+
+  const Flags flags;
+  const process::PID<Reporter> reporter;
+
+  FrameworkInfo info;
+  FrameworkID id;
+  process::UPID master;
+
+  // Launch times of the tasks which are not yet running.
+  hashmap<TaskID, process::Time> launched;
+
+  uint64_t tasks;
+  unsigned int seed;
+};
+
+} // namespace simulator {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __SIMULATOR_SIMULATOR_HPP__
@@ -38,6 +38,9 @@ extern const Duration EXECUTOR_REGISTRATION_TIMEOUT;
 extern const Duration EXECUTOR_SHUTDOWN_GRACE_PERIOD;
 extern const Duration EXECUTOR_REREGISTER_TIMEOUT;
 extern const Duration STATUS_UPDATE_RETRY_INTERVAL;
+extern const Duration REGISTRATION_BACKOFF_FACTOR;
+extern const Duration REGISTRATION_RETRY_INTERVAL_MIN;
+extern const Duration REGISTRATION_RETRY_INTERVAL_MAX;
 extern const Duration GC_DELAY;
 extern const Duration DISK_WATCH_INTERVAL;
 extern const Duration RESOURCE_MONITORING_INTERVAL;
@@ -103,6 +103,15 @@ public:
         "the available disk usage.",
         GC_DELAY);
 
+    add(&Flags::registration_backoff_factor,
+        "registration_backoff_factor",
+        "Slave waits a random amount of time between 0 and this\n"
+        "(e.g., 1secs, 500ms, etc) before (re-)registering with a\n"
+        "new master, so that after a master failover not all\n"
+        "slaves hit the new master at once. Registration is then\n"
+        "retried with (randomized) exponential backoff",
+        REGISTRATION_BACKOFF_FACTOR);
+
     add(&Flags::disk_watch_interval,
         "disk_watch_interval",
         "Periodic time interval (e.g., 10secs, 2mins, etc)\n"
@@ -178,6 +187,7 @@ public:
   Duration executor_registration_timeout;
   Duration executor_shutdown_grace_period;
   Duration gc_delay;
+  Duration registration_backoff_factor;
   Duration disk_watch_interval;
   Duration resource_monitoring_interval;
   bool checkpoint;
@@ -18,10 +18,13 @@
 
 #include <list>
 
+#include <process/async.hpp>
+#include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/dispatch.hpp>
 
 #include <stout/foreach.hpp>
+#include <stout/lambda.hpp>
 #include <stout/os.hpp>
 
 #include "logging/logging.hpp"
@@ -79,6 +82,29 @@ Future<Nothing> GarbageCollectorProcess::schedule(
 }
 
 
+void GarbageCollectorProcess::_remove(
+    const list<PathInfo>& infos,
+    const Future<list<Try<Nothing> > >& results)
+{
+  CHECK(results.isReady());
+  CHECK_EQ(infos.size(), results.get().size());
+
+  list<Try<Nothing> >::const_iterator rmdir = results.get().begin();
+
+  foreach (const PathInfo& info, infos) {
+    if (rmdir->isError()) {
+      LOG(WARNING) << "Failed to delete '" << info.path << "': "
+                   << rmdir->error();
+      info.promise->fail(rmdir->error());
+    } else {
+      LOG(INFO) << "Deleted '" << info.path << "'";
+      info.promise->set(rmdir->get());
+    }
+    ++rmdir;
+  }
+}
+
+
 bool GarbageCollectorProcess::unschedule(const string& path)
 {
   LOG(INFO) << "Unscheduling '" << path << "' for removal";
@@ -124,30 +150,36 @@ void GarbageCollectorProcess::reset()
 }
 
 
-void GarbageCollectorProcess::remove(const Timeout& removalTime)
+// Removes each of the paths, returning the results in order.
+static list<Try<Nothing> > rmdirs(const list<string>& paths)
 {
-  // TODO(bmahler): Other dispatches can block waiting for a removal
-  // operation. To fix this, the removal operation can be done
-  // asynchronously in another thread.
-  if (paths.count(removalTime) > 0) {
-    foreach (const PathInfo& info, paths.get(removalTime)) {
-      LOG(INFO) << "Deleting " << info.path;
+  list<Try<Nothing> > results;
+  foreach (const string& path, paths) {
+    results.push_back(os::rmdir(path));
+  }
+  return results;
+}
 
-      Try<Nothing> rmdir = os::rmdir(info.path);
 
-      if (rmdir.isError()) {
-        LOG(WARNING) << "Failed to delete '" << info.path << "': "
-                     << rmdir.error();
-        info.promise->fail(rmdir.error());
-      } else {
-        LOG(INFO) << "Deleted '" << info.path << "'";
-        info.promise->set(rmdir.get());
-      }
+void GarbageCollectorProcess::remove(const Timeout& removalTime)
+{
+  if (paths.count(removalTime) > 0) {
+    const list<PathInfo>& infos = paths.get(removalTime);
 
+    list<string> _paths;
+    foreach (const PathInfo& info, infos) {
+      LOG(INFO) << "Deleting " << info.path;
+      _paths.push_back(info.path);
       timeouts.erase(info.path);
     }
 
     paths.remove(removalTime);
+
+    // Delete the paths on the (low priority) blocking threads so
+    // that deleting large directories doesn't block other dispatches
+    // to this process (or the threads that run processes).
+    AsyncExecutor(ASYNC_LOW).execute(&rmdirs, _paths)
+      .onAny(defer(self(), &Self::_remove, infos, lambda::_1));
   } else {
     // This occurs when either:
     //   1. The path(s) has already been removed (e.g. by prune()).
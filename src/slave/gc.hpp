@@ -19,6 +19,7 @@
 #ifndef __SLAVE_GC_HPP__
 #define __SLAVE_GC_HPP__
 
+#include <list>
 #include <string>
 #include <vector>
 
@@ -34,6 +35,11 @@
 #include <stout/owned.hpp>
 #include <stout/try.hpp>
 
+// Forward declarations (for befriending, see GarbageCollectorProcess).
+class GarbageCollectorIntegrationTest;
+template <typename T> class SlaveRecoveryTest;
+
+
 namespace mesos {
 namespace internal {
 namespace slave {
@@ -94,9 +100,9 @@ public:
   void prune(const Duration& d);
 
 private:
-  void reset();
-
-  void remove(const process::Timeout& removalTime);
+  // The tests wait for '_remove' to be dispatched.
+  friend class ::GarbageCollectorIntegrationTest;
+  template <typename T> friend class ::SlaveRecoveryTest;
 
   struct PathInfo
   {
@@ -113,6 +119,15 @@ private:
     const Owned<process::Promise<Nothing> > promise;
   };
 
+  // Invoked once the paths have been deleted (see remove).
+  void _remove(
+      const std::list<PathInfo>& infos,
+      const process::Future<std::list<Try<Nothing> > >& results);
+
+  void reset();
+
+  void remove(const process::Timeout& removalTime);
+
   // Store all the timeouts and corresponding paths to delete.
   // NOTE: We are using Multimap here instead of Multihashmap, because
   // we need the keys of the map (deletion time) to be sorted.
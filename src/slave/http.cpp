@@ -35,6 +35,8 @@
 #include "common/resources.hpp"
 #include "common/type_utils.hpp"
 
+#include "logging/logging.hpp"
+
 #include "slave/http.hpp"
 #include "slave/slave.hpp"
 
@@ -292,6 +294,7 @@ Future<Response> stats(
   object.values["lost_tasks"] = slave.stats.tasks[TASK_LOST];
   object.values["valid_status_updates"] = slave.stats.validStatusUpdates;
   object.values["invalid_status_updates"] = slave.stats.invalidStatusUpdates;
+  object.values["dropped_log_messages"] = logging::dropped();
 
   return OK(object, request.query.get("jsonp"));
 }
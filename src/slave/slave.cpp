@@ -18,6 +18,7 @@
 
 #include <errno.h>
 #include <signal.h>
+#include <stdlib.h> // For rand_r().
 
 #include <algorithm>
 #include <iomanip>
@@ -26,6 +27,7 @@
 #include <string>
 #include <vector>
 
+#include <process/async.hpp>
 #include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/dispatch.hpp>
@@ -228,6 +230,10 @@ void Slave::initialize()
 
   string hostname = result.get();
 
+  // Seed the registration backoff differently on every slave so that
+  // slaves don't all pick the same (random) delays.
+  seed = std::tr1::hash<string>()(hostname + UUID::random().toBytes());
+
   // Check and see if we have a different public DNS name. Normally
   // this is our hostname, but on EC2 we look for the MESOS_PUBLIC_DNS
   // environment variable. This allows the master to display our
@@ -656,6 +662,25 @@ void Slave::reregistered(const SlaveID& slaveId)
 
 
 void Slave::doReliableRegistration()
+{
+  // Wait a random amount of time (up to the backoff factor) so that
+  // after a master failover the slaves spread out their
+  // re-registrations rather than all hitting the new master at once.
+  const Duration backoff = flags.registration_backoff_factor *
+    ((double) rand_r(&seed) / RAND_MAX);
+
+  if (backoff == Duration::zero()) {
+    _doReliableRegistration(REGISTRATION_RETRY_INTERVAL_MIN);
+  } else {
+    delay(backoff,
+          self(),
+          &Slave::_doReliableRegistration,
+          REGISTRATION_RETRY_INTERVAL_MIN);
+  }
+}
+
+
+void Slave::_doReliableRegistration(const Duration& interval)
 {
   if (!master) {
     LOG(INFO) << "Skipping registration because no master present";
@@ -716,8 +741,17 @@ void Slave::doReliableRegistration()
     send(master, message);
   }
 
-  // Retry registration if necessary.
-  delay(Seconds(1), self(), &Slave::doReliableRegistration);
+  // Retry registration if necessary, doubling the interval each
+  // time (up to REGISTRATION_RETRY_INTERVAL_MAX). Each retry happens
+  // at a random point in the latter half of the interval so that
+  // slaves don't retry in lockstep.
+  const Duration retry =
+    interval / 2 + interval / 2 * ((double) rand_r(&seed) / RAND_MAX);
+
+  delay(retry,
+        self(),
+        &Slave::_doReliableRegistration,
+        std::min(interval * 2, REGISTRATION_RETRY_INTERVAL_MAX));
 }
 
 
@@ -1461,16 +1495,15 @@ void Slave::registerExecutor(
       reply(ShutdownExecutorMessage());
       break;
     case Executor::REGISTERING: {
-      executor->state = Executor::RUNNING;
-
       // Save the pid for the executor.
       executor->pid = from;
 
       if (framework->info.checkpoint()) {
-        // TODO(vinod): This checkpointing should be done
-        // asynchronously as it is in the fast path of the slave!
-
-        // Checkpoint the libprocess pid.
+        // Checkpoint the libprocess pid before completing the
+        // registration. This is done on the (high priority) blocking
+        // threads since it's in the fast path of the slave, and the
+        // executor stays REGISTERING (i.e., tasks keep getting
+        // queued) in the mean time.
         string path = paths::getLibprocessPidPath(
             paths::getMetaRootDir(flags.work_dir),
             info.id(),
@@ -1478,51 +1511,20 @@ void Slave::registerExecutor(
             executor->id,
             executor->uuid);
 
-        CHECK_SOME(state::checkpoint(path, executor->pid));
-      }
-
-      // First account for the tasks we're about to start.
-      foreachvalue (const TaskInfo& task, executor->queuedTasks) {
-        // Add the task to the executor.
-        executor->addTask(task);
-      }
+        Try<Nothing> (*checkpoint)(const string&, const string&) =
+          &state::checkpoint;
 
-      // Now that the executor is up, set its resource limits
-      // including the currently queued tasks.
-      // TODO(Charles Reiss): We don't actually have a guarantee
-      // that this will be delivered or (where necessary) acted on
-      // before the executor gets its RunTaskMessages.
-      dispatch(isolator,
-               &Isolator::resourcesChanged,
-               framework->id,
-               executor->id,
-               executor->resources);
-
-      // Tell executor it's registered and give it any queued tasks.
-      ExecutorRegisteredMessage message;
-      message.mutable_executor_info()->MergeFrom(executor->info);
-      message.mutable_framework_id()->MergeFrom(framework->id);
-      message.mutable_framework_info()->MergeFrom(framework->info);
-      message.mutable_slave_id()->MergeFrom(info.id());
-      message.mutable_slave_info()->MergeFrom(info);
-      send(executor->pid, message);
-
-      foreachvalue (const TaskInfo& task, executor->queuedTasks) {
-        LOG(INFO) << "Flushing queued task " << task.task_id()
-                  << " for executor '" << executor->id << "'"
-                  << " of framework " << framework->id;
-
-        stats.tasks[TASK_STAGING]++;
-
-        RunTaskMessage message;
-        message.mutable_framework_id()->MergeFrom(framework->id);
-        message.mutable_framework()->MergeFrom(framework->info);
-        message.set_pid(framework->pid);
-        message.mutable_task()->MergeFrom(task);
-        send(executor->pid, message);
+        AsyncExecutor(ASYNC_HIGH).execute(checkpoint, path, string(from))
+          .onAny(defer(self(),
+                       &Self::_registerExecutor,
+                       frameworkId,
+                       executorId,
+                       from,
+                       lambda::_1));
+      } else {
+        _registerExecutor(
+            frameworkId, executorId, from, Try<Nothing>::some(Nothing()));
       }
-
-      executor->queuedTasks.clear();
       break;
     }
     default:
@@ -1534,6 +1536,88 @@ void Slave::registerExecutor(
 }
 
 
+void Slave::_registerExecutor(
+    const FrameworkID& frameworkId,
+    const ExecutorID& executorId,
+    const UPID& pid,
+    const Future<Try<Nothing> >& checkpoint)
+{
+  if (!checkpoint.isReady()) {
+    LOG(FATAL) << "Failed to checkpoint the pid of executor '" << executorId
+               << "' of framework " << frameworkId << ": "
+               << (checkpoint.isFailed() ? checkpoint.failure() : "discarded");
+  }
+
+  CHECK_SOME(checkpoint.get());
+
+  Framework* framework = getFramework(frameworkId);
+  if (framework == NULL) {
+    LOG(WARNING) << "Ignoring registration of executor '" << executorId
+                 << "' because the framework " << frameworkId
+                 << " no longer exists";
+    return;
+  }
+
+  Executor* executor = framework->getExecutor(executorId);
+
+  // The executor might have been shut down (or even re-launched)
+  // while its pid was getting checkpointed.
+  if (executor == NULL ||
+      executor->state != Executor::REGISTERING ||
+      executor->pid != pid) {
+    LOG(WARNING) << "Ignoring registration of executor '" << executorId
+                 << "' of framework " << frameworkId
+                 << " because it is no longer registering";
+    return;
+  }
+
+  executor->state = Executor::RUNNING;
+
+  // First account for the tasks we're about to start.
+  foreachvalue (const TaskInfo& task, executor->queuedTasks) {
+    // Add the task to the executor.
+    executor->addTask(task);
+  }
+
+  // Now that the executor is up, set its resource limits
+  // including the currently queued tasks.
+  // TODO(Charles Reiss): We don't actually have a guarantee
+  // that this will be delivered or (where necessary) acted on
+  // before the executor gets its RunTaskMessages.
+  dispatch(isolator,
+           &Isolator::resourcesChanged,
+           framework->id,
+           executor->id,
+           executor->resources);
+
+  // Tell executor it's registered and give it any queued tasks.
+  ExecutorRegisteredMessage message;
+  message.mutable_executor_info()->MergeFrom(executor->info);
+  message.mutable_framework_id()->MergeFrom(framework->id);
+  message.mutable_framework_info()->MergeFrom(framework->info);
+  message.mutable_slave_id()->MergeFrom(info.id());
+  message.mutable_slave_info()->MergeFrom(info);
+  send(executor->pid, message);
+
+  foreachvalue (const TaskInfo& task, executor->queuedTasks) {
+    LOG(INFO) << "Flushing queued task " << task.task_id()
+              << " for executor '" << executor->id << "'"
+              << " of framework " << framework->id;
+
+    stats.tasks[TASK_STAGING]++;
+
+    RunTaskMessage message;
+    message.mutable_framework_id()->MergeFrom(framework->id);
+    message.mutable_framework()->MergeFrom(framework->info);
+    message.set_pid(framework->pid);
+    message.mutable_task()->MergeFrom(task);
+    send(executor->pid, message);
+  }
+
+  executor->queuedTasks.clear();
+}
+
+
 void Slave::reregisterExecutor(
     const FrameworkID& frameworkId,
     const ExecutorID& executorId,
@@ -2480,11 +2564,9 @@ Duration Slave::age(double usage)
 
 void Slave::checkDiskUsage()
 {
-  // TODO(vinod): We are making usage a Future, so that we can plug in
-  // fs::usage() into async.
   // NOTE: We calculate disk usage of the file system on which the
   // slave work directory is mounted.
-  Future<Try<double> >(fs::usage(flags.work_dir))
+  async(&fs::usage, flags.work_dir)
     .onAny(defer(self(), &Slave::_checkDiskUsage, params::_1));
 }
 
@@ -93,8 +93,14 @@ public:
   void masterDetectionFailure();
   void registered(const SlaveID& slaveId);
   void reregistered(const SlaveID& slaveId);
+  // Registers (or re-registers) with the master after waiting a
+  // random amount of time (see --registration_backoff_factor).
   void doReliableRegistration();
 
+  // Sends the (re-)registration message and schedules a retry (with
+  // randomized exponential backoff) in case it gets lost.
+  void _doReliableRegistration(const Duration& interval);
+
   void runTask(
       const FrameworkInfo& frameworkInfo,
       const FrameworkID& frameworkId,
@@ -126,6 +132,14 @@ public:
       const FrameworkID& frameworkId,
       const ExecutorID& executorId);
 
+  // Completes the registration once the executor's pid has been
+  // checkpointed (if necessary).
+  void _registerExecutor(
+      const FrameworkID& frameworkId,
+      const ExecutorID& executorId,
+      const UPID& pid,
+      const Future<Try<Nothing> >& checkpoint);
+
   void reregisterExecutor(
       const FrameworkID& frameworkId,
       const ExecutorID& executorId,
@@ -286,6 +300,10 @@ private:
 
   UPID master;
 
+  // Used to randomize the registration backoff (see
+  // Slave::doReliableRegistration).
+  unsigned int seed;
+
   Resources resources;
   Attributes attributes;
 
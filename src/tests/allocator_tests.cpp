@@ -24,6 +24,7 @@
 #include <process/clock.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
+#include <process/http.hpp>
 #include <process/pid.hpp>
 
 #include "detector/detector.hpp"
@@ -39,6 +40,7 @@ using namespace mesos::internal;
 using namespace mesos::internal::tests;
 
 using mesos::internal::master::allocator::Allocator;
+using mesos::internal::master::allocator::AllocatorProcess;
 using mesos::internal::master::allocator::HierarchicalDRFAllocatorProcess;
 
 using mesos::internal::master::Master;
@@ -57,6 +59,7 @@ using testing::AtMost;
 using testing::DoAll;
 using testing::DoDefault;
 using testing::Eq;
+using testing::Return;
 using testing::SaveArg;
 
 
@@ -240,6 +243,62 @@ TEST_F(DRFAllocatorTest, DRFAllocatorProcess)
 }
 
 
+// Checks that a filter created by declining an offer can be
+// inspected via the allocator's 'filters.json' endpoint.
+TEST_F(DRFAllocatorTest, FiltersEndpoint)
+{
+  HierarchicalDRFAllocatorProcess allocator;
+
+  Try<PID<Master> > master = StartMaster(&allocator);
+  ASSERT_SOME(master);
+
+  Try<PID<Slave> > slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(&sched, DEFAULT_FRAMEWORK_INFO, master.get());
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  Future<vector<Offer> > offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(frameworkId);
+  AWAIT_READY(offers);
+  ASSERT_NE(0u, offers.get().size());
+
+  Future<Nothing> resourcesUnused =
+    FUTURE_DISPATCH(_, &AllocatorProcess::resourcesUnused);
+
+  Filters filters;
+  filters.set_refuse_seconds(1000);
+  driver.declineOffer(offers.get()[0].id(), filters);
+
+  AWAIT_READY(resourcesUnused);
+
+  Future<process::http::Response> response =
+    process::http::get(allocator.self(), "filters.json");
+
+  AWAIT_READY(response);
+  EXPECT_EQ(process::http::OK().status, response.get().status);
+
+  const string& body = response.get().body;
+  EXPECT_NE(string::npos, body.find(frameworkId.get().value()));
+  EXPECT_NE(string::npos, body.find(offers.get()[0].slave_id().value()));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
 template <typename T>
 class AllocatorTest : public MesosTest
 {
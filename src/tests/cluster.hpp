@@ -219,9 +219,15 @@ inline Try<process::PID<master::Master> > Cluster::Masters::start(
     return Error("Can not start multiple masters when not using ZooKeeper");
   }
 
+  Try<master::allocator::AllocatorProcess*> allocatorProcess =
+    master::allocator::createHierarchicalDRFAllocatorProcess(flags.placement);
+  if (allocatorProcess.isError()) {
+    return Error(allocatorProcess.error());
+  }
+
   Master master;
 
-  master.allocatorProcess = new master::allocator::HierarchicalDRFAllocatorProcess();
+  master.allocatorProcess = allocatorProcess.get();
   master.allocator = new master::allocator::Allocator(master.allocatorProcess);
   master.master = new master::Master(master.allocator, &cluster->files, flags);
 
@@ -193,6 +193,69 @@ TEST_F(FaultToleranceTest, PartitionedSlave)
 }
 
 
+// This test checks that the master uses the configured ping timeout
+// and number of missed pings to decide when a slave is lost.
+TEST_F(FaultToleranceTest, PartitionedSlavePingFlags)
+{
+  Clock::pause();
+
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.slave_ping_timeout = Seconds(5);
+  masterFlags.max_slave_ping_timeouts = 2;
+
+  Try<PID<Master> > master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  Future<Message> ping = FUTURE_MESSAGE(Eq("PING"), _, _);
+
+  // Drop all the PONGs to simulate slave partition.
+  DROP_MESSAGES(Eq("PONG"), _, _);
+
+  Try<PID<Slave> > slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(&sched, DEFAULT_FRAMEWORK_INFO, master.get());
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  Future<Nothing> resourceOffers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureSatisfy(&resourceOffers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(resourceOffers);
+
+  EXPECT_CALL(sched, offerRescinded(&driver, _))
+    .Times(AtMost(1));
+
+  Future<Nothing> slaveLost;
+  EXPECT_CALL(sched, slaveLost(&driver, _))
+    .WillOnce(FutureSatisfy(&slaveLost));
+
+  AWAIT_READY(ping);
+
+  ping = FUTURE_MESSAGE(Eq("PING"), _, _);
+  Clock::advance(masterFlags.slave_ping_timeout);
+
+  AWAIT_READY(ping);
+
+  // The second missed ping is one too many.
+  Clock::advance(masterFlags.slave_ping_timeout);
+
+  AWAIT_READY(slaveLost);
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+
+  Clock::resume();
+}
+
+
 // The purpose of this test is to ensure that when slaves are removed
 // from the master, and then attempt to re-register, we deny the
 // re-registration by sending a ShutdownMessage to the slave.
@@ -209,8 +272,8 @@ TEST_F(FaultToleranceTest, PartitionedSlaveReregistration)
 
   // Allow the master to PING the slave, but drop all PONG messages
   // from the slave. Note that we don't match on the master / slave
-  // PIDs because it's actually the SlaveObserver Process that sends
-  // the pings.
+  // PIDs because it's actually the SlaveHealthChecker Process that
+  // sends the pings.
   Future<Message> ping = FUTURE_MESSAGE(Eq("PING"), _, _);
   DROP_MESSAGES(Eq("PONG"), _, _);
 
@@ -359,8 +422,8 @@ TEST_F(FaultToleranceTest, PartitionedSlaveStatusUpdates)
 
   // Allow the master to PING the slave, but drop all PONG messages
   // from the slave. Note that we don't match on the master / slave
-  // PIDs because it's actually the SlaveObserver Process that sends
-  // the pings.
+  // PIDs because it's actually the SlaveHealthChecker Process that
+  // sends the pings.
   Future<Message> ping = FUTURE_MESSAGE(Eq("PING"), _, _);
   DROP_MESSAGES(Eq("PONG"), _, _);
 
@@ -472,8 +535,8 @@ TEST_F(FaultToleranceTest, PartitionedSlaveExitedExecutor)
 
   // Allow the master to PING the slave, but drop all PONG messages
   // from the slave. Note that we don't match on the master / slave
-  // PIDs because it's actually the SlaveObserver Process that sends
-  // the pings.
+  // PIDs because it's actually the SlaveHealthChecker Process that
+  // sends the pings.
   Future<Message> ping = FUTURE_MESSAGE(Eq("PING"), _, _);
   DROP_MESSAGES(Eq("PONG"), _, _);
 
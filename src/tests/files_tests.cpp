@@ -16,20 +16,33 @@
  * limitations under the License.
  */
 
-#include <string>
+#include <arpa/inet.h>
 
 #include <gmock/gmock.h>
 
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+
 #include <process/future.hpp>
 #include <process/gtest.hpp>
 #include <process/http.hpp>
 #include <process/pid.hpp>
 #include <process/process.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/gtest.hpp>
 #include <stout/json.hpp>
 #include <stout/os.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
+#include <stout/strings.hpp>
 
 #include "files/files.hpp"
 
@@ -264,6 +277,295 @@ TEST_F(FilesTest, BrowseTest)
 }
 
 
+TEST_F(FilesTest, BrowsePaginationTest)
+{
+  Files files;
+  process::UPID upid("files", process::ip(), process::port());
+
+  ASSERT_SOME(os::mkdir("1"));
+  ASSERT_SOME(os::write("1/a.log", "a"));
+  ASSERT_SOME(os::write("1/b.txt", "b"));
+  ASSERT_SOME(os::write("1/c.log", "c"));
+  ASSERT_SOME(os::write("1/d.log", "d"));
+
+  AWAIT_EXPECT_READY(files.attach("1", "one"));
+
+  struct stat s;
+  JSON::Array expected;
+  ASSERT_EQ(0, stat("1/a.log", &s));
+  expected.values.push_back(jsonFileInfo("one/a.log", s));
+  ASSERT_EQ(0, stat("1/b.txt", &s));
+  expected.values.push_back(jsonFileInfo("one/b.txt", s));
+
+  // The first page.
+  Future<Response> response =
+    process::http::get(upid, "browse.json", "path=one&limit=2");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ(stringify(expected), response);
+
+  // The next page, only the logs.
+  expected.values.clear();
+  ASSERT_EQ(0, stat("1/c.log", &s));
+  expected.values.push_back(jsonFileInfo("one/c.log", s));
+  ASSERT_EQ(0, stat("1/d.log", &s));
+  expected.values.push_back(jsonFileInfo("one/d.log", s));
+
+  response = process::http::get(
+      upid, "browse.json", "path=one&limit=2&after=a.log&pattern=*.log");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ(stringify(expected), response);
+
+  // Past the last page.
+  response = process::http::get(
+      upid, "browse.json", "path=one&limit=2&after=d.log");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ(stringify(JSON::Array()), response);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      BadRequest().status,
+      process::http::get(upid, "browse.json", "path=one&limit=0"));
+}
+
+
+// Connects a socket to the HTTP server of 'pid', returns -1 on
+// failure.
+static int connectTo(const process::UPID& pid)
+{
+  int s = ::socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+  if (s < 0) {
+    return -1;
+  }
+
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = PF_INET;
+  addr.sin_port = htons(pid.port);
+  addr.sin_addr.s_addr = pid.ip;
+
+  if (::connect(s, (sockaddr*) &addr, sizeof(addr)) < 0) {
+    os::close(s);
+    return -1;
+  }
+
+  return s;
+}
+
+
+// Returns what could be read from the socket within 'timeout', which
+// is empty if nothing could.
+static string readSome(int s, const Duration& timeout)
+{
+  struct pollfd pollfd;
+  pollfd.fd = s;
+  pollfd.events = POLLIN;
+  pollfd.revents = 0;
+
+  if (::poll(&pollfd, 1, timeout.ms()) <= 0) {
+    return "";
+  }
+
+  char buffer[4096];
+  ssize_t length = ::read(s, buffer, sizeof(buffer));
+  return length > 0 ? string(buffer, length) : "";
+}
+
+
+// Reads from the socket until the data read so far contains 'what',
+// giving up once nothing arrives for 'timeout'.
+static string readUntil(
+    int s,
+    const string& what,
+    const Duration& timeout = Seconds(10))
+{
+  string data;
+  while (!strings::contains(data, what)) {
+    const string& some = readSome(s, timeout);
+    if (some.empty()) {
+      break;
+    }
+    data += some;
+  }
+  return data;
+}
+
+
+TEST_F(FilesTest, TailTest)
+{
+  Files files;
+  process::UPID upid("files", process::ip(), process::port());
+
+  ASSERT_SOME(os::mkdir("dir"));
+  ASSERT_SOME(os::write("dir/file", "INFO one\nERROR two\nINFO thr"));
+  AWAIT_EXPECT_READY(files.attach("dir", "mydir"));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      BadRequest().status,
+      process::http::get(upid, "tail.json", "path=mydir"));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      BadRequest().status,
+      process::http::get(upid, "tail.json", "path=mydir/file&filter=("));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      BadRequest().status,
+      process::http::get(upid, "tail.json", "path=mydir/file&rate=fast"));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      BadRequest().status,
+      process::http::get(upid, "tail.json", "path=mydir/file&offset=-2"));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      NotFound().status,
+      process::http::get(upid, "tail.json", "path=mydir/missing"));
+
+  // Follow the file from the start, streaming only the errors (the
+  // filter is '^ERROR.*[ro]$', which needs '$' to match at the end
+  // of each line).
+  int s = connectTo(upid);
+  ASSERT_LE(0, s);
+
+  const string& request =
+    "GET /files/tail.json?path=mydir/file&offset=0"
+    "&filter=%5EERROR.*%5Bro%5D%24 HTTP/1.1\r\n"
+    "\r\n";
+
+  ASSERT_EQ((ssize_t) request.size(), write(s, request.data(), request.size()));
+
+  string data = readUntil(s, "ERROR two\n");
+  EXPECT_TRUE(strings::contains(data, "ERROR two\n")) << data;
+  EXPECT_FALSE(strings::contains(data, "INFO")) << data;
+
+  // Finish the incomplete line and append some more.
+  std::ofstream file("dir/file", std::ios::app);
+  file << "ee\nERROR four\n";
+  file.close();
+
+  data = readUntil(s, "ERROR four\n");
+  EXPECT_TRUE(strings::contains(data, "ERROR four\n")) << data;
+  EXPECT_FALSE(strings::contains(data, "INFO")) << data;
+
+  // Start over once the file gets truncated.
+  ASSERT_SOME(os::write("dir/file", "ERROR five\n"));
+
+  data = readUntil(s, "ERROR five\n");
+  EXPECT_TRUE(strings::contains(data, "ERROR five\n")) << data;
+
+  ASSERT_EQ(0, close(s));
+}
+
+
+// Tests that tails are throttled and that a line longer than 64KB
+// gets sent before it is complete.
+TEST_F(FilesTest, TailThrottleTest)
+{
+  Files files;
+  process::UPID upid("files", process::ip(), process::port());
+
+  // The data and HTTP chunk headers don't have any '#'s.
+  ASSERT_SOME(os::write("file", string(100 * 1024, '#')));
+  AWAIT_EXPECT_READY(files.attach("file", "file"));
+
+  int s = connectTo(upid);
+  ASSERT_LE(0, s);
+
+  const string& request =
+    "GET /files/tail.json?path=file&offset=0&rate=32KB HTTP/1.1\r\n"
+    "\r\n";
+
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  ASSERT_EQ((ssize_t) request.size(), write(s, request.data(), request.size()));
+
+  // The first 32KB can be read right away and the rest at 32KB per
+  // second, so the tail needs about a second before it has read more
+  // than 64KB of the line and sends what it has.
+  size_t count = 0;
+  while (count <= 64 * 1024) {
+    const string& data = readSome(s, Seconds(10));
+    ASSERT_FALSE(data.empty()) << count;
+    count += std::count(data.begin(), data.end(), '#');
+  }
+
+  EXPECT_LE(Milliseconds(900), stopwatch.elapsed());
+
+  // The rest of the line gets sent once it's complete.
+  std::ofstream file("file", std::ios::app);
+  file << "\n";
+  file.close();
+
+  while (count < 100 * 1024) {
+    const string& data = readSome(s, Seconds(10));
+    ASSERT_FALSE(data.empty()) << count;
+    count += std::count(data.begin(), data.end(), '#');
+  }
+
+  EXPECT_EQ(100u * 1024u, count);
+
+  ASSERT_EQ(0, close(s));
+}
+
+
+static void abortOnSigpipe(int signal)
+{
+  abort();
+}
+
+
+// Tests that a client going away in the middle of a tail doesn't
+// raise a SIGPIPE, which the daemons escalate to an abort (see
+// logging/logging.cpp).
+TEST_F(FilesTest, TailDisconnectTest)
+{
+  struct sigaction action;
+  action.sa_handler = abortOnSigpipe;
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = 0;
+
+  struct sigaction old;
+  ASSERT_EQ(0, sigaction(SIGPIPE, &action, &old));
+
+  Files files;
+  process::UPID upid("files", process::ip(), process::port());
+
+  ASSERT_SOME(os::write("file", "one\n"));
+  AWAIT_EXPECT_READY(files.attach("file", "file"));
+
+  int s = connectTo(upid);
+  ASSERT_LE(0, s);
+
+  const string& request =
+    "GET /files/tail.json?path=file&offset=0 HTTP/1.1\r\n"
+    "\r\n";
+
+  ASSERT_EQ((ssize_t) request.size(), write(s, request.data(), request.size()));
+
+  string data = readUntil(s, "one\n");
+  EXPECT_TRUE(strings::contains(data, "one\n")) << data;
+
+  ASSERT_EQ(0, close(s));
+
+  // Keep appending so that the tail writes to the socketpair after
+  // the response (and with it the other end) went away.
+  for (int i = 0; i < 20; i++) {
+    std::ofstream file("file", std::ios::app);
+    file << string(16 * 1024, '#') << "\n";
+    file.close();
+    os::sleep(Milliseconds(50));
+  }
+
+  // Still alive and serving.
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      BadRequest().status,
+      process::http::get(upid, "tail.json", "path=file&offset=-2"));
+
+  ASSERT_EQ(0, sigaction(SIGPIPE, &old, NULL));
+}
+
+
 TEST_F(FilesTest, DownloadTest)
 {
   Files files;
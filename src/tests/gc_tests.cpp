@@ -250,7 +250,17 @@ TEST_F(GarbageCollectorTest, Prune)
 }
 
 
-class GarbageCollectorIntegrationTest : public MesosTest {};
+class GarbageCollectorIntegrationTest : public MesosTest
+{
+protected:
+  // Returns a future that is satisfied once the garbage collector
+  // has deleted some directories (i.e., dispatched '_remove', which
+  // is private to GarbageCollectorProcess).
+  Future<Nothing> futureRemove()
+  {
+    return FUTURE_DISPATCH(_, &GarbageCollectorProcess::_remove);
+  }
+};
 
 
 TEST_F(GarbageCollectorIntegrationTest, Restart)
@@ -337,10 +347,17 @@ TEST_F(GarbageCollectorIntegrationTest, Restart)
 
   Clock::settle(); // Wait for GarbageCollectorProcess::schedule to complete.
 
+  // The directories get deleted asynchronously.
+  Future<Nothing> _remove = futureRemove();
+
   Clock::advance(flags.gc_delay);
 
   Clock::settle();
 
+  AWAIT_READY(_remove);
+
+  Clock::settle(); // Wait for GarbageCollectorProcess::_remove to complete.
+
   // By this time the old slave directory should be cleaned up.
   ASSERT_FALSE(os::exists(slaveDir));
 
@@ -431,10 +448,17 @@ TEST_F(GarbageCollectorIntegrationTest, ExitedFramework)
 
   Clock::settle(); // Wait for GarbageCollectorProcess::schedule to complete.
 
+  // The directories get deleted asynchronously.
+  Future<Nothing> _remove = futureRemove();
+
   Clock::advance(flags.gc_delay);
 
   Clock::settle();
 
+  AWAIT_READY(_remove);
+
+  Clock::settle(); // Wait for GarbageCollectorProcess::_remove to complete.
+
   // Framework's directory should be gc'ed by now.
   const string& frameworkDir = slave::paths::getFrameworkPath(
       flags.work_dir, slaveId, frameworkId);
@@ -525,10 +549,17 @@ TEST_F(GarbageCollectorIntegrationTest, ExitedExecutor)
 
   Clock::settle(); // Wait for GarbageCollectorProcess::schedule to complete.
 
+  // The directories get deleted asynchronously.
+  Future<Nothing> _remove = futureRemove();
+
   Clock::advance(flags.gc_delay);
 
   Clock::settle();
 
+  AWAIT_READY(_remove);
+
+  Clock::settle(); // Wait for GarbageCollectorProcess::_remove to complete.
+
   // Executor's directory should be gc'ed by now.
   ASSERT_FALSE(os::exists(executorDir));
   AWAIT_EXPECT_RESPONSE_STATUS_EQ(
@@ -620,6 +651,9 @@ TEST_F(GarbageCollectorIntegrationTest, DiskUsage)
   Future<Nothing> _checkDiskUsage =
     FUTURE_DISPATCH(_, &Slave::_checkDiskUsage);
 
+  // The directories get deleted asynchronously.
+  Future<Nothing> _remove = futureRemove();
+
   // Simulate a disk full message to the slave.
   process::dispatch(
       slave.get(),
@@ -630,6 +664,10 @@ TEST_F(GarbageCollectorIntegrationTest, DiskUsage)
 
   Clock::settle(); // Wait for Slave::_checkDiskUsage to complete.
 
+  AWAIT_READY(_remove);
+
+  Clock::settle(); // Wait for GarbageCollectorProcess::_remove to complete.
+
   // Executor's directory should be gc'ed by now.
   ASSERT_FALSE(os::exists(executorDir));
   AWAIT_EXPECT_RESPONSE_STATUS_EQ(
@@ -0,0 +1,240 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gmock/gmock.h>
+
+#include <string>
+#include <vector>
+
+#include <mesos/mesos.hpp>
+
+#include <process/future.hpp>
+#include <process/gtest.hpp>
+
+#include <stout/none.hpp>
+#include <stout/option.hpp>
+#include <stout/os.hpp>
+#include <stout/stringify.hpp>
+
+#include "master/history.hpp"
+
+#include "messages/messages.hpp"
+
+using namespace mesos;
+using namespace mesos::internal;
+
+using mesos::internal::master::History;
+
+using process::Future;
+
+using std::string;
+using std::vector;
+
+
+class HistoryTest : public ::testing::Test
+{
+public:
+  HistoryTest()
+    : history(NULL),
+      path(os::getcwd() + "/.history") {}
+
+protected:
+  virtual void SetUp()
+  {
+    os::rmdir(path);
+    history = new History(path, 1000);
+  }
+
+  virtual void TearDown()
+  {
+    delete history;
+    os::rmdir(path);
+  }
+
+  // Deletes the history and opens it again, keeping (up to)
+  // 'capacity' records.
+  void reopen(size_t capacity = 1000)
+  {
+    delete history;
+    history = new History(path, capacity);
+  }
+
+  History* history;
+
+private:
+  const string path;
+};
+
+
+static Task createTask(const string& frameworkId, int index)
+{
+  Task task;
+  task.set_name("");
+  task.mutable_task_id()->set_value(stringify(index));
+  task.mutable_framework_id()->set_value(frameworkId);
+  task.mutable_slave_id()->set_value("slave");
+  task.set_state(TASK_FINISHED);
+  return task;
+}
+
+
+TEST_F(HistoryTest, Tasks)
+{
+  for (int i = 0; i < 10; i++) {
+    history->add(createTask("framework1", i));
+    history->add(createTask("framework2", i));
+  }
+
+  FrameworkID frameworkId;
+  frameworkId.set_value("framework2");
+
+  Future<vector<Task> > tasks =
+    history->tasks(Option<FrameworkID>::some(frameworkId), 0, 4);
+
+  AWAIT_READY(tasks);
+  ASSERT_EQ(4u, tasks.get().size());
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ("framework2", tasks.get()[i].framework_id().value());
+    EXPECT_EQ(stringify(i), tasks.get()[i].task_id().value());
+  }
+
+  // The last page is short.
+  tasks = history->tasks(Option<FrameworkID>::some(frameworkId), 8, 4);
+
+  AWAIT_READY(tasks);
+  ASSERT_EQ(2u, tasks.get().size());
+  EXPECT_EQ("8", tasks.get()[0].task_id().value());
+  EXPECT_EQ("9", tasks.get()[1].task_id().value());
+
+  // Without a framework, the tasks are grouped by framework.
+  tasks = history->tasks(None(), 9, 2);
+
+  AWAIT_READY(tasks);
+  ASSERT_EQ(2u, tasks.get().size());
+  EXPECT_EQ("framework1", tasks.get()[0].framework_id().value());
+  EXPECT_EQ("9", tasks.get()[0].task_id().value());
+  EXPECT_EQ("framework2", tasks.get()[1].framework_id().value());
+  EXPECT_EQ("0", tasks.get()[1].task_id().value());
+}
+
+
+TEST_F(HistoryTest, Frameworks)
+{
+  for (int i = 0; i < 3; i++) {
+    CompletedFramework framework;
+    framework.mutable_info()->set_user("user");
+    framework.mutable_info()->set_name("framework");
+    framework.mutable_info()->mutable_id()->set_value(stringify(i));
+    framework.set_registered_time(i);
+    framework.set_unregistered_time(i + 1);
+    history->add(framework);
+  }
+
+  Future<vector<CompletedFramework> > frameworks = history->frameworks(1, 10);
+
+  AWAIT_READY(frameworks);
+  ASSERT_EQ(2u, frameworks.get().size());
+  EXPECT_EQ("1", frameworks.get()[0].info().id().value());
+  EXPECT_EQ("2", frameworks.get()[1].info().id().value());
+  EXPECT_EQ(3, frameworks.get()[1].unregistered_time());
+}
+
+
+TEST_F(HistoryTest, Recover)
+{
+  for (int i = 0; i < 10; i++) {
+    history->add(createTask("framework", i));
+  }
+
+  reopen();
+
+  // What gets appended after the history is recovered comes last.
+  for (int i = 10; i < 20; i++) {
+    history->add(createTask("framework", i));
+  }
+
+  Future<vector<Task> > tasks = history->tasks(None(), 0, 100);
+
+  AWAIT_READY(tasks);
+  ASSERT_EQ(20u, tasks.get().size());
+  for (int i = 0; i < 20; i++) {
+    EXPECT_EQ(stringify(i), tasks.get()[i].task_id().value());
+  }
+}
+
+
+TEST_F(HistoryTest, Trim)
+{
+  reopen(5);
+
+  for (int i = 0; i < 4; i++) {
+    history->add(createTask("framework1", i));
+  }
+
+  for (int i = 0; i < 4; i++) {
+    history->add(createTask("framework2", i));
+  }
+
+  // Only the last 5 tasks are kept.
+  Future<vector<Task> > tasks = history->tasks(None(), 0, 100);
+
+  AWAIT_READY(tasks);
+  ASSERT_EQ(5u, tasks.get().size());
+  EXPECT_EQ("framework1", tasks.get()[0].framework_id().value());
+  EXPECT_EQ("3", tasks.get()[0].task_id().value());
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ("framework2", tasks.get()[i + 1].framework_id().value());
+    EXPECT_EQ(stringify(i), tasks.get()[i + 1].task_id().value());
+  }
+
+  FrameworkID frameworkId;
+  frameworkId.set_value("framework1");
+
+  tasks = history->tasks(Option<FrameworkID>::some(frameworkId), 0, 100);
+
+  AWAIT_READY(tasks);
+  ASSERT_EQ(1u, tasks.get().size());
+  EXPECT_EQ("3", tasks.get()[0].task_id().value());
+
+  // The offset counts the tasks that are kept.
+  tasks = history->tasks(None(), 2, 2);
+
+  AWAIT_READY(tasks);
+  ASSERT_EQ(2u, tasks.get().size());
+  EXPECT_EQ("1", tasks.get()[0].task_id().value());
+  EXPECT_EQ("2", tasks.get()[1].task_id().value());
+
+  // What is kept gets recovered, the next task pushes out the last
+  // task of the first framework.
+  reopen(5);
+
+  history->add(createTask("framework3", 0));
+
+  tasks = history->tasks(None(), 0, 100);
+
+  AWAIT_READY(tasks);
+  ASSERT_EQ(5u, tasks.get().size());
+  EXPECT_EQ("framework2", tasks.get()[0].framework_id().value());
+  EXPECT_EQ("0", tasks.get()[0].task_id().value());
+  EXPECT_EQ("framework3", tasks.get()[4].framework_id().value());
+
+  tasks = history->tasks(Option<FrameworkID>::some(frameworkId), 0, 100);
+
+  AWAIT_READY(tasks);
+  EXPECT_TRUE(tasks.get().empty());
+}
@@ -16,16 +16,32 @@
  * limitations under the License.
  */
 
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 #include <gmock/gmock.h>
 
+#include <iostream>
+#include <string>
+
+#include <mesos/mesos.hpp>
+
 #include <process/future.hpp>
 #include <process/gtest.hpp>
 #include <process/http.hpp>
 #include <process/pid.hpp>
 #include <process/process.hpp>
 
+#include <stout/duration.hpp>
+#include <stout/os.hpp>
+#include <stout/stopwatch.hpp>
+
+#include "common/type_utils.hpp"
+
 #include "logging/logging.hpp"
 
+using namespace mesos;
 using namespace mesos::internal;
 
 using process::http::BadRequest;
@@ -79,3 +95,138 @@ TEST(LoggingTest, Toggle)
       "Invalid level '-1'.\n",
       response);
 }
+
+
+// A logger that takes a while to write each message, like a slow (or
+// busy) disk would.
+class SlowLogger : public google::base::Logger
+{
+public:
+  SlowLogger() : writes(0) {}
+
+  virtual void Write(bool, time_t, const char*, int)
+  {
+    os::sleep(Microseconds(100));
+    writes++;
+  }
+
+  virtual void Flush() {}
+
+  virtual google::uint32 LogSize() { return 0; }
+
+  int writes;
+};
+
+
+// Logs like the master does when sending offers, returning how long
+// it took.
+static Duration offers(int count)
+{
+  FrameworkID frameworkId;
+  frameworkId.set_value("201307151200-1234567890-5050-1234-0000");
+
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  for (int i = 0; i < count; i++) {
+    LOG(INFO) << "Sending " << 1 << " offers to framework " << frameworkId;
+  }
+
+  stopwatch.stop();
+
+  return stopwatch.elapsed();
+}
+
+
+// Benchmarks how long logging from the master takes with INFO
+// logging disabled, when writing the log synchronously to a slow
+// disk and when writing it asynchronously (see --async_logging).
+TEST(LoggingTest, AsyncBenchmark)
+{
+  const int count = 5000;
+
+  google::base::Logger* logger = google::base::GetLogger(google::INFO);
+
+  int minloglevel = FLAGS_minloglevel;
+  int stderrthreshold = FLAGS_stderrthreshold;
+
+  // Don't spam stderr with the benchmark's messages.
+  FLAGS_stderrthreshold = google::FATAL;
+
+  // INFO logging off.
+  FLAGS_minloglevel = google::WARNING;
+
+  Duration off = offers(count);
+
+  FLAGS_minloglevel = google::INFO;
+
+  // Synchronous.
+  SlowLogger slow;
+  google::base::SetLogger(google::INFO, &slow);
+
+  Duration sync = offers(count);
+
+  // Other threads (e.g., libprocess) might log while the INFO logger
+  // is swapped out so we can only bound the number of writes.
+  EXPECT_LE(count, slow.writes);
+
+  // Asynchronous.
+  slow.writes = 0;
+
+  logging::AsyncLogger* async = new logging::AsyncLogger(&slow, 8 * 1024 * 1024);
+  google::base::SetLogger(google::INFO, async);
+
+  Duration caller = offers(count);
+
+  Stopwatch stopwatch;
+  stopwatch.start();
+  async->Flush();
+  stopwatch.stop();
+
+  EXPECT_LE(count, slow.writes);
+  EXPECT_EQ(0u, async->dropped());
+
+  google::base::SetLogger(google::INFO, logger);
+
+  delete async; // Stops the writer thread.
+
+  FLAGS_minloglevel = minloglevel;
+  FLAGS_stderrthreshold = stderrthreshold;
+
+  std::cout << "Logged " << count << " messages with INFO logging off in "
+            << off << ", synchronously in " << sync
+            << ", and asynchronously in " << caller
+            << " (plus " << stopwatch.elapsed() << " to flush)" << std::endl;
+}
+
+
+// Tests that a child forked without exec'ing (e.g., by an isolator)
+// can still log and flush even though the writer thread only exists
+// in the parent.
+TEST(LoggingTest, AsyncFork)
+{
+  SlowLogger slow;
+  logging::AsyncLogger async(&slow, 8 * 1024 * 1024);
+
+  const std::string message = "before fork\n";
+  async.Write(false, time(NULL), message.data(), message.size());
+
+  pid_t pid = ::fork();
+  ASSERT_NE(-1, pid);
+
+  if (pid == 0) {
+    // Child: these would wait forever on the writer thread.
+    const std::string message = "after fork\n";
+    async.Write(true, time(NULL), message.data(), message.size());
+    async.Flush();
+    ::_exit(slow.writes > 0 ? 0 : 1);
+  }
+
+  int status;
+  ASSERT_EQ(pid, ::waitpid(pid, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(0, WEXITSTATUS(status));
+
+  async.Flush();
+  EXPECT_EQ(1, slow.writes);
+}
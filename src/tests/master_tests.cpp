@@ -30,12 +30,21 @@
 #include <process/clock.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
+#include <process/http.hpp>
 #include <process/pid.hpp>
+#include <process/process.hpp>
+#include <process/protobuf.hpp>
 
+#include <stout/json.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
 #include <stout/try.hpp>
 
+#include "common/resources.hpp"
+
 #include "master/flags.hpp"
 #include "master/master.hpp"
 
@@ -60,12 +69,14 @@ using mesos::internal::slave::Slave;
 using process::Clock;
 using process::Future;
 using process::PID;
+using process::Promise;
 
 using std::map;
 using std::string;
 using std::vector;
 
 using testing::_;
+using testing::AnyNumber;
 using testing::AtMost;
 using testing::DoAll;
 using testing::Eq;
@@ -281,6 +292,219 @@ TEST_F(MasterTest, KillTask)
   AWAIT_READY(status);
   EXPECT_EQ(TASK_KILLED, status.get().state());
 
+  // The killed task is no longer accounted as active, the master
+  // keeps it around as a completed task instead.
+  Future<process::http::Response> response =
+    process::http::get(master.get(), "stats.json");
+
+  AWAIT_READY(response);
+  EXPECT_EQ(process::http::OK().status, response.get().status);
+
+  Try<JSON::Value> value = JSON::parse(response.get().body);
+  ASSERT_SOME(value);
+
+  JSON::Object stats = boost::get<JSON::Object>(value.get());
+  ASSERT_EQ(1u, stats.values.count("task_bytes"));
+  ASSERT_EQ(1u, stats.values.count("completed_task_bytes"));
+
+  EXPECT_EQ(0, boost::get<JSON::Number>(stats.values["task_bytes"]).value);
+  EXPECT_LT(
+      0, boost::get<JSON::Number>(stats.values["completed_task_bytes"]).value);
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+// Checks that completed tasks which no longer fit in the framework's
+// in-memory 'completedTasks' get appended to the history and can be
+// read back from /master/completed_tasks.json.
+TEST_F(MasterTest, CompletedTasksHistory)
+{
+  master::Flags flags = CreateMasterFlags();
+  flags.history_dir = path::join(os::getcwd(), "history");
+  flags.max_completed_tasks_per_framework = 1;
+
+  Try<PID<Master> > master = StartMaster(flags);
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  Try<PID<Slave> > slave = StartSlave(&exec);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(&sched, DEFAULT_FRAMEWORK_INFO, master.get());
+
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .Times(1);
+
+  Future<vector<Offer> > offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  ASSERT_NE(0u, offers.get().size());
+
+  vector<TaskInfo> tasks;
+  for (int i = 1; i <= 2; i++) {
+    TaskInfo task;
+    task.set_name("");
+    task.mutable_task_id()->set_value(stringify(i));
+    task.mutable_slave_id()->MergeFrom(offers.get()[0].slave_id());
+    task.mutable_resources()->MergeFrom(Resources::parse("cpus:1;mem:128"));
+    task.mutable_executor()->MergeFrom(DEFAULT_EXECUTOR_INFO);
+    tasks.push_back(task);
+  }
+
+  EXPECT_CALL(exec, registered(_, _, _, _))
+    .Times(1);
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillRepeatedly(SendStatusUpdateFromTask(TASK_FINISHED));
+
+  Future<TaskStatus> status1, status2;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status1))
+    .WillOnce(FutureArg<1>(&status2));
+
+  driver.launchTasks(offers.get()[0].id(), tasks);
+
+  AWAIT_READY(status1);
+  EXPECT_EQ(TASK_FINISHED, status1.get().state());
+
+  AWAIT_READY(status2);
+  EXPECT_EQ(TASK_FINISHED, status2.get().state());
+
+  // Only one of the two tasks fits in memory, the one that completed
+  // first must have been pushed out into the history.
+  Future<process::http::Response> response =
+    process::http::get(master.get(), "completed_tasks.json");
+
+  AWAIT_READY(response);
+  EXPECT_EQ(process::http::OK().status, response.get().status);
+
+  Try<JSON::Value> value = JSON::parse(response.get().body);
+  ASSERT_SOME(value);
+
+  const JSON::Object object = boost::get<JSON::Object>(value.get());
+  ASSERT_EQ(1u, object.values.count("completed_tasks"));
+
+  const JSON::Array completed =
+    boost::get<JSON::Array>(object.values.find("completed_tasks")->second);
+  ASSERT_EQ(1u, completed.values.size());
+
+  const JSON::Object task = boost::get<JSON::Object>(completed.values.front());
+  ASSERT_EQ(1u, task.values.count("id"));
+  ASSERT_EQ(1u, task.values.count("state"));
+
+  const string id =
+    boost::get<JSON::String>(task.values.find("id")->second).value;
+  EXPECT_EQ(status1.get().task_id().value(), id);
+
+  EXPECT_EQ("TASK_FINISHED",
+            boost::get<JSON::String>(task.values.find("state")->second).value);
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+// Tests that no completed tasks are kept in memory when asked not
+// to, they go straight into the history instead.
+TEST_F(MasterTest, NoCompletedTasksInMemory)
+{
+  master::Flags flags = CreateMasterFlags();
+  flags.history_dir = path::join(os::getcwd(), "history");
+  flags.max_completed_tasks_per_framework = 0;
+
+  Try<PID<Master> > master = StartMaster(flags);
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  Try<PID<Slave> > slave = StartSlave(&exec);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(&sched, DEFAULT_FRAMEWORK_INFO, master.get());
+
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .Times(1);
+
+  Future<vector<Offer> > offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  ASSERT_NE(0u, offers.get().size());
+
+  TaskInfo task;
+  task.set_name("");
+  task.mutable_task_id()->set_value("1");
+  task.mutable_slave_id()->MergeFrom(offers.get()[0].slave_id());
+  task.mutable_resources()->MergeFrom(offers.get()[0].resources());
+  task.mutable_executor()->MergeFrom(DEFAULT_EXECUTOR_INFO);
+
+  vector<TaskInfo> tasks;
+  tasks.push_back(task);
+
+  EXPECT_CALL(exec, registered(_, _, _, _))
+    .Times(1);
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_FINISHED));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.launchTasks(offers.get()[0].id(), tasks);
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_FINISHED, status.get().state());
+
+  // The master is still around and the task made it into the history.
+  Future<process::http::Response> response =
+    process::http::get(master.get(), "completed_tasks.json");
+
+  AWAIT_READY(response);
+  EXPECT_EQ(process::http::OK().status, response.get().status);
+
+  Try<JSON::Value> value = JSON::parse(response.get().body);
+  ASSERT_SOME(value);
+
+  const JSON::Object object = boost::get<JSON::Object>(value.get());
+  ASSERT_EQ(1u, object.values.count("completed_tasks"));
+
+  const JSON::Array completed =
+    boost::get<JSON::Array>(object.values.find("completed_tasks")->second);
+  ASSERT_EQ(1u, completed.values.size());
+
+  const JSON::Object completedTask =
+    boost::get<JSON::Object>(completed.values.front());
+  ASSERT_EQ(1u, completedTask.values.count("id"));
+
+  EXPECT_EQ("1",
+            boost::get<JSON::String>(
+                completedTask.values.find("id")->second).value);
+
   EXPECT_CALL(exec, shutdown(_))
     .Times(AtMost(1));
 
@@ -477,6 +701,58 @@ TEST_F(MasterTest, RecoverResources)
 }
 
 
+// Checks that an offer the framework doesn't reply to gets rescinded
+// after --offer_timeout and that its resources get offered again.
+TEST_F(MasterTest, OfferTimeout)
+{
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.offer_timeout = Milliseconds(100);
+
+  Try<PID<Master> > master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  Try<PID<Slave> > slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(&sched, DEFAULT_FRAMEWORK_INFO, master.get());
+
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .Times(1);
+
+  Future<vector<Offer> > offers1;
+  Future<vector<Offer> > offers2;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers1))
+    .WillOnce(FutureArg<1>(&offers2))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  Future<OfferID> rescinded;
+  EXPECT_CALL(sched, offerRescinded(&driver, _))
+    .WillOnce(FutureArg<1>(&rescinded))
+    .WillRepeatedly(Return());
+
+  driver.start();
+
+  AWAIT_READY(offers1);
+  ASSERT_NE(0u, offers1.get().size());
+
+  // We never reply to the offer.
+  AWAIT_READY(rescinded);
+  EXPECT_EQ(offers1.get()[0].id(), rescinded.get());
+
+  AWAIT_READY(offers2);
+  ASSERT_NE(0u, offers2.get().size());
+  EXPECT_EQ(Resources(offers1.get()[0].resources()),
+            Resources(offers2.get()[0].resources()));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
 TEST_F(MasterTest, FrameworkMessage)
 {
   Try<PID<Master> > master = StartMaster();
@@ -930,3 +1206,137 @@ TEST_F(MasterTest, MasterLost)
 
   Shutdown();
 }
+
+
+// Pretends to be a slave (with some running tasks) that re-registers
+// with a master that just failed over.
+class FakeSlave : public ProtobufProcess<FakeSlave>
+{
+public:
+  FakeSlave(const PID<Master>& _master,
+            const FrameworkID& _frameworkId,
+            int _index,
+            int _tasks)
+    : master(_master),
+      frameworkId(_frameworkId),
+      index(_index),
+      tasks(_tasks) {}
+
+  Future<Nothing> reregistered()
+  {
+    return promise.future();
+  }
+
+protected:
+  virtual void initialize()
+  {
+    install<SlaveReregisteredMessage>(&FakeSlave::_reregistered);
+
+    SlaveID slaveId;
+    slaveId.set_value("slave-" + stringify(index));
+
+    ReregisterSlaveMessage message;
+    message.mutable_slave_id()->MergeFrom(slaveId);
+    message.mutable_slave()->set_hostname("host-" + stringify(index));
+    message.mutable_slave()->set_webui_hostname("host-" + stringify(index));
+    message.mutable_slave()->mutable_resources()->MergeFrom(
+        Resources::parse("cpus:16;mem:16384"));
+
+    ExecutorInfo* executorInfo = message.add_executor_infos();
+    executorInfo->MergeFrom(DEFAULT_EXECUTOR_INFO);
+    executorInfo->mutable_framework_id()->MergeFrom(frameworkId);
+
+    for (int i = 0; i < tasks; i++) {
+      Task* task = message.add_tasks();
+      task->set_name("");
+      task->mutable_task_id()->set_value(
+          stringify(index) + "-" + stringify(i));
+      task->mutable_framework_id()->MergeFrom(frameworkId);
+      task->mutable_executor_id()->MergeFrom(DEFAULT_EXECUTOR_ID);
+      task->mutable_slave_id()->MergeFrom(slaveId);
+      task->set_state(TASK_RUNNING);
+      task->mutable_resources()->MergeFrom(
+          Resources::parse("cpus:1;mem:512"));
+    }
+
+    send(master, message);
+  }
+
+private:
+  void _reregistered()
+  {
+    promise.set(Nothing());
+  }
+
+  const PID<Master> master;
+  const FrameworkID frameworkId;
+  const int index;
+  const int tasks;
+  Promise<Nothing> promise;
+};
+
+
+// Benchmarks how long it takes a master that just failed over to
+// re-register all of the slaves (each running some tasks of a
+// registered framework) when they all re-register at once.
+TEST_F(MasterTest, ReregistrationStorm)
+{
+  const int slaves = 500;
+  const int tasks = 10;
+
+  Try<PID<Master> > master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(&sched, DEFAULT_FRAMEWORK_INFO, master.get());
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillRepeatedly(Return()); // Ignore offers.
+
+  // The tasks get lost once the fake slaves go away.
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .Times(AnyNumber());
+
+  EXPECT_CALL(sched, slaveLost(&driver, _))
+    .Times(AnyNumber());
+
+  driver.start();
+
+  AWAIT_READY(frameworkId);
+
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  vector<FakeSlave*> fakes;
+  vector<Future<Nothing> > reregistered;
+  for (int i = 0; i < slaves; i++) {
+    FakeSlave* fake = new FakeSlave(master.get(), frameworkId.get(), i, tasks);
+    reregistered.push_back(fake->reregistered());
+    process::spawn(fake);
+    fakes.push_back(fake);
+  }
+
+  foreach (const Future<Nothing>& future, reregistered) {
+    AWAIT_READY_FOR(future, Seconds(60));
+  }
+
+  stopwatch.stop();
+
+  std::cout << "Re-registered " << slaves << " slaves with " << tasks
+            << " tasks each in " << stopwatch.elapsed() << std::endl;
+
+  driver.stop();
+  driver.join();
+
+  foreach (FakeSlave* fake, fakes) {
+    process::terminate(fake);
+    process::wait(fake);
+    delete fake;
+  }
+
+  Shutdown();
+}
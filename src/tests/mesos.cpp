@@ -41,6 +41,10 @@ slave::Flags MesosTest::CreateSlaveFlags()
   flags.resources = Option<std::string>(
       "cpus:2;mem:1024;disk:1024;ports:[31000-32000]");
 
+  // Register right away so that tests (especially those with a
+  // paused clock) don't need to wait out the registration backoff.
+  flags.registration_backoff_factor = Duration::zero();
+
   return flags;
 }
 
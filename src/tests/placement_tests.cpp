@@ -0,0 +1,250 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gmock/gmock.h>
+
+#include <string>
+#include <vector>
+
+#include <mesos/scheduler.hpp>
+
+#include <process/future.hpp>
+#include <process/gmock.hpp>
+#include <process/pid.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
+
+#include "common/resources.hpp"
+
+#include "master/allocator.hpp"
+#include "master/hierarchical_allocator_process.hpp"
+#include "master/master.hpp"
+#include "master/placement.hpp"
+
+#include "tests/mesos.hpp"
+
+using namespace mesos;
+using namespace mesos::internal;
+using namespace mesos::internal::tests;
+
+using mesos::internal::master::allocator::AllocatorProcess;
+using mesos::internal::master::allocator::HierarchicalDRFAllocatorProcess;
+using mesos::internal::master::allocator::HierarchicalDRFPackAllocatorProcess;
+using mesos::internal::master::allocator::HierarchicalDRFSpreadAllocatorProcess;
+using mesos::internal::master::allocator::PackPlacement;
+using mesos::internal::master::allocator::Placement;
+using mesos::internal::master::allocator::SpreadPlacement;
+
+using mesos::internal::master::Master;
+
+using mesos::internal::slave::Slave;
+
+using process::Future;
+using process::PID;
+
+using std::string;
+using std::vector;
+
+using testing::_;
+using testing::Return;
+
+
+static SlaveID slaveId(const std::string& value)
+{
+  SlaveID slaveId;
+  slaveId.set_value(value);
+  return slaveId;
+}
+
+
+// Adds slaves 'a' (idle), 'b' (half used) and 'c' (all cpus used).
+static hashset<SlaveID> addSlaves(Placement* placement)
+{
+  Resources total = Resources::parse("cpus:4;mem:1024");
+
+  hashset<SlaveID> slaveIds;
+  slaveIds.insert(slaveId("a"));
+  slaveIds.insert(slaveId("b"));
+  slaveIds.insert(slaveId("c"));
+
+  foreach (const SlaveID& slaveId, slaveIds) {
+    placement->add(slaveId, total);
+  }
+
+  placement->update(slaveId("b"), Resources::parse("cpus:2;mem:512"));
+  placement->update(slaveId("c"), Resources::parse("cpus:0;mem:1024"));
+
+  return slaveIds;
+}
+
+
+TEST(PlacementTest, Spread)
+{
+  SpreadPlacement placement;
+  hashset<SlaveID> slaveIds = addSlaves(&placement);
+
+  vector<SlaveID> ordered = placement.sort(slaveIds);
+  ASSERT_EQ(3u, ordered.size());
+  EXPECT_EQ(slaveId("a"), ordered[0]);
+  EXPECT_EQ(slaveId("b"), ordered[1]);
+  EXPECT_EQ(slaveId("c"), ordered[2]);
+
+  hashmap<SlaveID, Resources> offerable;
+  offerable[slaveId("b")] = Resources::parse("cpus:2;mem:512");
+  EXPECT_FALSE(placement.enough(offerable, slaveId("a")));
+
+  placement.remove(slaveId("a"));
+  slaveIds.erase(slaveId("a"));
+
+  ordered = placement.sort(slaveIds);
+  ASSERT_EQ(2u, ordered.size());
+  EXPECT_EQ(slaveId("b"), ordered[0]);
+}
+
+
+TEST(PlacementTest, Pack)
+{
+  PackPlacement placement;
+  hashset<SlaveID> slaveIds = addSlaves(&placement);
+
+  vector<SlaveID> ordered = placement.sort(slaveIds);
+  ASSERT_EQ(3u, ordered.size());
+  EXPECT_EQ(slaveId("c"), ordered[0]);
+  EXPECT_EQ(slaveId("b"), ordered[1]);
+  EXPECT_EQ(slaveId("a"), ordered[2]);
+
+  // An idle slave only gets offered if nothing else is.
+  hashmap<SlaveID, Resources> offerable;
+  EXPECT_FALSE(placement.enough(offerable, slaveId("b")));
+  EXPECT_FALSE(placement.enough(offerable, slaveId("a")));
+
+  offerable[slaveId("b")] = Resources::parse("cpus:2;mem:512");
+  EXPECT_TRUE(placement.enough(offerable, slaveId("a")));
+
+  // Once its resources are back slave 'c' is idle again.
+  placement.update(slaveId("c"), Resources::parse("cpus:4;mem:1024"));
+  EXPECT_TRUE(placement.enough(offerable, slaveId("c")));
+
+  hashset<SlaveID> single;
+  single.insert(slaveId("b"));
+  ordered = placement.sort(single);
+  ASSERT_EQ(1u, ordered.size());
+  EXPECT_EQ(slaveId("b"), ordered[0]);
+}
+
+
+class PlacementAllocatorTest : public MesosTest
+{
+protected:
+  // Starts a master using 'allocator' and two idle slaves, then
+  // registers a framework and returns the offers it gets first.
+  void offers(AllocatorProcess* allocator, vector<Offer>* result)
+  {
+    Try<PID<Master> > master = StartMaster(allocator);
+    ASSERT_SOME(master);
+
+    for (int i = 0; i < 2; i++) {
+      Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+        FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+      slave::Flags flags = CreateSlaveFlags();
+      flags.resources = Option<string>("cpus:2;mem:1024;disk:0");
+
+      Try<PID<Slave> > slave = StartSlave(flags);
+      ASSERT_SOME(slave);
+
+      AWAIT_READY(slaveRegisteredMessage);
+    }
+
+    MockScheduler sched;
+    MesosSchedulerDriver driver(&sched, DEFAULT_FRAMEWORK_INFO, master.get());
+
+    EXPECT_CALL(sched, registered(&driver, _, _));
+
+    Future<vector<Offer> > offers;
+    EXPECT_CALL(sched, resourceOffers(&driver, _))
+      .WillOnce(FutureArg<1>(&offers))
+      .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+    driver.start();
+
+    AWAIT_READY(offers);
+    *result = offers.get();
+
+    driver.stop();
+    driver.join();
+
+    Shutdown();
+  }
+};
+
+
+// Tests that the allocator offers every idle slave by default.
+TEST_F(PlacementAllocatorTest, Default)
+{
+  HierarchicalDRFAllocatorProcess allocator;
+
+  vector<Offer> result;
+  ASSERT_NO_FATAL_FAILURE(offers(&allocator, &result));
+
+  EXPECT_EQ(2u, result.size());
+}
+
+
+// Tests that the allocator offers every idle slave with the spread
+// placement.
+TEST_F(PlacementAllocatorTest, Spread)
+{
+  HierarchicalDRFSpreadAllocatorProcess allocator;
+
+  vector<Offer> result;
+  ASSERT_NO_FATAL_FAILURE(offers(&allocator, &result));
+
+  EXPECT_EQ(2u, result.size());
+}
+
+
+// Tests that the allocator leaves an idle slave alone with the pack
+// placement when the framework is offered another one.
+TEST_F(PlacementAllocatorTest, Pack)
+{
+  HierarchicalDRFPackAllocatorProcess allocator;
+
+  vector<Offer> result;
+  ASSERT_NO_FATAL_FAILURE(offers(&allocator, &result));
+
+  EXPECT_EQ(1u, result.size());
+}
+
+
+// Tests that masters started for tests use the placement flag.
+TEST_F(PlacementAllocatorTest, Flag)
+{
+  master::Flags flags = CreateMasterFlags();
+  flags.placement = "pack";
+
+  ASSERT_SOME(StartMaster(flags));
+
+  Shutdown();
+
+  flags.placement = "unknown";
+
+  EXPECT_ERROR(StartMaster(flags));
+}
@@ -49,6 +49,7 @@
 #ifdef __linux__
 #include "slave/cgroups_isolator.hpp"
 #endif
+#include "slave/gc.hpp"
 #include "slave/paths.hpp"
 #include "slave/process_isolator.hpp"
 #include "slave/reaper.hpp"
@@ -129,6 +130,15 @@ public:
 
     return flags;
   }
+
+protected:
+  // Returns a future that is satisfied once the garbage collector
+  // has deleted some directories (i.e., dispatched '_remove', which
+  // is private to GarbageCollectorProcess).
+  Future<Nothing> futureRemove()
+  {
+    return FUTURE_DISPATCH(_, &GarbageCollectorProcess::_remove);
+  }
 };
 
 
@@ -1121,10 +1131,17 @@ TYPED_TEST(SlaveRecoveryTest, GCExecutor)
 
   AWAIT_READY(reregisterSlave);
 
+  // The directories get deleted asynchronously.
+  Future<Nothing> _remove = this->futureRemove();
+
   Clock::advance(flags.gc_delay);
 
   Clock::settle();
 
+  AWAIT_READY(_remove);
+
+  Clock::settle(); // Wait for GarbageCollectorProcess::_remove to complete.
+
   // Executor's work and meta directories should be gc'ed by now.
   ASSERT_FALSE(os::exists(paths::getExecutorPath(
       flags.work_dir, slaveId, frameworkId, executorId)));
@@ -125,3 +125,74 @@ TEST(SorterTest, DRFSorter)
 
   checkSorter(sorter, 5, "e", "b", "d", "c", "f");
 }
+
+
+TEST(SorterTest, WeightsAndQuotas)
+{
+  DRFSorter sorter;
+
+  sorter.add(Resources::parse("cpus:100;mem:100"));
+
+  sorter.add("a");
+  sorter.allocated("a", Resources::parse("cpus:20;mem:10"));
+
+  sorter.add("b");
+  sorter.allocated("b", Resources::parse("cpus:10;mem:30"));
+
+  // shares: a = .2, b = .3
+  checkSorter(sorter, 2, "a", "b");
+
+  sorter.weight("b", 2);
+
+  // shares: a = .2, b = .3 / 2 = .15
+  checkSorter(sorter, 2, "b", "a");
+
+  sorter.add("c");
+  sorter.allocated("c", Resources::parse("cpus:1;mem:1"));
+  sorter.quota("a", Resources::parse("cpus:30"));
+
+  // a is below its quota, so it comes first no matter its share.
+  // shares: a = .2, b = .15, c = .01
+  checkSorter(sorter, 3, "a", "c", "b");
+
+  sorter.allocated("a", Resources::parse("cpus:10"));
+
+  // shares: a = .3, b = .15, c = .01
+  checkSorter(sorter, 3, "c", "b", "a");
+
+  sorter.add(Resources::parse("mem:100"));
+  // total resources is now cpus = 100, mem = 200
+
+  // shares: a = .3, b = .15 / 2 = .075, c = .01
+  checkSorter(sorter, 3, "c", "b", "a");
+
+  sorter.remove(Resources::parse("cpus:90"));
+  // total resources is now cpus = 10, mem = 200
+
+  // shares: a = 3, b = 1 / 2 = .5, c = .1
+  checkSorter(sorter, 3, "c", "b", "a");
+
+  sorter.weight("b", 1);
+  sorter.weight("c", 0.05);
+
+  // shares: a = 3, b = 1, c = .1 / .05 = 2
+  checkSorter(sorter, 3, "b", "c", "a");
+
+  // Deactivated clients keep their weight.
+  sorter.deactivate("c");
+  checkSorter(sorter, 2, "b", "a");
+  sorter.activate("c");
+  checkSorter(sorter, 3, "b", "c", "a");
+
+  // Activating an active client doesn't add it twice.
+  sorter.activate("c");
+  checkSorter(sorter, 3, "b", "c", "a");
+
+  // A weight given while deactivated applies once activated again.
+  sorter.deactivate("a");
+  sorter.weight("a", 10);
+  sorter.activate("a");
+
+  // shares: a = 3 / 10 = .3, b = 1, c = 2
+  checkSorter(sorter, 3, "a", "b", "c");
+}
@@ -34,8 +34,11 @@
 #include <stout/os.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/result.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/try.hpp>
 
+#include "common/protobuf_utils.hpp"
+
 #include "master/master.hpp"
 
 #include "slave/constants.hpp"
@@ -666,3 +669,35 @@ TEST_F(StatusUpdateManagerTest, DuplicateTerminalUpdateAfterAck)
 
   Shutdown();
 }
+
+
+// Benchmarks creating status updates, which happens for every task
+// state transition.
+TEST(StatusUpdateTest, Create)
+{
+  FrameworkID frameworkId;
+  frameworkId.set_value("framework");
+
+  SlaveID slaveId;
+  slaveId.set_value("slave");
+
+  TaskID taskId;
+  taskId.set_value("task");
+
+  const int iterations = 100000;
+
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  for (int i = 0; i < iterations; i++) {
+    StatusUpdate update = internal::protobuf::createStatusUpdate(
+        frameworkId, slaveId, taskId, TASK_RUNNING);
+
+    ASSERT_EQ(16u, update.uuid().size());
+  }
+
+  stopwatch.stop();
+
+  std::cout << "Created " << iterations << " status updates in "
+            << stopwatch.elapsed() << std::endl;
+}